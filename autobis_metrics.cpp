@@ -0,0 +1,148 @@
+#include "autobis_metrics.h"
+
+#include <algorithm>
+#include <sstream>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+// Index of the highest bit set; value must not be 0:
+static uint32 HighestBit(uint64 value)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    uint32 index = 0;
+    while (value >>= 1)
+        ++index;
+    return index;
+#endif
+}
+
+uint32 AbLatencyHistogram::BucketOf(uint64 micros)
+{
+    if (micros < 4)
+        return uint32(micros);
+    uint32 log2 = HighestBit(micros);
+    uint32 bucket = 4 * (log2 - 1) + uint32((micros >> (log2 - 2)) & 3);
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+uint64 AbLatencyHistogram::BucketLowerBound(uint32 bucket)
+{
+    if (bucket < 4)
+        return bucket;
+    return uint64(4 + bucket % 4) << (bucket / 4 - 1);
+}
+
+void AbLatencyHistogram::Record(uint64 micros)
+{
+    _buckets[BucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(micros, std::memory_order_relaxed);
+    uint64 max = _max.load(std::memory_order_relaxed);
+    while (micros > max && !_max.compare_exchange_weak(max, micros, std::memory_order_relaxed))
+        ;
+}
+
+AbLatencyHistogram::Summary AbLatencyHistogram::Summarize() const
+{
+    Summary summary;
+    uint64 counts[BUCKETS];
+    for (uint32 bucket = 0; bucket < BUCKETS; ++bucket) {
+        counts[bucket] = _buckets[bucket].load(std::memory_order_relaxed);
+        summary.count += counts[bucket];
+    }
+    summary.max = _max.load(std::memory_order_relaxed);
+    if (!summary.count)
+        return summary;
+    summary.mean = _sum.load(std::memory_order_relaxed) / summary.count;
+    // Report the upper end of the bucket each percentile falls in, but never more than the max actually seen:
+    uint64 seen = 0;
+    uint64* targets[3] = { &summary.p50, &summary.p95, &summary.p99 };
+    double const fractions[3] = { 0.50, 0.95, 0.99 };
+    uint32 next = 0;
+    for (uint32 bucket = 0; bucket < BUCKETS && next < 3; ++bucket) {
+        seen += counts[bucket];
+        while (next < 3 && seen >= fractions[next] * summary.count) {
+            uint64 upper = bucket + 1 < BUCKETS ? BucketLowerBound(bucket + 1) - 1 : summary.max;
+            *targets[next++] = std::min(upper, summary.max);
+        }
+    }
+    return summary;
+}
+
+void AbLatencyHistogram::Reset()
+{
+    for (std::atomic<uint64> &bucket : _buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+void AbMetrics::Reset()
+{
+    for (std::atomic<uint64> &counter : _counters)
+        counter.store(0, std::memory_order_relaxed);
+    for (AbLatencyHistogram &phase : _phases)
+        phase.Reset();
+}
+
+char const* AbMetrics::PhaseName(AbMetricPhase phase)
+{
+    switch (phase) {
+        case AB_PHASE_REQUEST:          return "request";
+        case AB_PHASE_HAVE_SCAN:        return "have-scan";
+        case AB_PHASE_CANDIDATES:       return "candidates";
+        case AB_PHASE_SCORING:          return "scoring";
+        case AB_PHASE_RANDOM_ENCHANT:   return "random-enchant";
+        case AB_PHASE_SELECT:           return "select";
+        case AB_PHASE_GRANTS:           return "grants";
+        case AB_PHASE_SLICED_TICK:      return "sliced-tick";
+        default:                        return "?";
+    }
+}
+
+char const* AbMetrics::CounterName(AbMetricCounter counter)
+{
+    switch (counter) {
+        case AB_COUNTER_REQUESTS:               return "requests";
+        case AB_COUNTER_ITEMS_SCORED:           return "items scored";
+        case AB_COUNTER_RANDOM_ENCHANTS:        return "random enchants";
+        case AB_COUNTER_ITEMS_GRANTED:          return "items granted";
+        case AB_COUNTER_GRANTS_REJECTED:        return "grants rejected";
+        case AB_COUNTER_DB_QUERIES:             return "db queries";
+        case AB_COUNTER_BIS_TABLE_HITS:         return "bis table hits";
+        case AB_COUNTER_BIS_TABLE_MISSES:       return "bis table misses";
+        case AB_COUNTER_OWNED_INDEX_HITS:       return "owned index hits";
+        case AB_COUNTER_OWNED_INDEX_REBUILDS:   return "owned index rebuilds";
+        case AB_COUNTER_RANKINGS_COMPUTED:      return "rankings computed";
+        case AB_COUNTER_RANKINGS_COALESCED:     return "rankings coalesced";
+        case AB_COUNTER_SLICES:                 return "slices";
+        case AB_COUNTER_SLICE_BUDGET_EXHAUSTED: return "slice budget exhausted";
+        default:                                return "?";
+    }
+}
+
+void AbMetrics::Report(std::vector<std::string> &lines) const
+{
+    std::ostringstream out;
+    for (uint32 phase = 0; phase < MAX_AB_PHASES; ++phase) {
+        AbLatencyHistogram::Summary summary = Summarize(AbMetricPhase(phase));
+        if (!summary.count)
+            continue;
+        out.str("");
+        out << PhaseName(AbMetricPhase(phase)) << ": n=" << summary.count << " mean=" << summary.mean
+            << "us p50=" << summary.p50 << "us p95=" << summary.p95 << "us p99=" << summary.p99
+            << "us max=" << summary.max << "us";
+        lines.push_back(out.str());
+    }
+    out.str("");
+    for (uint32 counter = 0; counter < MAX_AB_COUNTERS; ++counter)
+        out << (counter ? ", " : "") << CounterName(AbMetricCounter(counter)) << " " << Get(AbMetricCounter(counter));
+    lines.push_back(out.str());
+}
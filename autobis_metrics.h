@@ -0,0 +1,104 @@
+#ifndef __AUTOBIS_METRICS_H__
+#define __AUTOBIS_METRICS_H__
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Define.h"
+
+enum AbMetricPhase {
+    AB_PHASE_REQUEST,           // from StartRequest() to the grants being handed out, queueing on workers included
+    AB_PHASE_HAVE_SCAN,         // what the player owns
+    AB_PHASE_CANDIDATES,        // which catalog items the player can use
+    AB_PHASE_SCORING,           // ranking the candidates (or reading them from the BiS table)
+    AB_PHASE_RANDOM_ENCHANT,    // best random enchants of one ranked slot's items (see AB_COUNTER_RANDOM_ENCHANTS)
+    AB_PHASE_SELECT,
+    AB_PHASE_GRANTS,
+    AB_PHASE_SLICED_TICK,       // time-sliced requests' share of one world tick (see AutoBis.TimeSlice.BudgetUs)
+    MAX_AB_PHASES
+};
+
+enum AbMetricCounter {
+    AB_COUNTER_REQUESTS,
+    AB_COUNTER_ITEMS_SCORED,
+    AB_COUNTER_RANDOM_ENCHANTS,         // best random enchants of ranked items (see AB_PHASE_RANDOM_ENCHANT)
+    AB_COUNTER_ITEMS_GRANTED,
+    AB_COUNTER_GRANTS_REJECTED,     // requests whose items didn't all fit; none of them were handed out
+    AB_COUNTER_DB_QUERIES,
+    AB_COUNTER_BIS_TABLE_HITS,
+    AB_COUNTER_BIS_TABLE_MISSES,    // no table for the profile, or the top K wasn't deep enough
+    AB_COUNTER_OWNED_INDEX_HITS,
+    AB_COUNTER_OWNED_INDEX_REBUILDS,
+    AB_COUNTER_RANKINGS_COMPUTED,
+    AB_COUNTER_RANKINGS_COALESCED,      // rankings a request got from another one in flight, instead of computing them
+    AB_COUNTER_SLICES,                  // steps of time-sliced requests
+    AB_COUNTER_SLICE_BUDGET_EXHAUSTED,  // ticks that ran out of budget with time-sliced requests left
+    MAX_AB_COUNTERS
+};
+
+// Log-linear histogram of microseconds: four buckets per power of two, so any percentile is off by 25% at most.
+class AbLatencyHistogram {
+    public:
+        static constexpr uint32 BUCKETS = 160;
+        struct Summary {
+            uint64 count = 0;
+            uint64 mean = 0;
+            uint64 p50 = 0;
+            uint64 p95 = 0;
+            uint64 p99 = 0;
+            uint64 max = 0;
+        };
+        void Record(uint64 micros);
+        Summary Summarize() const;
+        void Reset();
+    private:
+        static uint32 BucketOf(uint64 micros);
+        static uint64 BucketLowerBound(uint32 bucket);
+
+        std::atomic<uint64> _buckets[BUCKETS] = { };
+        std::atomic<uint64> _sum{0};
+        std::atomic<uint64> _max{0};
+};
+
+// Counters and per-phase latencies for AutoBis. Everything is a relaxed atomic, so the world thread, workers and map
+//  threads can all record without ever blocking one another; a report is only roughly consistent across metrics.
+class AbMetrics {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        void Add(AbMetricCounter counter, uint64 value = 1)
+        {
+            _counters[counter].fetch_add(value, std::memory_order_relaxed);
+        }
+        uint64 Get(AbMetricCounter counter) const { return _counters[counter].load(std::memory_order_relaxed); }
+        void Record(AbMetricPhase phase, Clock::time_point started)
+        {
+            _phases[phase].Record(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started).count());
+        }
+        AbLatencyHistogram::Summary Summarize(AbMetricPhase phase) const { return _phases[phase].Summarize(); }
+        void Reset();
+
+        static char const* PhaseName(AbMetricPhase phase);
+        static char const* CounterName(AbMetricCounter counter);
+        // One line per phase that saw any samples, then one with the counters:
+        void Report(std::vector<std::string> &lines) const;
+    private:
+        std::atomic<uint64> _counters[MAX_AB_COUNTERS] = { };
+        AbLatencyHistogram _phases[MAX_AB_PHASES];
+};
+
+// Records the time from its construction to its destruction:
+class AbPhaseTimer {
+    public:
+        AbPhaseTimer(AbMetrics &metrics, AbMetricPhase phase) : _metrics(metrics), _phase(phase),
+            _started(AbMetrics::Clock::now()) { }
+        ~AbPhaseTimer() { _metrics.Record(_phase, _started); }
+    private:
+        AbMetrics &_metrics;
+        AbMetricPhase _phase;
+        AbMetrics::Clock::time_point _started;
+};
+
+#endif
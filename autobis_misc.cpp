@@ -1,15 +1,57 @@
+#include "autobis_metrics.h"
 #include "autobis_misc.h"
+#include "autobis_pawn.h"
+#include "autobis_scheduler.h"
+#include "autobis_weights.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <list>
 #include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <direct.h>
+#endif
 
 #include "Bag.h"
+#include "Config.h"
 #include "DatabaseEnv.h"
+#include "Group.h"
+#include "ObjectAccessor.h"
 #include "ObjectMgr.h"
+#include "ScriptMgr.h"
+#include "World.h"
 #include "WorldSession.h"
+#include "Spell.h"
 #include "SpellMgr.h"
 #include "DBCStores.h"
 #include "DBCStructure.h"
 
+// Where the time goes; see ".autobis stats":
+static AbMetrics abMetrics;
+
 // NOTE: some items have "Equip: Increase your X by Y". We need to map those auras to ITEM_MODs for the stat calc.
 //  If we're not calculating a specific stat, set RHS to INT_MIN.
 // FIXME: Is there a "smarter" way of doing this that uses code written prior? I'm having to manually encode the mappings here...
@@ -63,7 +105,7 @@ static int32 ModRatingToItemMod(const SpellEffectInfo& sei)
     }
     return INT_MIN;
 }
-int32 SpellEffectInfoToItemMod(const SpellEffectInfo& sei)
+int32 SpellEffectInfoToItemMod(const SpellEffectInfo& sei, bool* unknownAura)
 {
     if (sei.Effect != 6)
         return INT_MIN;
@@ -101,184 +143,455 @@ int32 SpellEffectInfoToItemMod(const SpellEffectInfo& sei)
         case SPELL_AURA_MOD_SHIELD_BLOCKVALUE:
             return ITEM_MOD_BLOCK_VALUE;
         default: {
-            printf("FIXME: ApplyAuraName=%d not found.\n", sei.ApplyAuraName);
+            // FIXME: reported once per aura by AbServerScoreData::LoadEquipSpellStats():
+            if (unknownAura)
+                *unknownAura = true;
             return INT_MIN;
         }
     }
 }
 
-// https://github.com/Road-block/Pawn/blob/master/Wowhead.lua
-//  I subtract 20 from HIT_RATING because we tend to get flooded with hit rating, overcapping the 8% limit...
-static const AutoBis::ScoreWeightMap ret_paladin_map = {
-    {-1, 470}, // melee_DPS
-    {ITEM_MOD_HIT_RATING, 70},
-    {ITEM_MOD_STRENGTH, 80},
-    {ITEM_MOD_EXPERTISE_RATING, 66},
-    {ITEM_MOD_CRIT_RATING, 40},
-    {ITEM_MOD_ATTACK_POWER, 34},
-    {ITEM_MOD_AGILITY, 32},
-    {ITEM_MOD_HASTE_RATING, 30},
-    {ITEM_MOD_ARMOR_PENETRATION_RATING, 22},
-    {ITEM_MOD_SPELL_POWER, 9},
-    {ITEM_MOD_STAMINA, 0.1},
-    {-2, 0.01}, // armor
-    {-3, 0.0001}, // ranged_DPS
-};
+// Every weight table in use: the built-in ones, followed by whatever was loaded from AutoBis.Profiles.Path. A set is
+//  immutable once published; ".autobis reload" just publishes a new one. Anything that keeps using a profile holds a
+//  shared_ptr to it (aliasing the set; see GetWeightProfile()), so a set is freed with the last request using it.
+//
+// Profile ids are unique across every set ever published (the built-in ones keep theirs), so the score cache, the
+//  precomputed best enchants and the owned item index can never mix up profiles from two different sets.
+struct AbProfileSet {
+    // Built-in tables first, in AbProfileId order:
+    std::vector<AbWeightProfile> profiles;
+    std::deque<std::string> names;  // storage for the loaded profiles' names
+    // What GetWeightProfile() hands out, per AbProfileId; points into "profiles":
+    std::array<AbWeightProfile const*, MAX_AB_PROFILES> roles{};
+    std::string source;
 
-static const AutoBis::ScoreWeightMap prot_paladin_map = {
-    {ITEM_MOD_STAMINA, 100},
-    {ITEM_MOD_AGILITY, 60},
-    {ITEM_MOD_EXPERTISE_RATING, 59},
-    {ITEM_MOD_DODGE_RATING, 55},
-    {ITEM_MOD_DEFENSE_SKILL_RATING, 45},
-    {ITEM_MOD_PARRY_RATING, 30},
-    {ITEM_MOD_STRENGTH, 16},
-    {-2, 8}, // armor
-    {ITEM_MOD_BLOCK_RATING, 7},
-    {ITEM_MOD_BLOCK_VALUE, 6},
-    {-1, 0.00001}, // melee_DPS
+    AbWeightProfile const* Find(std::string const& name) const
+    {
+        for (AbWeightProfile const& profile : profiles) {
+            if (name == profile.name)
+                return &profile;
+        }
+        return nullptr;
+    }
 };
 
-static const AutoBis::ScoreWeightMap fury_warrior_map = {
-    {ITEM_MOD_EXPERTISE_RATING, 100},
-    {ITEM_MOD_STRENGTH, 82},
-    {ITEM_MOD_CRIT_RATING, 66},
-    {ITEM_MOD_AGILITY, 53},
-    {ITEM_MOD_ARMOR_PENETRATION_RATING, 52},
-    {ITEM_MOD_HIT_RATING, 48},
-    {ITEM_MOD_HASTE_RATING, 36},
-    {ITEM_MOD_ATTACK_POWER, 31},
-    {-2, 5}, // armor
-    {ITEM_MOD_STAMINA, 0.1},
-    {-1, 0.01}, // melee_DPS
-    {-3, 0.0001}, // ranged_DPS
-};
+// Only ever accessed through std::atomic_load()/std::atomic_store():
+static std::shared_ptr<AbProfileSet const> abProfiles;
+static std::atomic<uint32> abNextProfileId{MAX_AB_PROFILES};
 
-static const AutoBis::ScoreWeightMap combat_rogue_map = {
-    {-1, 220}, // melee_DPS
-    {ITEM_MOD_ARMOR_PENETRATION_RATING, 100},
-    {ITEM_MOD_AGILITY, 100},
-    {ITEM_MOD_EXPERTISE_RATING, 82},
-    {ITEM_MOD_HIT_RATING, 80},
-    {ITEM_MOD_CRIT_RATING, 75},
-    {ITEM_MOD_HASTE_RATING, 73},
-    {ITEM_MOD_STRENGTH, 55},
-    {ITEM_MOD_ATTACK_POWER, 50},
-    {ITEM_MOD_STAMINA, 0.1},
-    {-2, 0.01}, // armor
-    {-3, 0.0001}, // ranged_DPS
-};
+// The built-in tables, plus every scale in "scales" (if any):
+static std::shared_ptr<AbProfileSet> BuildProfileSet(std::vector<AbPawnScale> const& scales, std::string const& source)
+{
+    std::shared_ptr<AbProfileSet> set = std::make_shared<AbProfileSet>();
+    set->source = source;
+    set->profiles.reserve(MAX_AB_PROFILES + scales.size());
+    set->profiles.assign(abWeightProfiles, abWeightProfiles + MAX_AB_PROFILES);
+    for (AbPawnScale const& scale : scales) {
+        set->names.push_back(scale.name);
+        set->profiles.push_back(AbCompileWeightProfile(scale.weights, abNextProfileId.fetch_add(1),
+                                                       set->names.back().c_str()));
+    }
+    for (uint32 role = 0; role < MAX_AB_PROFILES; ++role) {
+        std::string name = sConfigMgr->GetStringDefault(
+            std::string("AutoBis.Profiles.Role.") + abWeightProfiles[role].name, abRoleScaleNames[role]);
+        AbWeightProfile const* profile = set->Find(name);
+        set->roles[role] = profile ? profile : &set->profiles[role];
+    }
+    return set;
+}
 
-static const AutoBis::ScoreWeightMap frost_mage_map = {
-    {ITEM_MOD_HIT_RATING, 80},
-    {ITEM_MOD_HASTE_RATING, 42},
-    {ITEM_MOD_SPELL_POWER, 39},
-    {ITEM_MOD_CRIT_RATING, 19},
-    {ITEM_MOD_INTELLECT, 6},
-    {ITEM_MOD_STAMINA, 0.1},
-    {-1, 0.0001}, // melee_DPS
-    {-2, 0.0001}, // armor
-    {-3, 0.0001}, // ranged_DPS
-};
+// return: false if the file can't be read or has any syntax error; "errors" then says why:
+static bool LoadPawnScales(std::string const& path, std::vector<AbPawnScale> &scales, std::vector<std::string> &errors,
+                           std::vector<std::string> &ignored)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        errors.push_back("can't open " + path);
+        return false;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    return AbParsePawnScales(text.str(), scales, errors, ignored);
+}
 
-static const AutoBis::ScoreWeightMap bm_hunter_map = {
-    {-3, 213}, // ranged_DPS
-    {ITEM_MOD_HIT_RATING, 80},
-    {ITEM_MOD_AGILITY, 58},
-    {ITEM_MOD_CRIT_RATING, 40},
-    {ITEM_MOD_INTELLECT, 37},
-    {ITEM_MOD_ATTACK_POWER, 30},
-    {ITEM_MOD_ARMOR_PENETRATION_RATING, 28},
-    {ITEM_MOD_HASTE_RATING, 21},
-    {ITEM_MOD_STAMINA, 0.1},
-    {-1, 0.0001}, // melee_DPS
-    {-2, 0.0001}, // armor
-};
+static std::shared_ptr<AbProfileSet const> CurrentProfiles()
+{
+    return std::atomic_load(&abProfiles);
+}
 
-static const AutoBis::ScoreWeightMap boomkin_map = {
-    {ITEM_MOD_HIT_RATING, 80},
-    {ITEM_MOD_SPELL_POWER, 66},
-    {ITEM_MOD_HASTE_RATING, 54},
-    {ITEM_MOD_CRIT_RATING, 43},
-    {ITEM_MOD_SPIRIT, 22},
-    {ITEM_MOD_INTELLECT, 22},
-    {ITEM_MOD_STAMINA, 0.1},
-    {-1, 0.0001}, // melee_DPS
-    {-2, 0.0001}, // armor
-    {-3, 0.0001}, // ranged_DPS
-};
+//
+// Picks the weight table from a player's talents: the tree with the most points decides, and a few key talents tell
+//  feral tanks from cats. Players with no points spent get their class' default table.
+//
+// Talents only change when they're learned or reset (and the default depends on the level), so the result is cached
+//  per character and per talent spec; a dual-spec swap just reads the other entry. The cache holds an AbProfileId
+//  rather than a profile, so a reload of the weight tables doesn't invalidate it.
+class AbSpecResolver {
+    public:
+        // Indexes the talents of every class; called once at startup:
+        void Load();
+        // AbProfileId for the player's active spec:
+        uint32 GetRole(Player *player);
+        // Call whenever the player's talents, level or active spec change:
+        void Forget(ObjectGuid const& guid);
+    private:
+        struct Talent {
+            uint8 tab;                                  // TalentTabEntry::OrderIndex
+            std::array<uint32, MAX_TALENT_RANK> ranks;  // spell of each rank, 0 past the last one
+        };
+        uint32 Resolve(Player *player, uint8 spec) const;
+        // One slot per player, picked by GUID counter: the counter in the low 32 bits, then one byte per spec holding
+        //  its role + 1 (0 = not resolved yet). Being a single word, a hit is one relaxed load and no lock; slots are
+        //  only written under _lock. Two players sharing a slot just take turns missing.
+        static constexpr uint32 SLOTS = 1 << 14;
+        static uint32 RoleShift(uint8 spec) { return 32 + 8 * spec; }
+        std::atomic<uint64>& SlotOf(uint32 counter) { return _slots[counter % SLOTS]; }
 
-static const AutoBis::ScoreWeightMap cat_druid_map = {
-    {ITEM_MOD_AGILITY, 100},
-    {ITEM_MOD_ARMOR_PENETRATION_RATING, 90},
-    {ITEM_MOD_STRENGTH, 80},
-    {ITEM_MOD_CRIT_RATING, 55},
-    {ITEM_MOD_EXPERTISE_RATING, 50},
-    {ITEM_MOD_HIT_RATING, 50},
-    {ITEM_MOD_ATTACK_POWER, 40},
-    {ITEM_MOD_HASTE_RATING, 35},
-    {ITEM_MOD_STAMINA, 0.1},
-    {-1, 0.01}, // melee_DPS
-    {-2, 0.0001}, // armor
-    {-3, 0.0001}, // ranged_DPS
+        std::array<std::vector<Talent>, MAX_CLASSES> _talents;
+        std::array<std::atomic<uint64>, SLOTS> _slots{};
+        std::mutex _lock;
+        uint32 _epoch = 0; // bumped by Forget(), so a Resolve() that raced it isn't cached
 };
+static_assert(MAX_TALENT_SPECS <= 4 && MAX_AB_PROFILES < 0xFF, "AbSpecResolver slots are too small");
 
-static const AutoBis::ScoreWeightMap enh_shaman_map = {
-    {-1, 135}, // melee_DPS
-    {ITEM_MOD_HIT_RATING, 70},
-    {ITEM_MOD_EXPERTISE_RATING, 84},
-    {ITEM_MOD_AGILITY, 55},
-    {ITEM_MOD_INTELLECT, 55},
-    {ITEM_MOD_CRIT_RATING, 55},
-    {ITEM_MOD_HASTE_RATING, 42},
-    {ITEM_MOD_STRENGTH, 35},
-    {ITEM_MOD_ATTACK_POWER, 32},
-    {ITEM_MOD_SPELL_POWER, 29},
-    {ITEM_MOD_ARMOR_PENETRATION_RATING, 26},
-    {ITEM_MOD_STAMINA, 0.1},
-    {-2, 0.01}, // armor
-    {-3, 0.0001}, // ranged_DPS
+static AbSpecResolver abSpecResolver;
+
+// Per class, the table for each talent tree, in TalentTabEntry::OrderIndex order:
+static const AbProfileId abTalentTreeRoles[MAX_CLASSES][MAX_TALENT_TABS] = {
+    { AB_PROFILE_RET_PALADIN,           AB_PROFILE_RET_PALADIN,     AB_PROFILE_RET_PALADIN },
+    { AB_PROFILE_FURY_WARRIOR,          AB_PROFILE_FURY_WARRIOR,    AB_PROFILE_PROT_WARRIOR },   // Warrior
+    { AB_PROFILE_HOLY_PALADIN,          AB_PROFILE_PROT_PALADIN,    AB_PROFILE_RET_PALADIN },    // Paladin
+    { AB_PROFILE_BM_HUNTER,             AB_PROFILE_BM_HUNTER,       AB_PROFILE_BM_HUNTER },      // Hunter
+    { AB_PROFILE_COMBAT_ROGUE,          AB_PROFILE_COMBAT_ROGUE,    AB_PROFILE_COMBAT_ROGUE },   // Rogue
+    { AB_PROFILE_DISC_PRIEST,           AB_PROFILE_HOLY_PRIEST,     AB_PROFILE_SHADOW_PRIEST },  // Priest
+    { AB_PROFILE_BLOOD_DK,              AB_PROFILE_FROST_DK,        AB_PROFILE_UNHOLY_DK },      // Death Knight
+    { AB_PROFILE_ELE_SHAMAN,            AB_PROFILE_ENH_SHAMAN,      AB_PROFILE_RESTO_SHAMAN },   // Shaman
+    { AB_PROFILE_FROST_MAGE,            AB_PROFILE_FROST_MAGE,      AB_PROFILE_FROST_MAGE },     // Mage
+    { AB_PROFILE_AFFLICTION_WARLOCK,    AB_PROFILE_DESTRO_WARLOCK,  AB_PROFILE_DESTRO_WARLOCK }, // Warlock
+    { AB_PROFILE_RET_PALADIN,           AB_PROFILE_RET_PALADIN,     AB_PROFILE_RET_PALADIN },
+    { AB_PROFILE_BOOMKIN,               AB_PROFILE_CAT_DRUID,       AB_PROFILE_RESTO_DRUID },    // Druid
 };
 
-static const AutoBis::ScoreWeightMap shadow_priest_map = {
-    {ITEM_MOD_HIT_RATING, 80},
-    {ITEM_MOD_SPELL_POWER, 76},
-    {ITEM_MOD_CRIT_RATING, 54},
-    {ITEM_MOD_HASTE_RATING, 50},
-    {ITEM_MOD_SPIRIT, 16},
-    {ITEM_MOD_INTELLECT, 16},
-    {ITEM_MOD_STAMINA, 0.1},
-    {-1, 0.0001}, // melee_DPS
-    {-2, 0.0001}, // armor
-    {-3, 0.0001}, // ranged_DPS
+// First ranks of the feral talents only a bear (Survival of the Fittest, Natural Reaction, Protector of the Pack),
+//  or only a cat (Shredding Attacks, Predatory Instincts), would take:
+static const uint32 abBearTalents[] = { 33853, 57878, 57873 };
+static const uint32 abCatTalents[] = { 16966, 33859 };
+
+void AbSpecResolver::Load()
+{
+    for (std::vector<Talent> &talents : _talents)
+        talents.clear();
+    uint32 count = 0;
+    for (uint32 idx = 0; idx < sTalentStore.GetNumRows(); ++idx) {
+        TalentEntry const* talentInfo = sTalentStore.LookupEntry(idx);
+        if (!talentInfo)
+            continue;
+        TalentTabEntry const* tabInfo = sTalentTabStore.LookupEntry(talentInfo->TabID);
+        if (!tabInfo || !tabInfo->ClassMask || tabInfo->OrderIndex >= MAX_TALENT_TABS)
+            continue; // pet talents
+        Talent talent;
+        talent.tab = uint8(tabInfo->OrderIndex);
+        for (uint32 rank = 0; rank < MAX_TALENT_RANK; ++rank)
+            talent.ranks[rank] = talentInfo->SpellRank[rank];
+        for (uint32 classId = 1; classId < MAX_CLASSES; ++classId) {
+            if (tabInfo->ClassMask & (1 << (classId - 1))) {
+                _talents[classId].push_back(talent);
+                ++count;
+            }
+        }
+    }
+    printf("AutoBis: indexed %u class talents.\n", count);
+}
+
+uint32 AbSpecResolver::Resolve(Player *player, uint8 spec) const
+{
+    uint8 classId = player->GetClass();
+    if (classId >= MAX_CLASSES)
+        return AB_PROFILE_RET_PALADIN;
+    std::array<uint32, MAX_TALENT_TABS> points{};
+    uint32 bear = 0, cat = 0;
+    for (Talent const& talent : _talents[classId]) {
+        uint32 rank = MAX_TALENT_RANK;
+        while (rank > 0 && (!talent.ranks[rank - 1] || !player->HasTalent(talent.ranks[rank - 1], spec)))
+            --rank;
+        if (!rank)
+            continue;
+        points[talent.tab] += rank;
+        if (std::find(std::begin(abBearTalents), std::end(abBearTalents), talent.ranks[0]) != std::end(abBearTalents))
+            bear += rank;
+        if (std::find(std::begin(abCatTalents), std::end(abCatTalents), talent.ranks[0]) != std::end(abCatTalents))
+            cat += rank;
+    }
+    uint32 tree = std::max_element(points.begin(), points.end()) - points.begin();
+    if (!points[tree]) {
+        // Nothing spent yet:
+        switch (classId) {
+            case CLASS_WARRIOR:         return AB_PROFILE_FURY_WARRIOR;
+            case CLASS_HUNTER:          return AB_PROFILE_BM_HUNTER;
+            case CLASS_ROGUE:           return AB_PROFILE_COMBAT_ROGUE;
+            case CLASS_PRIEST:          return AB_PROFILE_SHADOW_PRIEST;
+            case CLASS_DEATH_KNIGHT:    return AB_PROFILE_FROST_DK;
+            case CLASS_SHAMAN:          return AB_PROFILE_ENH_SHAMAN;
+            case CLASS_MAGE:            return AB_PROFILE_FROST_MAGE;
+            case CLASS_WARLOCK:         return AB_PROFILE_AFFLICTION_WARLOCK;
+            case CLASS_DRUID:           return player->GetLevel() < 10 ? AB_PROFILE_BOOMKIN : AB_PROFILE_CAT_DRUID;
+            default:                    return AB_PROFILE_RET_PALADIN;
+        }
+    }
+    if (classId == CLASS_DRUID && abTalentTreeRoles[classId][tree] == AB_PROFILE_CAT_DRUID && bear > cat)
+        return AB_PROFILE_BEAR_DRUID;
+    return abTalentTreeRoles[classId][tree];
+}
+
+uint32 AbSpecResolver::GetRole(Player *player)
+{
+    uint8 spec = std::min<uint8>(player->GetActiveSpec(), MAX_TALENT_SPECS - 1);
+    uint32 counter = player->GetGUID().GetCounter();
+    std::atomic<uint64> &slot = SlotOf(counter);
+    uint64 packed = slot.load(std::memory_order_relaxed);
+    if (uint32(packed) == counter) {
+        if (uint32 role = (packed >> RoleShift(spec)) & 0xFF)
+            return role - 1;
+    }
+    uint32 epoch;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        epoch = _epoch;
+    }
+    uint32 role = Resolve(player, spec);
+    std::lock_guard<std::mutex> guard(_lock);
+    if (epoch != _epoch)
+        return role;
+    packed = slot.load(std::memory_order_relaxed);
+    if (uint32(packed) != counter)
+        packed = counter; // someone else's (or empty): take it over
+    packed = (packed & ~(uint64(0xFF) << RoleShift(spec))) | (uint64(role + 1) << RoleShift(spec));
+    slot.store(packed, std::memory_order_relaxed);
+    return role;
+}
+
+void AbSpecResolver::Forget(ObjectGuid const& guid)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    ++_epoch;
+    std::atomic<uint64> &slot = SlotOf(guid.GetCounter());
+    if (uint32(slot.load(std::memory_order_relaxed)) == guid.GetCounter())
+        slot.store(0, std::memory_order_relaxed);
+}
+
+std::shared_ptr<AbWeightProfile const> AutoBis::GetWeightProfile(Player *player)
+{
+    std::shared_ptr<AbProfileSet const> set = CurrentProfiles();
+    return std::shared_ptr<AbWeightProfile const>(set, set->roles[abSpecResolver.GetRole(player)]);
+}
+
+//
+// Per-character weight tables (".autobis weights"), kept in the characters database (autobis_weights). They're read
+//  asynchronously at login and written back in batches from OnUpdate(), so a request never waits on the database; a
+//  character whose weights haven't arrived yet simply gets their talent-based table.
+//
+// Compiled profiles live in a bounded LRU keyed by their normalized weights, so characters with the same weights (at
+//  any scale) share one. An evicted profile stays alive for as long as a request or the owned item index still uses
+//  it, and compiling it again gives it a new id, so nothing keyed by profile id can mix the two up.
+class AbCustomWeights {
+    public:
+        using ProfilePtr = std::shared_ptr<AbWeightProfile const>;
+
+        void LoadConfig();
+        // nullptr if the character has no weights of their own (or they haven't been loaded yet):
+        ProfilePtr GetProfile(ObjectGuid const& guid);
+        bool GetWeights(ObjectGuid const& guid, AutoBis::ScoreWeightMap &weights);
+        // Starts reading the player's weights; called at login:
+        void Load(Player *player);
+        void Set(ObjectGuid const& guid, AutoBis::ScoreWeightMap const& weights);
+        void Reset(ObjectGuid const& guid);
+        // Called at logout; writes that haven't been flushed yet are kept:
+        void Forget(ObjectGuid const& guid);
+        // Writes everything that changed since the last flush in one transaction, every AutoBis.Weights.FlushInterval:
+        void Update(uint32 diff);
+        void Flush();
+    private:
+        struct Weights {
+            bool loading = true;        // the query hasn't returned yet, and nothing was set since
+            AutoBis::ScoreWeightMap weights;
+            std::string key;            // of the compiled profile; empty if there are no weights
+        };
+        struct Cached {
+            std::string key;
+            ProfilePtr profile;
+        };
+        static std::string KeyOf(AutoBis::ScoreWeightMap const& weights);
+        void Apply(ObjectGuid const& guid, std::string const& text);
+
+        std::mutex _lock;
+        std::unordered_map<ObjectGuid, Weights> _players;
+        std::list<Cached> _lru; // most recently used first
+        std::unordered_map<std::string, std::list<Cached>::iterator> _profiles;
+        uint32 _maxProfiles = 1024;
+        std::unordered_map<ObjectGuid, std::string> _pendingWrites; // "" deletes the row
+        uint32 _flushInterval = 5000;
+        uint32 _flushElapsed = 0;
 };
 
-const AutoBis::ScoreWeightMap& AutoBis::GetScoreWeightMap(Player *player)
+static AbCustomWeights abCustomWeights;
+
+void AbCustomWeights::LoadConfig()
 {
-    if (player->GetClass() == CLASS_PALADIN) {
-        if (Item* offhand = player->GetItemByPos(INVENTORY_SLOT_BAG_0, EQUIPMENT_SLOT_OFFHAND))
-            return prot_paladin_map;
-        else
-            return ret_paladin_map;
-    } else if (player->GetClass() == CLASS_HUNTER)
-        return bm_hunter_map;
-    else if (player->GetClass() == CLASS_WARRIOR)
-        return fury_warrior_map;
-    else if (player->GetClass() == CLASS_MAGE)
-        return frost_mage_map;
-    else if (player->GetClass() == CLASS_DRUID) {
-        if (player->GetLevel() < 10)
-            return boomkin_map;
-        else
-            return cat_druid_map;
+    std::lock_guard<std::mutex> guard(_lock);
+    _maxProfiles = std::max(sConfigMgr->GetIntDefault("AutoBis.Weights.CacheSize", 1024), 1);
+    _flushInterval = std::max(sConfigMgr->GetIntDefault("AutoBis.Weights.FlushInterval", 5), 1) * 1000;
+}
+
+// The normalized weights, so that e.g. "Strength=2 Agility=1" and "Strength=4 Agility=2" share a profile; empty (no
+//  custom profile) if they don't add up to a positive number:
+std::string AbCustomWeights::KeyOf(AutoBis::ScoreWeightMap const& weights)
+{
+    double total = 0.0;
+    for (auto const& weight : weights)
+        total += weight.second;
+    std::string key;
+    if (!std::isfinite(total) || total <= 0.0)
+        return key;
+    char entry[48];
+    for (auto const& weight : weights) {
+        snprintf(entry, sizeof(entry), "%d=%.12g;", weight.first, weight.second / total);
+        key += entry;
+    }
+    return key;
+}
+
+AbCustomWeights::ProfilePtr AbCustomWeights::GetProfile(ObjectGuid const& guid)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    auto fiter = _players.find(guid);
+    if (fiter == _players.end() || fiter->second.key.empty())
+        return nullptr;
+    Weights const& player = fiter->second;
+    auto cached = _profiles.find(player.key);
+    if (cached != _profiles.end()) {
+        _lru.splice(_lru.begin(), _lru, cached->second);
+        return cached->second->profile;
+    }
+    ProfilePtr profile(new AbWeightProfile(AbCompileWeightProfile(player.weights, abNextProfileId.fetch_add(1),
+                                                                  "custom")));
+    _lru.push_front(Cached{ player.key, profile });
+    _profiles[player.key] = _lru.begin();
+    while (_lru.size() > _maxProfiles) {
+        _profiles.erase(_lru.back().key);
+        _lru.pop_back();
+    }
+    return profile;
+}
+
+bool AbCustomWeights::GetWeights(ObjectGuid const& guid, AutoBis::ScoreWeightMap &weights)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    auto fiter = _players.find(guid);
+    if (fiter == _players.end() || fiter->second.key.empty())
+        return false;
+    weights = fiter->second.weights;
+    return true;
+}
+
+// Under _lock:
+void AbCustomWeights::Apply(ObjectGuid const& guid, std::string const& text)
+{
+    Weights &player = _players[guid];
+    player.loading = false;
+    player.weights.clear();
+    player.key.clear();
+    std::string error;
+    if (!text.empty() && AbParsePawnWeights(text, player.weights, error))
+        player.key = KeyOf(player.weights);
+    else if (!text.empty())
+        printf("AutoBis: ignoring the stored weights of character %u: %s\n", guid.GetCounter(), error.c_str());
+}
+
+void AbCustomWeights::Load(Player *player)
+{
+    ObjectGuid guid = player->GetGUID();
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        // Changed during an earlier session, but not written yet; the database would be out of date:
+        auto pending = _pendingWrites.find(guid);
+        if (pending != _pendingWrites.end()) {
+            Apply(guid, pending->second);
+            return;
+        }
+        _players[guid].loading = true;
+    }
+    CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_AUTOBIS_WEIGHTS);
+    stmt->setUInt32(0, guid.GetCounter());
+    abMetrics.Add(AB_COUNTER_DB_QUERIES);
+    player->GetSession()->GetQueryProcessor().AddCallback(CharacterDatabase.AsyncQuery(stmt)
+        .WithPreparedCallback([this, guid](PreparedQueryResult result) {
+            std::lock_guard<std::mutex> guard(_lock);
+            auto fiter = _players.find(guid);
+            if (fiter == _players.end() || !fiter->second.loading)
+                return; // logged out, or set or reset in the meantime
+            Apply(guid, result ? result->Fetch()[0].GetString() : std::string());
+        }));
+}
+
+void AbCustomWeights::Set(ObjectGuid const& guid, AutoBis::ScoreWeightMap const& weights)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    Weights &player = _players[guid];
+    player.loading = false;
+    player.weights = weights;
+    player.key = KeyOf(weights);
+    _pendingWrites[guid] = AbFormatPawnWeights(weights);
+}
+
+void AbCustomWeights::Reset(ObjectGuid const& guid)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    Weights &player = _players[guid];
+    player.loading = false;
+    player.weights.clear();
+    player.key.clear();
+    _pendingWrites[guid] = std::string();
+}
+
+void AbCustomWeights::Forget(ObjectGuid const& guid)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _players.erase(guid);
+}
+
+void AbCustomWeights::Update(uint32 diff)
+{
+    _flushElapsed += diff;
+    if (_flushElapsed < _flushInterval)
+        return;
+    _flushElapsed = 0;
+    Flush();
+}
+
+void AbCustomWeights::Flush()
+{
+    std::unordered_map<ObjectGuid, std::string> writes;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        writes.swap(_pendingWrites);
+    }
+    if (writes.empty())
+        return;
+    // Prepared statements (see "Prepared Statements" in the README), so the weights are never spliced into SQL:
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    for (auto const& write : writes) {
+        CharacterDatabasePreparedStatement* stmt;
+        if (write.second.empty()) {
+            stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_AUTOBIS_WEIGHTS);
+            stmt->setUInt32(0, write.first.GetCounter());
+        } else {
+            stmt = CharacterDatabase.GetPreparedStatement(CHAR_REP_AUTOBIS_WEIGHTS);
+            stmt->setUInt32(0, write.first.GetCounter());
+            stmt->setString(1, write.second);
+        }
+        trans->Append(stmt);
     }
-    else if (player->GetClass() == CLASS_SHAMAN)
-        return enh_shaman_map;
-    else if (player->GetClass() == CLASS_PRIEST)
-        return shadow_priest_map;
-    else if (player->GetClass() == CLASS_ROGUE)
-        return combat_rogue_map;
-    return ret_paladin_map;
+    CharacterDatabase.CommitTransaction(trans);
 }
 
 static bool CanOneDualWield(Player* player)
@@ -290,251 +603,324 @@ static bool CanOneDualWield(Player* player)
     return ((player->HasSpell(674) || player->HasSpell(30798)) && !player->HasSpell(46917));
 }
 
-void AutoBis::AdjustInvType(Player* player, uint32 &inv_type)
+void AutoBis::AdjustInvType(bool oh_dual, uint32 &inv_type)
 {
     if (inv_type == INVTYPE_WEAPONMAINHAND) {
-        if (CanOneDualWield(player))
+        if (oh_dual)
             return;
         inv_type = INVTYPE_WEAPON;
-    } else if (inv_type == INVTYPE_ROBE) {
-        inv_type = INVTYPE_CHEST;
-    } else if (inv_type == INVTYPE_HOLDABLE || inv_type == INVTYPE_WEAPONOFFHAND) {
-        inv_type = INVTYPE_SHIELD;
-    } else if (inv_type == INVTYPE_THROWN || inv_type == INVTYPE_RANGEDRIGHT) {
-        inv_type = INVTYPE_RANGED;
-    }
+    } else
+        AbAdjustStaticInvType(inv_type);
 }
 
+// Every item Process() could ever hand out, and the features it's ranked by; built once at startup (see
+//  AutoBis::LoadStaticData()):
+static AbItemCatalog abItemCatalog;
+static AbItemFeatures abItemFeatures;
 
 //
-// see src/server/game/Entities/Item/ItemEnchantmentMgr.cpp
+// What scoring needs from the core (see AbScoreData): "Equip: Increase X by Y" stats from SpellMgr, the random
+//  enchantment pools from item_enchantment_template, and what each random enchant gives from the DBC stores.
 //
-// Unlike GenerateItemRandomPropertyId(), we don't care about the chances (except to initially populate the unordered_map).
-typedef std::vector<uint32> EnchStoreList;
-struct AbEnchantmentStore {
-    void LoadRandomEnchantmentsTable();
-    std::unordered_map<uint32, EnchStoreList> _store;
-    bool _needs_init = true;
+// Built once at startup and never modified afterwards, so any number of callers can read it without locking. The
+//  equip stats are flattened for every spell any item uses, so scoring never has to walk SpellInfo effects (or
+//  allocate to deduplicate them).
+class AbServerScoreData : public AbScoreData {
+    public:
+        void LoadEquipSpellStats(AbItemList const& templates);
+        void LoadRandomEnchantmentsTable();
+
+        void GetEquipSpellStats(uint32 spellId, Stat const*& first, Stat const*& last) const override;
+        std::vector<uint32> const* GetEnchantPool(uint32 ench_idx) const override;
+        bool GetRandomEnchant(uint32 ench, bool rand_suffix, RandomEnchant &enchant) const override;
+        uint32 GetSuffixFactor(ItemTemplate const* itemTemplate) const override;
+
+        std::vector<Stat> _stats;
+        std::unordered_map<uint32, std::pair<uint32, uint32>> _spells; // spell -> [first, last) into _stats
+        std::unordered_map<uint32, std::vector<uint32>> _pools;
 };
 
-static AbEnchantmentStore randomItemEnch;
+static_assert(MAX_ITEM_ENCHANTMENT_EFFECTS * MAX_ITEM_ENCHANTMENT_EFFECTS <= AbScoreData::MAX_RANDOM_ENCHANT_STATS,
+              "AbScoreData::RandomEnchant is too small");
 
-void AbEnchantmentStore::LoadRandomEnchantmentsTable()
+static AbServerScoreData abScoreData;
+
+void AbServerScoreData::LoadEquipSpellStats(AbItemList const& templates)
 {
-    if (!_needs_init)
-        return;
-    _needs_init = false;
-    _store.clear();
+    _stats.clear();
+    _spells.clear();
+    std::map<uint32, uint32> unknownAuras; // ApplyAuraName -> a spell using it
+    for (ItemTemplate const* itemTemplate : templates) {
+        for (uint32 idx = 0; idx < MAX_ITEM_PROTO_SPELLS; ++idx) {
+            uint32 spellid = itemTemplate->Spells[idx].SpellId;
+            if (spellid <= 0 || itemTemplate->Spells[idx].SpellTrigger != ITEM_SPELLTRIGGER_ON_EQUIP)
+                continue;
+            if (_spells.count(spellid))
+                continue;
+            uint32 first = _stats.size();
+            SpellInfo const* spellInfo = SpellMgr::instance()->GetSpellInfo(spellid);
+            if (spellInfo) {
+                for (uint8 jdx = 0; jdx < MAX_SPELL_EFFECTS; ++jdx) {
+                    const SpellEffectInfo& sei = spellInfo->_effects[jdx];
+                    bool unknownAura = false;
+                    int32 statId = SpellEffectInfoToItemMod(sei, &unknownAura);
+                    if (unknownAura)
+                        unknownAuras.emplace(sei.ApplyAuraName, spellid);
+                    if (statId == INT_MIN)
+                        continue; // we're not weighing this Equip stat
+                    // FIXME: For some reason, this loop will iterate the same power/value twice. Prevent this:
+                    bool seen = false;
+                    for (uint32 sdx = first; sdx < _stats.size(); ++sdx)
+                        seen |= (_stats[sdx].stat_id == statId);
+                    if (!seen)
+                        _stats.push_back(Stat{ statId, sei.CalcValue() });
+                }
+            }
+            _spells[spellid] = std::make_pair(first, uint32(_stats.size()));
+        }
+    }
+    for (auto const& unknown : unknownAuras)
+        printf("FIXME: ApplyAuraName=%u not found (e.g. spell %u).\n", unknown.first, unknown.second);
+}
+
+//
+// see src/server/game/Entities/Item/ItemEnchantmentMgr.cpp
+//
+// Unlike GenerateItemRandomPropertyId(), we don't care about the chances (except to initially populate the pools).
+void AbServerScoreData::LoadRandomEnchantmentsTable()
+{
+    _pools.clear();
     //                                                 0      1      2
     QueryResult result = WorldDatabase.Query("SELECT entry, ench, chance FROM item_enchantment_template");
+    abMetrics.Add(AB_COUNTER_DB_QUERIES);
     if (result) {
-        uint32 count = 0;
         do {
             Field* fields = result->Fetch();
             uint32 entry = fields[0].GetUInt32();
             uint32 ench = fields[1].GetUInt32();
             float chance = fields[2].GetFloat();
             if (chance > 0.000001f && chance <= 100.0f)
-                _store[entry].push_back(ench);
-            ++count;
+                _pools[entry].push_back(ench);
         } while (result->NextRow());
     }
 }
 
-double AutoBis::CalculateBestRandomEnchant(const ScoreWeightMap &score_weights, ItemTemplate const* itemProto, int32& enchId)
-{
-    randomItemEnch.LoadRandomEnchantmentsTable();
-    enchId = 0;
-    // Items with random suffixes/properties must have one of the two:
-    bool do_debug = false; // (itemProto->ItemId == 25117);
-    double totalWeight = 0.0;
-    for (auto entry : score_weights) {
-        totalWeight += entry.second;
-    }
-    // RandomSuffix and RandomProperty _should_ be mutually exclusive.
-    //  If, for some reason, both are set. Just take from "RandomProperty":
-    if (itemProto->RandomProperty || itemProto->RandomSuffix) {
-        bool rand_suffix = false;
-        uint32 ench_idx = itemProto->RandomProperty;
-        if (!ench_idx) {
-            ench_idx = itemProto->RandomSuffix;
-            rand_suffix = true;
-        }
-        auto riefiter = randomItemEnch._store.find(ench_idx);
-        if (riefiter == randomItemEnch._store.end())
-            return 0; // Internal error!?
-        const EnchStoreList& list = riefiter->second;
-        double best_score = -1000.0; // because we want at least 1 enchant
-        for (uint32 ench : list) {
-            double cur_score = 0;
-            if (!rand_suffix) {
-                ItemRandomPropertiesEntry const* propEntry = sItemRandomPropertiesStore.LookupEntry(ench);
-                if (!propEntry) {
-                    if (do_debug)
-                        printf("  ench=%u doesn't have ItemRandomPropertiesEntry?!\n", ench);
-                    continue; // Internal error!?
-                }
-                for (unsigned idx = 0; idx < MAX_ITEM_ENCHANTMENT_EFFECTS; ++idx) {
-                    uint32 subench = propEntry->Enchantment[idx];
-                    SpellItemEnchantmentEntry const* pEnchant = sSpellItemEnchantmentStore.LookupEntry(subench);
-                    if (!pEnchant)
-                        continue; // Internal error!?
-                    for (uint8 tt = 0; tt < MAX_ITEM_ENCHANTMENT_EFFECTS; ++tt) {
-                        if (do_debug) {
-                            printf("       enchId = %u:%u, Effect = %d, EffectArg = %d, EffectPointsMin = %d\n",
-                                    ench, subench, pEnchant->Effect[tt], pEnchant->EffectArg[tt],
-                                    pEnchant->EffectPointsMin[tt]);
-                        }
-                        if (pEnchant->Effect[tt] != ITEM_ENCHANTMENT_TYPE_STAT)
-                            continue;
-                        int32 statId = pEnchant->EffectArg[tt];
-                        auto fiter = score_weights.find(statId);
-                        if (fiter != score_weights.end()) {
-                            cur_score += pEnchant->EffectPointsMin[tt] * fiter->second / totalWeight;
-                        }
-                    }
-                }
-            } else {
-                // Items with RandomSuffix are handled way differently than RandomProp. Suffixes are scaled based
-                //  on a scaling factor, which can be queried for. We need to calculate how much value per item:
-                ItemRandomSuffixEntry const* item_rand = sItemRandomSuffixStore.LookupEntry(ench);
-                if (!item_rand) {
-                    if (do_debug)
-                        printf("  ench=%u doesn't have ItemRandomSuffixEntry?!\n", ench);
-                    continue; // internal error?!
-                }
-                uint32 scalefact = GenerateEnchSuffixFactor(itemProto->ItemId);
-                for (int k = 0; k < MAX_ITEM_ENCHANTMENT_EFFECTS; ++k) {
-                    uint32 myEnchantment = item_rand->Enchantment[k];
-                    if (!myEnchantment)
-                        continue;
-                    SpellItemEnchantmentEntry const* pEnchant = sSpellItemEnchantmentStore.LookupEntry(myEnchantment);
-                    if (!pEnchant) {
-                        if (do_debug)
-                            printf("  ench=%u:%u, Enchantment=%u doesn't have pEnchant?!\n", ench_idx, ench, myEnchantment);
-                        continue;
-                    }
-                    uint32 enchant_amount = uint32((item_rand->AllocationPct[k] * scalefact) / 10000);
-                    if (do_debug) {
-                        printf("      enchId=%u:%u (%s), Enchantment = %u, AllocationPct = %u, scale = %u, amount=%u\n",
-                               ench_idx, ench, item_rand->Name[k], myEnchantment,
-                               item_rand->AllocationPct[k], scalefact, enchant_amount);
-                    }
-                    for (uint8 tt = 0; tt < MAX_ITEM_ENCHANTMENT_EFFECTS; ++tt) {
-                        if (pEnchant->Effect[tt] != ITEM_ENCHANTMENT_TYPE_STAT)
-                            continue;
-                        if (do_debug) {
-                            printf("           Effect = %d, EffectArg = %d, EffectPointsMin = %d\n",
-                                    pEnchant->Effect[tt], pEnchant->EffectArg[tt], pEnchant->EffectPointsMin[tt]);
-                        }
-                        int32 statId = pEnchant->EffectArg[tt];
-                        auto fiter = score_weights.find(statId);
-                        if (fiter != score_weights.end()) {
-                            cur_score += enchant_amount * fiter->second / totalWeight;
-                        }
-                    }
-                }
-            }
-            if (do_debug)
-                printf("       enchId = %u, score = %f\n", ench, cur_score);
-            if (cur_score > best_score) {
-                if (!rand_suffix)
-                    enchId = ((int32) ench);
-                else
-                    enchId = -((int32) ench);
-                best_score = cur_score;
+void AbServerScoreData::GetEquipSpellStats(uint32 spellId, Stat const*& first, Stat const*& last) const
+{
+    first = last = _stats.data();
+    auto fiter = _spells.find(spellId);
+    if (fiter == _spells.end())
+        return;
+    first = _stats.data() + fiter->second.first;
+    last = _stats.data() + fiter->second.second;
+}
+
+std::vector<uint32> const* AbServerScoreData::GetEnchantPool(uint32 ench_idx) const
+{
+    auto fiter = _pools.find(ench_idx);
+    return fiter != _pools.end() ? &fiter->second : nullptr;
+}
+
+bool AbServerScoreData::GetRandomEnchant(uint32 ench, bool rand_suffix, RandomEnchant &enchant) const
+{
+    enchant.count = 0;
+    if (!rand_suffix) {
+        ItemRandomPropertiesEntry const* propEntry = sItemRandomPropertiesStore.LookupEntry(ench);
+        if (!propEntry)
+            return false;
+        for (unsigned idx = 0; idx < MAX_ITEM_ENCHANTMENT_EFFECTS; ++idx) {
+            uint32 subench = propEntry->Enchantment[idx];
+            SpellItemEnchantmentEntry const* pEnchant = sSpellItemEnchantmentStore.LookupEntry(subench);
+            if (!pEnchant)
+                continue; // Internal error!?
+            for (uint8 tt = 0; tt < MAX_ITEM_ENCHANTMENT_EFFECTS; ++tt) {
+                if (pEnchant->Effect[tt] != ITEM_ENCHANTMENT_TYPE_STAT)
+                    continue;
+                int32 statId = pEnchant->EffectArg[tt];
+                enchant.stats[enchant.count++] = Stat{ statId, int32(pEnchant->EffectPointsMin[tt]) };
             }
         }
-        if (best_score <= 0) {
-            // Internal error!? print something out..
-            enchId = GenerateItemRandomPropertyId(itemProto->ItemId);
-            return 0;
+        return true;
+    }
+    // Suffixes give each of their enchantments' stats AllocationPct, which gets scaled by the item's suffix factor:
+    ItemRandomSuffixEntry const* item_rand = sItemRandomSuffixStore.LookupEntry(ench);
+    if (!item_rand)
+        return false;
+    for (int k = 0; k < MAX_ITEM_ENCHANTMENT_EFFECTS; ++k) {
+        uint32 myEnchantment = item_rand->Enchantment[k];
+        if (!myEnchantment)
+            continue;
+        SpellItemEnchantmentEntry const* pEnchant = sSpellItemEnchantmentStore.LookupEntry(myEnchantment);
+        if (!pEnchant)
+            continue;
+        for (uint8 tt = 0; tt < MAX_ITEM_ENCHANTMENT_EFFECTS; ++tt) {
+            if (pEnchant->Effect[tt] != ITEM_ENCHANTMENT_TYPE_STAT)
+                continue;
+            int32 statId = pEnchant->EffectArg[tt];
+            enchant.stats[enchant.count++] = Stat{ statId, int32(item_rand->AllocationPct[k]) };
         }
-        return best_score;
-    } else
-        return 0;
+    }
+    return true;
 }
 
-double AutoBis::ComputePawnScore(const ScoreWeightMap &score_weights, ItemTemplate const* itemTemplate)
+uint32 AbServerScoreData::GetSuffixFactor(ItemTemplate const* itemTemplate) const
 {
-    // ...
-    uint32 itemId = itemTemplate->ItemId;
-    // FIXME: Can we completely get rid of this SQL statement?
-    std::string myStm = "SELECT dmg_min1, dmg_max1 FROM item_template WHERE entry = "
-                        + std::to_string(itemId) + ";";
-    std::shared_ptr<ResultSet> result = WorldDatabase.Query(myStm.c_str());
-    if (!result) {
-        printf("INTERNAL ERROR: entry = %u not found in item_template !?\n", itemId);
-        return -1.0;
-    }
-    Field* fields = result->Fetch();
-    double dmg_min1 = fields[0].GetFloat();
-    double dmg_max1 = fields[1].GetFloat();
-    uint32 armor = itemTemplate->Armor;
-    //
-    double totalScore = 0.0, totalWeight = 0.0;
-    for (auto entry : score_weights) {
-        totalWeight += entry.second;
-    }
-    int block = itemTemplate->Block;
-    if (block) {
-        auto fiter = score_weights.find(ITEM_MOD_BLOCK_VALUE);
-        if (fiter != score_weights.end()) {
-            totalScore += block * fiter->second / totalWeight;
+    return GenerateEnchSuffixFactor(itemTemplate->ItemId);
+}
+
+// The best enchant of every weight profile in use, for every catalog item (see PublishProfiles()). Only ever accessed
+//  through std::atomic_load()/std::atomic_store():
+static std::shared_ptr<AbBestEnchants const> randomItemEnch;
+
+// What rankings are computed from right now; keeps the enchant store it points to alive for as long as it's around,
+//  so a reload can't free it from under a ranking:
+struct AbServerScoringContext : AbScoringContext {
+    std::shared_ptr<AbBestEnchants const> enchants_owner;
+};
+
+static AbServerScoringContext ScoringContext()
+{
+    AbServerScoringContext context;
+    context.enchants_owner = std::atomic_load(&randomItemEnch);
+    context.data = &abScoreData;
+    context.catalog = &abItemCatalog;
+    context.features = &abItemFeatures;
+    context.enchants = context.enchants_owner.get();
+    context.metrics = &abMetrics;
+    return context;
+}
+
+double AutoBis::CalculateBestRandomEnchant(const AbWeightProfile &profile, ItemTemplate const* itemProto, int32& enchId)
+{
+    return AbBestRandomEnchant(ScoringContext(), profile, itemProto, enchId);
+}
+
+double AutoBis::ComputePawnScore(const AbWeightProfile &profile, ItemTemplate const* itemTemplate)
+{
+    int32 enchId;
+    return AbBaseScore(abScoreData, profile, itemTemplate) + CalculateBestRandomEnchant(profile, itemTemplate, enchId);
+}
+
+//
+// For a given weight profile, an item's score (and its best random enchant) never changes, yet we used to
+//  recompute it for every owned item on every invocation, and again for every player of the same class and level.
+//
+// Bounded and sharded so concurrent callers rarely contend. When a shard fills up it's simply cleared: every entry
+//  is cheap to recompute, so there's no point in paying for LRU bookkeeping on every hit.
+class AbScoreCache {
+    public:
+        struct Entry {
+            double score;       // ComputePawnScore()
+            double ench_score;  // the part of "score" that comes from the best random enchant
+            int32 ench_id;      // as returned by CalculateBestRandomEnchant()
+            uint32 generation;
+        };
+        void SetMaxEntries(uint32 max_entries) { _maxPerShard = std::max<uint32>(max_entries / SHARDS, 1); }
+        uint32 Generation() const { return _generation.load(std::memory_order_acquire); }
+        bool Get(uint32 profileId, uint32 itemId, Entry &entry);
+        // "generation" must be read before the entry was computed, so a concurrent Invalidate() isn't undone:
+        void Put(uint32 profileId, uint32 itemId, Entry const& entry);
+        // Call whenever the weight profiles change:
+        void Invalidate();
+
+        std::atomic<uint64> _hits{0};
+        std::atomic<uint64> _misses{0};
+    private:
+        static constexpr uint32 SHARDS = 16;
+        struct Shard {
+            std::mutex lock;
+            std::unordered_map<uint64, Entry> entries;
+        };
+        static uint64 Key(uint32 profileId, uint32 itemId) { return (uint64(profileId) << 32) | itemId; }
+        Shard& GetShard(uint64 key) { return _shards[(key ^ (key >> 32)) % SHARDS]; }
+
+        std::array<Shard, SHARDS> _shards;
+        std::atomic<uint32> _generation{0};
+        uint32 _maxPerShard = 8192;
+};
+
+static AbScoreCache abScoreCache;
+
+bool AbScoreCache::Get(uint32 profileId, uint32 itemId, Entry &entry)
+{
+    uint64 key = Key(profileId, itemId);
+    Shard &shard = GetShard(key);
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto fiter = shard.entries.find(key);
+        if (fiter != shard.entries.end() && fiter->second.generation == Generation()) {
+            entry = fiter->second;
+            _hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
         }
     }
-    if (itemTemplate->Class == ITEM_CLASS_WEAPON) {
-        double dps = 1000 * (dmg_min1 + dmg_max1) / 2 / itemTemplate->Delay;
-        uint32 invtype = itemTemplate->InventoryType;
-        if (invtype == INVTYPE_RANGED || invtype == INVTYPE_THROWN || invtype == INVTYPE_RANGEDRIGHT) {
-            if (dps > 0 && score_weights.find(-3) != score_weights.end())
-                totalScore += dps * score_weights.at(-3) / totalWeight;
-        } else {
-            if (dps > 0 && score_weights.find(-1) != score_weights.end())
-                totalScore += dps * score_weights.at(-1) / totalWeight;
-        }
+    _misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void AbScoreCache::Put(uint32 profileId, uint32 itemId, Entry const& entry)
+{
+    if (entry.generation != Generation())
+        return; // computed against profiles that have since been replaced
+    uint64 key = Key(profileId, itemId);
+    Shard &shard = GetShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    if (shard.entries.size() >= _maxPerShard)
+        shard.entries.clear();
+    shard.entries[key] = entry;
+}
+
+void AbScoreCache::Invalidate()
+{
+    _generation.fetch_add(1, std::memory_order_acq_rel);
+    for (Shard &shard : _shards) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.entries.clear();
     }
-    if (armor > 0 && score_weights.find(-2) != score_weights.end())
-        totalScore += armor * score_weights.at(-2) / totalWeight;
-    for (int32 idx = 0; idx < itemTemplate->StatsCount; ++idx) {
-        int32 statId = itemTemplate->ItemStat[idx].ItemStatType;
-        int32 statVal = itemTemplate->ItemStat[idx].ItemStatValue;
-        if (statVal <= 0)
-            continue;
-        auto fiter = score_weights.find(statId);
-        if (fiter != score_weights.end()) {
-            totalScore += statVal * fiter->second / totalWeight;
-        }
+}
+
+double AutoBis::ScoreItem(const AbWeightProfile &profile, ItemTemplate const* itemTemplate, int32& enchId,
+                          double* enchScore)
+{
+    AbScoreCache::Entry entry;
+    if (!abScoreCache.Get(profile.id, itemTemplate->ItemId, entry)) {
+        abMetrics.Add(AB_COUNTER_ITEMS_SCORED);
+        entry.generation = abScoreCache.Generation();
+        entry.ench_score = CalculateBestRandomEnchant(profile, itemTemplate, entry.ench_id);
+        entry.score = AbBaseScore(abScoreData, profile, itemTemplate) + entry.ench_score;
+        abScoreCache.Put(profile.id, itemTemplate->ItemId, entry);
     }
-    // Items can also have: "Equip: Increase X by Y" attributes. These are separate:
-    std::unordered_set<int> seen_stat_ids;
-    for (uint32 idx = 0; idx < MAX_ITEM_PROTO_SPELLS; ++idx) {
-        uint32 spellid = itemTemplate->Spells[idx].SpellId;
-        if (spellid <= 0 || itemTemplate->Spells[idx].SpellTrigger != ITEM_SPELLTRIGGER_ON_EQUIP)
-            continue;
-        SpellInfo const* spellInfo = SpellMgr::instance()->GetSpellInfo(spellid);
-        if (!spellInfo)
-            continue; // Internal error??
-        for (uint8 jdx = 0; jdx < MAX_SPELL_EFFECTS; ++jdx) {
-            const SpellEffectInfo& sei = spellInfo->_effects[jdx];
-            int statId = SpellEffectInfoToItemMod(sei);
-            if (statId == INT_MIN)
-                continue; // we're not weighing this Equip stat
-            int value = sei.CalcValue();
-            // FIXME: For some reason, this loop will iterate the same power/value twice. Prevent this:
-            if (seen_stat_ids.find(statId) != seen_stat_ids.end())
-                continue;
-            seen_stat_ids.insert(statId);
-            auto fiter = score_weights.find(statId);
-            if (fiter != score_weights.end()) {
-                totalScore += value * fiter->second / totalWeight;
+    enchId = entry.ench_id;
+    if (enchScore)
+        *enchScore = entry.ench_score;
+    return entry.score;
+}
+
+#ifdef AUTOBIS_SELFTEST
+// The batch kernel has to agree with ComputePawnScore() (minus random enchants) for every profile:
+void AutoBis::SelfTestFeatures()
+{
+    uint32 checked = 0, mismatches = 0;
+    std::vector<double> scores(abItemFeatures._rows);
+    std::shared_ptr<AbProfileSet const> set = CurrentProfiles();
+    for (const AbWeightProfile &profile : set->profiles) {
+        abItemFeatures.Score(profile, 0, abItemFeatures._rows, scores.data());
+        for (uint32 row = 0; row < abItemFeatures._rows; ++row) {
+            ItemTemplate const* itemTemplate = abItemCatalog._items[row];
+            int32 enchId;
+            double expected = ComputePawnScore(profile, itemTemplate)
+                              - CalculateBestRandomEnchant(profile, itemTemplate, enchId);
+            if (std::fabs(expected - scores[row]) > 1e-4 * std::max(1.0, std::fabs(expected))) {
+                printf("AutoBis selftest: %s: entry = %u: expected score == %f; got: %f\n", profile.name,
+                       itemTemplate->ItemId, expected, scores[row]);
+                ++mismatches;
             }
+            ++checked;
         }
     }
-    int32 enchId;
-    totalScore += CalculateBestRandomEnchant(score_weights, itemTemplate, enchId);
-    return totalScore;
+    printf("AutoBis selftest: batch scores: %u checked, %u mismatches.\n", checked, mismatches);
 }
+#endif
 
 bool AutoBis::PlayerCanUseItem(Player *player, ItemTemplate const* itemTemplate)
 {
@@ -547,84 +933,31 @@ bool AutoBis::PlayerCanUseItem(Player *player, ItemTemplate const* itemTemplate)
         return false;
     if (EQUIP_ERR_OK != player->CanUseItem(itemTemplate))
         return false;
-    if (inv_type == INVTYPE_SHIELD) {
-        // only shamans, warriors, and paladins can use shields:
-        if (player->GetClass() != CLASS_WARRIOR && player->GetClass() != CLASS_PALADIN
-            && player->GetClass() != CLASS_SHAMAN)
-            return false;
-    }
     if (itemTemplate->Class == ITEM_CLASS_WEAPON) {
-        const static uint32 item_weapon_skills[MAX_ITEM_SUBCLASS_WEAPON] = {
-            SKILL_AXES,     SKILL_2H_AXES,  SKILL_BOWS,          SKILL_GUNS,      SKILL_MACES,
-            SKILL_2H_MACES, SKILL_POLEARMS, SKILL_SWORDS,        SKILL_2H_SWORDS, 0,
-            SKILL_STAVES,   0,              0,                   SKILL_FIST_WEAPONS,   0,
-            SKILL_DAGGERS,  SKILL_THROWN,   SKILL_ASSASSINATION, SKILL_CROSSBOWS, SKILL_WANDS,
-            SKILL_FISHING
-        }; //Copy from function Item::GetSkill()
-        if (player->GetSkillValue(item_weapon_skills[subclass]) == 0)
+        if (player->GetSkillValue(AbWeaponSkill(subclass)) == 0)
             return false; // player cannot equip this item
         // If a warrior has Titan's Grip, they can't onehand polearms nor staffs:
         if (titans_grip && (subclass == ITEM_SUBCLASS_WEAPON_SPEAR || subclass == ITEM_SUBCLASS_WEAPON_STAFF))
             return false;
     }
-    if (itemTemplate->Class == ITEM_CLASS_ARMOR) {
-        if (player->GetClass() == CLASS_WARRIOR || player->GetClass() == CLASS_PALADIN
-            || player->GetClass() == CLASS_DEATH_KNIGHT) {
-            // plate doesn't start to show up til lvl 40. Don't do checks for pal/warr/DKs..
-        } else if (player->GetClass() == CLASS_SHAMAN || player->GetClass() == CLASS_HUNTER) {
-            if (subclass == ITEM_SUBCLASS_ARMOR_PLATE)
-                return false;
-            if (player->GetLevel() < 40 && subclass == ITEM_SUBCLASS_ARMOR_MAIL)
-                return false;
-        } else if (player->GetClass() == CLASS_DRUID || player->GetClass() == CLASS_ROGUE) {
-            if (subclass == ITEM_SUBCLASS_ARMOR_PLATE
-             || subclass == ITEM_SUBCLASS_ARMOR_MAIL)
-                return false;
-        } else {
-            // player is mage/wlock/priest:
-            if (subclass == ITEM_SUBCLASS_ARMOR_PLATE
-              || subclass == ITEM_SUBCLASS_ARMOR_MAIL
-              || subclass == ITEM_SUBCLASS_ARMOR_LEATHER)
-                return false;
-        }
-        // Totems, Sigils, etc need to be checked against player class:
-        if (subclass == ITEM_SUBCLASS_ARMOR_LIBRAM) {
-            if (player->GetClass() != CLASS_PALADIN)
-                return false;
-        } else if (subclass == ITEM_SUBCLASS_ARMOR_IDOL) {
-            if (player->GetClass() != CLASS_DRUID)
-                return false;
-        } else if (subclass == ITEM_SUBCLASS_ARMOR_TOTEM) {
-            if (player->GetClass() != CLASS_SHAMAN)
-                return false;
-        } else if (subclass == ITEM_SUBCLASS_ARMOR_SIGIL) {
-            if (player->GetClass() != CLASS_DEATH_KNIGHT)
-                return false;
-        }
-    }
-    return true;
+    return AbClassCanUseArmor(player->GetClass(), player->GetLevel(), itemTemplate);
 }
 
-void AutoBis::PopulateSingleHaveItem(Player *player, const ScoreWeightMap &swm, Item *item, ItemSlotMap &have_items,
-                                     bool test_canuse)
+void AutoBis::PopulateSingleHaveItem(Player *player, Item *item, std::vector<Item*> &owned, bool test_canuse)
 {
     ItemTemplate const *itemTemplate = item->GetTemplate();
-    if (!PlayerCanUseItem(player, itemTemplate))
+    if (test_canuse && !PlayerCanUseItem(player, itemTemplate))
         return;
-    uint32 inv_type = itemTemplate->InventoryType;
-    AdjustInvType(player, inv_type);
-    double score = ComputePawnScore(swm, itemTemplate);
-    have_items[inv_type].push_back({itemTemplate, score});
+    owned.push_back(item);
 }
 
-void AutoBis::PopulateHaveItems(Player *player, ItemSlotMap &have_items)
+void AutoBis::PopulateHaveItems(Player *player, std::vector<Item*> &owned)
 {
-    const ScoreWeightMap &swm = GetScoreWeightMap(player);
     for (uint8 i = INVENTORY_SLOT_ITEM_START; i < INVENTORY_SLOT_ITEM_END; ++i) {
         Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, i);
         if (!item)
             continue;
-        PopulateSingleHaveItem(player, swm, item, have_items, true);
+        PopulateSingleHaveItem(player, item, owned, true);
     }
     for (uint8 i = INVENTORY_SLOT_BAG_START; i < INVENTORY_SLOT_BAG_END; i++) {
         Bag* bag = player->GetBagByPos(i);
@@ -634,20 +967,20 @@ void AutoBis::PopulateHaveItems(Player *player, ItemSlotMap &have_items)
             Item* item = bag->GetItemByPos(j);
             if (!item)
                 continue;
-            PopulateSingleHaveItem(player, swm, item, have_items, true);
+            PopulateSingleHaveItem(player, item, owned, true);
         }
     }
     for (uint8 i = EQUIPMENT_SLOT_START; i < INVENTORY_SLOT_BAG_END; i++) {
         Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, i);
         if (!item)
             continue;
-        PopulateSingleHaveItem(player, swm, item, have_items, true);
+        PopulateSingleHaveItem(player, item, owned, true);
     }
     for (uint8 i = BANK_SLOT_ITEM_START; i < BANK_SLOT_ITEM_END; i++) {
         Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, i);
         if (!item)
             continue;
-        PopulateSingleHaveItem(player, swm, item, have_items, true);
+        PopulateSingleHaveItem(player, item, owned, true);
     }
     // in bank bags
     for (uint8 i = BANK_SLOT_BAG_START; i < BANK_SLOT_BAG_END; i++) {
@@ -658,158 +991,2295 @@ void AutoBis::PopulateHaveItems(Player *player, ItemSlotMap &have_items)
             Item* item = bag->GetItemByPos(j);
             if (!item)
                 continue;
-            PopulateSingleHaveItem(player, swm, item, have_items, true);
+            PopulateSingleHaveItem(player, item, owned, true);
         }
     }
 }
 
-bool AutoBis::Process(ChatHandler* handler, char const* args)
+bool AutoBis::TakeSnapshot(Player *player, AbPlayerSnapshot &snapshot, AbLevelRange const& range)
 {
-    Player* player = handler->GetSession()->GetPlayer();
-    bool titans_grip = player->GetClass() == CLASS_WARRIOR && player->HasSpell(46917);
-    bool oh_dual = CanOneDualWield(player);
-    uint8 playerLvl = player->GetLevel();
-    if (playerLvl < 2)
-        return true;
-    //if (!*args)
-    //    return false;
-    struct ItemCompare {
-        bool operator()(const ItemScore &left, const ItemScore &right) {
-            return (left.second > right.second);
-        }
-    };
-    // First, populate "have_items" map with player's inventory + bank:
-    ItemSlotMap have_items;
-    PopulateHaveItems(player, have_items);
-    for (auto &have_slots : have_items) {
-        SlotItems &slot_items = have_slots.second;
-        //printf("%u: %lu\n", have_slots.first, slot_items.size());
-        std::sort(slot_items.begin(), slot_items.end(), ItemCompare());
-    }
-    //
-#if 0
-    // Test:
-    //  50730: Glorenzelg, High-Blade of the Silver Hand (Heroic)
-    double item_score = ComputePawnScore(50730);
-    printf("50730: expected score == 215.20; got: %f\n", item_score);
-#endif
-    std::string myStm = "SELECT entry FROM item_template WHERE (class=2 || class=4) && (Quality<=3) && "
-                        "(FlagsExtra!=8192) && (ItemLevel<200) && (RequiredReputationFaction = 0) && "
-                        "(SellPrice > 0) && "
-                        "(RequiredLevel=" + std::to_string(playerLvl) + ");";
-    std::vector<ItemTemplate const*> item_templates;
-    std::shared_ptr<ResultSet> result = WorldDatabase.Query(myStm.c_str());
-    if (!result) {
-        printf("%s\n", myStm.c_str());
-        printf("no results found (playerLvl = %u) ?!\n", playerLvl);
-        return true;
+    if (!StartSnapshot(player, snapshot, range))
+        return false;
+    // First, populate "have_items" with player's inventory + bank:
+    {
+        AbPhaseTimer timer(abMetrics, AB_PHASE_HAVE_SCAN);
+        CollectHaveItems(player, snapshot);
     }
-    do {
-        Field* fields = result->Fetch();
-        uint32 item_id = fields->GetUInt32();
-        ItemTemplate const* itemTemplate = sObjectMgr->GetItemTemplate(item_id);
-        if (!itemTemplate) {
-            printf("INTERNAL ERROR: entry = %u not found in sObjectMgr !?\n", item_id);
-            continue;
-        }
-        if (!PlayerCanUseItem(player, itemTemplate))
-            continue;
-        item_templates.push_back(itemTemplate);
-    } while (result->NextRow());
-    if (!item_templates.size())
-        return true;
-    const ScoreWeightMap &swm = GetScoreWeightMap(player);
-    ItemSlotMap next_items;
-    for (ItemTemplate const* item_template : item_templates) {
-        uint32 inv_type = item_template->InventoryType;
-        // In the loop prior we used "PlayerCanUseItem()", so don't use it here.
-        AdjustInvType(player, inv_type);
-        SlotItems &have_si = have_items[inv_type];
-        auto fiter = have_si.begin();
-        for (; fiter != have_si.end(); ++fiter) {
-            if (fiter->first == item_template)
-                break;
-        }
-        if (fiter == have_si.end()) {
-            double score = ComputePawnScore(swm, item_template);
-            next_items[inv_type].push_back({item_template, score});
-        }
-    }
-    for (auto &next_slots : next_items) {
-        uint32 invtype = next_slots.first;
-        if (invtype == INVTYPE_SHIELD || invtype == INVTYPE_WEAPONMAINHAND) {
-            // Don't bother with "Main Hand" and "Shield/Offhand" items. "One Handed" items are sufficient.
-            if (oh_dual || titans_grip)
-                continue;
-        }
-        // don't give one-handed weapons to warriors with Titan's Grip
-        if (invtype == INVTYPE_WEAPON && titans_grip)
-            continue;
-        SlotItems &slot_items = next_slots.second;
-        assert(slot_items.size() > 0);
-        std::sort(slot_items.begin(), slot_items.end(), ItemCompare());
-        ItemTemplate const* cur_have = nullptr;
-        double prevscore = 0.0;
-        SlotItems &cur_items = have_items[invtype];
-        if (cur_items.size() > 0) {
-            cur_have = cur_items.begin()->first;
-            prevscore = cur_items.begin()->second;
-        }
-        ItemTemplate const* next_item_templ = slot_items.begin()->first;
-        double nextscore = slot_items.begin()->second;
-        bool second_best = false;
-        bool use_two = (invtype == INVTYPE_FINGER || invtype == INVTYPE_TRINKET || (invtype == INVTYPE_WEAPON && oh_dual)
-                        || (invtype == INVTYPE_2HWEAPON && titans_grip));
-        // We don't beat the 1st item, but let's see if we beat the 2nd item:
-        if (cur_have && prevscore >= nextscore && use_two) {
-            // don't give duplicates:
-            if (cur_have->ItemId != next_item_templ->ItemId) {
-                if (cur_items.size() > 1) {
-                    if (cur_items[1].first->ItemId != next_item_templ->ItemId && nextscore > cur_items[1].second)
-                        second_best = true;
-                } else
-                    second_best = true;
-            }
-        }
-        if (!cur_have || prevscore < nextscore || second_best) {
-            uint32 item_id = next_item_templ->ItemId;
-            ItemPosCountVec dest;
-            InventoryResult msg = player->CanStoreNewItem(NULL_BAG, NULL_SLOT, dest, item_id, 1);
-            if (msg == EQUIP_ERR_OK) {
-                int32 enchId;
-                CalculateBestRandomEnchant(swm, next_item_templ, enchId);
-                Item* item = player->StoreNewItem(dest, item_id, true, enchId);
-                player->SendNewItem(item, 1, false, true);
-            } else {
-                handler->PSendSysMessage(LANG_ITEM_CANNOT_CREATE, item_id, 1);
-                return false;
-            }
-            // let's see if we can add two items!
-            if (!second_best && use_two && slot_items.size() > 1) {
-                ItemTemplate const* next_next_proto = slot_items[1].first;
-                double nextnext = slot_items[1].second;
-                // We need to beat out the best item we already have (if it exists, otherwise win automatically).
-                if (cur_have) {
-                    if (next_next_proto->ItemId != cur_have->ItemId && nextnext > prevscore)
-                        second_best = true;
-                } else
-                    second_best = true;
-                if (second_best) {
-                    ItemPosCountVec dest2;
-                    uint32 item_id2 = next_next_proto->ItemId;
-                    msg = player->CanStoreNewItem(NULL_BAG, NULL_SLOT, dest2, item_id2, 1);
-                    if (msg == EQUIP_ERR_OK) {
-                        int32 enchId;
-                        CalculateBestRandomEnchant(swm, next_next_proto, enchId);
-                        Item* item = player->StoreNewItem(dest2, item_id2, true, enchId);
-                        player->SendNewItem(item, 1, false, true);
-                    } else {
-                        handler->PSendSysMessage(LANG_ITEM_CANNOT_CREATE, item_id2, 1);
-                        return false;
-                    }
-                }
-            }
+    AbPhaseTimer timer(abMetrics, AB_PHASE_CANDIDATES);
+    for (uint32 level = snapshot.min_level; level <= snapshot.max_level; ++level)
+        AddCandidates(player, snapshot, level);
+    return !snapshot.candidate_rows.empty();
+}
+
+bool AutoBis::StartSnapshot(Player *player, AbPlayerSnapshot &snapshot, AbLevelRange const& range)
+{
+    snapshot.guid = player->GetGUID();
+    snapshot.level = player->GetLevel();
+    snapshot.max_level = range.max == AbLevelRange::PLAYER_LEVEL ? snapshot.level : std::min(range.max, snapshot.level);
+    snapshot.min_level = std::min(range.min == AbLevelRange::PLAYER_LEVEL ? snapshot.level : range.min,
+                                  snapshot.max_level);
+    snapshot.titans_grip = player->GetClass() == CLASS_WARRIOR && player->HasSpell(46917);
+    snapshot.oh_dual = CanOneDualWield(player);
+    snapshot.profile_owner = abCustomWeights.GetProfile(snapshot.guid);
+    if (!snapshot.profile_owner)
+        snapshot.profile_owner = GetWeightProfile(player);
+    snapshot.profile = snapshot.profile_owner.get();
+    return snapshot.level >= 2 && snapshot.level <= DEFAULT_MAX_LEVEL;
+}
+
+void AutoBis::AddCandidates(Player *player, AbPlayerSnapshot &snapshot, uint8 level)
+{
+    // The catalog is sorted by RequiredLevel first, so adding levels in increasing order keeps this sorted:
+    for (AbItemCatalog::Range const& bucket : abItemCatalog.GetLevel(level)) {
+        for (uint32 row = bucket.first; row < bucket.last; ++row) {
+            if (PlayerCanUseItem(player, abItemCatalog._items[row]))
+                snapshot.candidate_rows.push_back(row);
         }
     }
-    return true;
+}
+
+void AutoBis::BuildHaveItems(const AbWeightProfile &profile, ItemList const& owned, bool oh_dual,
+                             AbHaveSlots &have_items)
+{
+    have_items.fill(AbTopItems<2>());
+    for (ItemTemplate const* itemTemplate : owned) {
+        uint32 inv_type = itemTemplate->InventoryType;
+        AdjustInvType(oh_dual, inv_type);
+        int32 enchId;
+        have_items[inv_type].Push(itemTemplate, ScoreItem(profile, itemTemplate, enchId));
+    }
+}
+
+//
+// Owned items per player, kept up to date by the item hooks (see NotifyItemAdded()) so that a request doesn't have to
+//  walk the inventory, bags and bank and rescore all of it. What's usable, and how it scores, depends on the player's
+//  weight profile, level, weapon skills and dual-wield/Titan's Grip state; an entry built under another key is
+//  thrown away and rebuilt on the next request. Item hooks can run on map update threads, hence the lock.
+struct AbOwnedKey {
+    uint32 generation = 0;
+    AbWeightProfile const* profile = nullptr;
+    uint8 level = 0;
+    bool oh_dual = false;
+    bool titans_grip = false;
+    uint32 weapon_skills = 0;   // bit per weapon subclass the player has the skill for
+
+    bool operator==(AbOwnedKey const& other) const
+    {
+        return generation == other.generation && profile == other.profile && level == other.level
+            && oh_dual == other.oh_dual && titans_grip == other.titans_grip && weapon_skills == other.weapon_skills;
+    }
+};
+
+class AbOwnedIndex {
+    public:
+        struct Owned {
+            AbOwnedKey key;
+            std::unordered_map<ObjectGuid, ItemTemplate const*> items;  // usable owned items, by item GUID
+            AbHaveSlots have_items;                                     // the best two of those per slot
+            std::vector<uint32> rows;                                   // their item catalog rows, sorted
+            std::shared_ptr<AbWeightProfile const> profile_owner;       // keeps key.profile alive
+        };
+
+        bool _enabled = false;
+        std::atomic<uint32> _generation{0};
+        std::mutex _lock;
+        std::unordered_map<ObjectGuid, Owned> _players;
+};
+
+static AbOwnedIndex abOwnedIndex;
+
+static bool IsOwnedItemPos(uint8 bag, uint8 slot)
+{
+    if (bag == INVENTORY_SLOT_BAG_0)
+        return (slot >= EQUIPMENT_SLOT_START && slot < INVENTORY_SLOT_BAG_END)
+            || (slot >= INVENTORY_SLOT_ITEM_START && slot < INVENTORY_SLOT_ITEM_END)
+            || (slot >= BANK_SLOT_ITEM_START && slot < BANK_SLOT_ITEM_END);
+    return (bag >= INVENTORY_SLOT_BAG_START && bag < INVENTORY_SLOT_BAG_END)
+        || (bag >= BANK_SLOT_BAG_START && bag < BANK_SLOT_BAG_END);
+}
+
+static AbOwnedKey OwnedKeyOf(AbPlayerSnapshot const& snapshot, Player *player)
+{
+    AbOwnedKey key;
+    key.generation = abOwnedIndex._generation.load(std::memory_order_relaxed);
+    key.profile = snapshot.profile;
+    key.level = snapshot.level;
+    key.oh_dual = snapshot.oh_dual;
+    key.titans_grip = snapshot.titans_grip;
+    for (uint32 subclass = 0; subclass < MAX_ITEM_SUBCLASS_WEAPON; ++subclass) {
+        if (AbWeaponSkill(subclass) && player->GetSkillValue(AbWeaponSkill(subclass)) != 0)
+            key.weapon_skills |= 1u << subclass;
+    }
+    return key;
+}
+
+static void InsertOwnedRow(std::vector<uint32> &rows, ItemTemplate const* itemTemplate)
+{
+    uint32 row = abItemCatalog.RowOf(itemTemplate->ItemId);
+    if (row != AbItemCatalog::NO_ROW)
+        rows.insert(std::upper_bound(rows.begin(), rows.end(), row), row);
+}
+
+void AutoBis::CollectHaveItems(Player *player, AbPlayerSnapshot &snapshot)
+{
+    if (!abOwnedIndex._enabled) {
+        std::vector<Item*> owned_items;
+        PopulateHaveItems(player, owned_items);
+        for (Item* item : owned_items) {
+            ItemTemplate const* itemTemplate = item->GetTemplate();
+            uint32 inv_type = itemTemplate->InventoryType;
+            AdjustInvType(snapshot.oh_dual, inv_type);
+            int32 enchId;
+            snapshot.have_items[inv_type].Push(itemTemplate, ScoreItem(*snapshot.profile, itemTemplate, enchId));
+            uint32 row = abItemCatalog.RowOf(itemTemplate->ItemId);
+            if (row != AbItemCatalog::NO_ROW)
+                snapshot.owned_rows.push_back(row);
+        }
+        std::sort(snapshot.owned_rows.begin(), snapshot.owned_rows.end());
+        return;
+    }
+    AbOwnedKey key = OwnedKeyOf(snapshot, player);
+    std::lock_guard<std::mutex> guard(abOwnedIndex._lock);
+    AbOwnedIndex::Owned &owned = abOwnedIndex._players[snapshot.guid];
+    if (!(owned.key == key)) {
+        abMetrics.Add(AB_COUNTER_OWNED_INDEX_REBUILDS);
+        std::vector<Item*> owned_items;
+        PopulateHaveItems(player, owned_items);
+        owned.key = key;
+        owned.profile_owner = snapshot.profile_owner;
+        owned.items.clear();
+        owned.rows.clear();
+        ItemList templates;
+        for (Item* item : owned_items) {
+            owned.items[item->GetGUID()] = item->GetTemplate();
+            templates.push_back(item->GetTemplate());
+            InsertOwnedRow(owned.rows, item->GetTemplate());
+        }
+        BuildHaveItems(*key.profile, templates, key.oh_dual, owned.have_items);
+    } else
+        abMetrics.Add(AB_COUNTER_OWNED_INDEX_HITS);
+    snapshot.have_items = owned.have_items;
+    snapshot.owned_rows = owned.rows;
+}
+
+void AutoBis::NotifyItemAdded(Player *player, Item *item)
+{
+    if (!abOwnedIndex._enabled || !item || !IsOwnedItemPos(item->GetBagSlot(), item->GetSlot()))
+        return;
+    std::lock_guard<std::mutex> guard(abOwnedIndex._lock);
+    auto fiter = abOwnedIndex._players.find(player->GetGUID());
+    // Nothing to update until the next request builds it:
+    if (fiter == abOwnedIndex._players.end() || !fiter->second.key.profile)
+        return;
+    AbOwnedIndex::Owned &owned = fiter->second;
+    ItemTemplate const* itemTemplate = item->GetTemplate();
+    // Moving an item around calls this again for the same item:
+    if (owned.items.count(item->GetGUID()) || !PlayerCanUseItem(player, itemTemplate))
+        return;
+    owned.items[item->GetGUID()] = itemTemplate;
+    InsertOwnedRow(owned.rows, itemTemplate);
+    uint32 inv_type = itemTemplate->InventoryType;
+    AdjustInvType(owned.key.oh_dual, inv_type);
+    int32 enchId;
+    owned.have_items[inv_type].Push(itemTemplate, ScoreItem(*owned.key.profile, itemTemplate, enchId));
+}
+
+void AutoBis::NotifyItemRemoved(Player *player, Item *item)
+{
+    if (!abOwnedIndex._enabled || !item)
+        return;
+    std::lock_guard<std::mutex> guard(abOwnedIndex._lock);
+    auto fiter = abOwnedIndex._players.find(player->GetGUID());
+    if (fiter == abOwnedIndex._players.end())
+        return;
+    AbOwnedIndex::Owned &owned = fiter->second;
+    auto iiter = owned.items.find(item->GetGUID());
+    if (iiter == owned.items.end())
+        return;
+    ItemTemplate const* itemTemplate = iiter->second;
+    owned.items.erase(iiter);
+    uint32 row = abItemCatalog.RowOf(itemTemplate->ItemId);
+    auto riter = std::lower_bound(owned.rows.begin(), owned.rows.end(), row);
+    if (riter != owned.rows.end() && *riter == row)
+        owned.rows.erase(riter);
+    uint32 inv_type = itemTemplate->InventoryType;
+    AdjustInvType(owned.key.oh_dual, inv_type);
+    AbTopItems<2> &slot_items = owned.have_items[inv_type];
+    bool kept = false;
+    for (uint32 idx = 0; idx < slot_items.size; ++idx)
+        kept = kept || slot_items.items[idx].first == itemTemplate;
+    if (!kept)
+        return;
+    // Only the best two are kept, so whatever was third takes its place; the scores are cached:
+    slot_items = AbTopItems<2>();
+    int32 enchId;
+    for (auto const& other : owned.items) {
+        uint32 other_inv_type = other.second->InventoryType;
+        AdjustInvType(owned.key.oh_dual, other_inv_type);
+        if (other_inv_type == inv_type)
+            slot_items.Push(other.second, ScoreItem(*owned.key.profile, other.second, enchId));
+    }
+}
+
+void AutoBis::ForgetPlayer(Player *player)
+{
+    if (!abOwnedIndex._enabled)
+        return;
+    std::lock_guard<std::mutex> guard(abOwnedIndex._lock);
+    abOwnedIndex._players.erase(player->GetGUID());
+}
+
+void AutoBis::RankCandidates(const AbWeightProfile &profile, uint8 minLevel, uint8 maxLevel, AbRankedSlots &ranked,
+                             uint32 depth)
+{
+    AbRankCandidates(ScoringContext(), profile, minLevel, maxLevel, ranked, depth);
+}
+
+bool AutoBis::RankSlot(const AbWeightProfile &profile, uint8 minLevel, uint8 maxLevel, uint32 slot,
+                       std::vector<AbRankedSlots::Entry> &entries, uint32 depth)
+{
+    return AbRankSlot(ScoringContext(), profile, minLevel, maxLevel, slot, entries, depth);
+}
+
+bool AutoBis::Select(AbPlayerSnapshot const& snapshot, AbRankedSlots const& ranked, std::vector<AbGrant> &grants)
+{
+    AbPhaseTimer timer(abMetrics, AB_PHASE_SELECT);
+    return AbSelectFromRanked(ranked, snapshot, grants);
+}
+
+//
+// Single-flight rankings: requests that need the same ranking (same weight profile and level range) while another one
+//  is in flight share it; dual wield and Titan's Grip only matter to the selection. Requests join their flight on the
+//  world thread as they're handed to the workers, so the ones still waiting for a worker count too. Whoever gets to a
+//  ranking first computes it, the others wait for it (std::call_once) and only run their own selection. A flight ends
+//  with its last request, so nothing outlives the requests that needed it but its rankings' buffers, which the next
+//  flights rank into instead of allocating their own.
+struct AbRankingFlight {
+    using Key = std::tuple<uint32, uint8, uint8>;   // profile id, min level, max level
+    Key key;
+    uint32 requests = 0;        // guarded by AbRankingFlights::_lock
+    std::once_flag top_once;
+    AbRankedSlots top;          // from the BiS table when it has the profile, else down to AB_RANK_DEPTH
+    bool from_table = false;
+    std::once_flag full_once;
+    AbRankedSlots full;         // complete, for players "top" wasn't deep enough for
+};
+
+class AbRankingFlights {
+    public:
+        // Any thread; every Join() needs a Leave() once the request is done with the flight:
+        std::shared_ptr<AbRankingFlight> Join(AbPlayerSnapshot const& snapshot)
+        {
+            AbRankingFlight::Key key(snapshot.profile->id, snapshot.min_level, snapshot.max_level);
+            std::lock_guard<std::mutex> guard(_lock);
+            std::shared_ptr<AbRankingFlight> &flight = _flights[key];
+            if (!flight) {
+                flight = std::make_shared<AbRankingFlight>();
+                flight->key = key;
+                if (!_spare.empty()) {
+                    flight->top = std::move(_spare.back());
+                    _spare.pop_back();
+                }
+            }
+            ++flight->requests;
+            return flight;
+        }
+        void Leave(std::shared_ptr<AbRankingFlight> const& flight)
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            if (--flight->requests != 0)
+                return;
+            _flights.erase(flight->key);
+            // Nobody reads its rankings anymore; keep the buffers of one of them (the complete one is rarely needed):
+            if (_spare.size() < MAX_SPARE)
+                _spare.push_back(std::move(flight->top));
+        }
+    private:
+        static constexpr uint32 MAX_SPARE = 16;
+        std::mutex _lock;
+        std::map<AbRankingFlight::Key, std::shared_ptr<AbRankingFlight>> _flights;
+        std::vector<AbRankedSlots> _spare;
+};
+
+static AbRankingFlights abRankingFlights;
+
+void AutoBis::Select(AbPlayerSnapshot const& snapshot, std::vector<AbGrant> &grants, AbRankingFlight* flight)
+{
+    // Not sharing with anyone:
+    AbRankingFlight own;
+    if (!flight)
+        flight = &own;
+    bool computed = false;
+    {
+        AbPhaseTimer timer(abMetrics, AB_PHASE_SCORING);
+        std::call_once(flight->top_once, [&]() {
+            flight->from_table = GetRanking(*snapshot.profile, snapshot.min_level, snapshot.max_level, flight->top);
+            computed = true;
+        });
+    }
+    abMetrics.Add(computed ? AB_COUNTER_RANKINGS_COMPUTED : AB_COUNTER_RANKINGS_COALESCED);
+    if (Select(snapshot, flight->top, grants)) {
+        abMetrics.Add(flight->from_table ? AB_COUNTER_BIS_TABLE_HITS : AB_COUNTER_BIS_TABLE_MISSES);
+        return;
+    }
+    // The top K (from the table or not) wasn't deep enough for this player; rank everything:
+    abMetrics.Add(AB_COUNTER_BIS_TABLE_MISSES);
+    grants.clear();
+    computed = false;
+    {
+        AbPhaseTimer timer(abMetrics, AB_PHASE_SCORING);
+        std::call_once(flight->full_once, [&]() {
+            RankCandidates(*snapshot.profile, snapshot.min_level, snapshot.max_level, flight->full);
+            computed = true;
+        });
+    }
+    abMetrics.Add(computed ? AB_COUNTER_RANKINGS_COMPUTED : AB_COUNTER_RANKINGS_COALESCED);
+    Select(snapshot, flight->full, grants);
+}
+
+//
+// Rankings only depend on static data (item_template, the DBC enchant stores and the weight tables), so the top K of
+//  every (role weight profile, level, slot) is computed once and saved to a binary file. Later restarts mmap()
+//  that file instead, as long as the hash of those inputs hasn't changed; Process() then only reads a few rows.
+//
+// Layout: a Header, then one fixed-size Cell per (profile, level, slot), in that order.
+class AbBisTable {
+    public:
+        static constexpr uint32 VERSION = 2;   // 2: ench_id is 0, not a roll, when no enchant is worth anything
+        struct Header {
+            char magic[8];
+            uint32 version;
+            uint32 top_k;
+            uint64 input_hash;
+            uint32 profiles;
+            uint32 levels;
+            uint32 slots;
+            uint32 reserved;
+        };
+        struct Entry {
+            uint32 item_id;
+            int32 ench_id;
+            double score;
+        };
+        // Followed by top_k Entries:
+        struct CellHeader {
+            uint32 count;   // entries actually used
+            uint32 total;   // items in the whole bucket; more than count means the list was truncated
+        };
+
+        using Roles = std::array<AbWeightProfile const*, MAX_AB_PROFILES>;
+
+        explicit AbBisTable(std::shared_ptr<AbProfileSet const> const& set) : _set(set), _roles(set->roles) { }
+        ~AbBisTable() { Unmap(); }
+        static uint64 HashInputs(Roles const& roles, uint32 top_k);
+        static bool Write(Roles const& roles, std::string const& path, uint32 top_k, uint64 input_hash);
+        // Maps the file, if it was written for exactly these inputs, and builds the prefix index from it:
+        bool Map(std::string const& path, uint32 top_k, uint64 input_hash);
+        bool IsMapped() const { return _data != nullptr; }
+        // Top K per slot of the items with a RequiredLevel in [minLevel, maxLevel]. A single level is read straight
+        //  from the file; a range from the prefix index, so it costs the same however wide it is.
+        // return: false if "profile" isn't one of the roles the table was built for:
+        bool Fill(AbWeightProfile const& profile, uint8 minLevel, uint8 maxLevel, AbRankedSlots &ranked) const;
+    private:
+        // The top K of every level up to and including this one, merged:
+        struct PrefixEntry {
+            uint32 row;
+            int32 ench_id;
+            double score;
+        };
+        void BuildPrefixIndex();
+        static size_t CellSize(uint32 top_k) { return sizeof(CellHeader) + sizeof(Entry) * top_k; }
+        static size_t CellIndex(uint32 profileId, uint32 level, uint32 slot)
+        {
+            return (size_t(profileId) * (DEFAULT_MAX_LEVEL + 1) + level) * MAX_INVTYPE + slot;
+        }
+        void Unmap();
+
+        // Keeps the profiles _roles points to alive, so Fill() can't match a profile of some later set that happens
+        //  to be at the same address:
+        std::shared_ptr<AbProfileSet const> _set;
+        Roles _roles;
+        // Same layout as the file's cells, kept in memory (about 14 MB with the default top K of 16):
+        std::vector<CellHeader> _prefixCells;
+        std::vector<PrefixEntry> _prefixEntries;
+        char const* _data = nullptr;
+        size_t _size = 0;
+        uint32 _topK = 0;
+        uint32 _profiles = 0;
+#ifndef _WIN32
+        bool _mapped = false;
+#endif
+        std::vector<char> _buffer; // used instead of mmap() on Windows
+};
+
+static const char AB_BIS_TABLE_MAGIC[8] = { 'A', 'B', 'B', 'I', 'S', 'T', 'B', 'L' };
+// Published along with the profile set it was built for; only ever accessed through std::atomic_load()/
+//  std::atomic_store(). Unmapped once the last ranking reading it is done:
+static std::shared_ptr<AbBisTable const> abBisTable;
+
+// FNV-1a:
+static void HashBytes(uint64 &hash, void const* data, size_t size)
+{
+    uint8 const* bytes = static_cast<uint8 const*>(data);
+    for (size_t idx = 0; idx < size; ++idx) {
+        hash ^= bytes[idx];
+        hash *= 1099511628211ULL;
+    }
+}
+
+template <typename T>
+static void HashValue(uint64 &hash, T const& value)
+{
+    HashBytes(hash, &value, sizeof(value));
+}
+
+uint64 AbBisTable::HashInputs(Roles const& roles, uint32 top_k)
+{
+    uint64 hash = 14695981039346656037ULL;
+    HashValue(hash, VERSION);
+    HashValue(hash, top_k);
+    // Weight tables:
+    for (AbWeightProfile const* role : roles) {
+        const AbWeightProfile &profile = *role;
+        HashBytes(hash, profile.stats, sizeof(profile.stats));
+        HashValue(hash, profile.melee_dps);
+        HashValue(hash, profile.armor);
+        HashValue(hash, profile.ranged_dps);
+    }
+    // Items (everything the scores depend on has been folded into the features):
+    for (uint32 row = 0; row < abItemCatalog._items.size(); ++row) {
+        ItemTemplate const* itemTemplate = abItemCatalog._items[row];
+        HashValue(hash, itemTemplate->ItemId);
+        HashValue(hash, itemTemplate->RequiredLevel);
+        HashValue(hash, itemTemplate->InventoryType);
+        HashValue(hash, itemTemplate->RandomProperty);
+        HashValue(hash, itemTemplate->RandomSuffix);
+        for (uint32 c = 0; c < abItemFeatures._columnIds.size(); ++c) {
+            HashValue(hash, abItemFeatures._columnIds[c]);
+            HashValue(hash, abItemFeatures._values[size_t(c) * abItemFeatures._stride + row]);
+        }
+    }
+    // Random enchants (item_enchantment_template and the DBC stores), via the precomputed best enchants. Ids change
+    //  with every reload, so only the roles' entries are hashed, and by role rather than by id:
+    std::shared_ptr<AbBestEnchants const> store = std::atomic_load(&randomItemEnch);
+    if (store) {
+        std::vector<std::pair<uint64, AbBestEnchants::BestEnchant>> best;
+        for (uint32 role = 0; role < MAX_AB_PROFILES; ++role) {
+            for (auto const& itr : store->_best) {
+                if ((itr.first >> 48) == roles[role]->id)
+                    best.emplace_back((uint64(role) << 48) | (itr.first & ((1ULL << 48) - 1)), itr.second);
+            }
+        }
+        std::sort(best.begin(), best.end(), [](auto const& left, auto const& right) { return left.first < right.first; });
+        for (auto const& itr : best) {
+            HashValue(hash, itr.first);
+            HashValue(hash, itr.second.ench_id);
+            HashValue(hash, itr.second.score);
+        }
+    }
+    return hash;
+}
+
+bool AbBisTable::Write(Roles const& roles, std::string const& path, uint32 top_k, uint64 input_hash)
+{
+    std::string tmp_path = path + ".tmp";
+    FILE* file = fopen(tmp_path.c_str(), "wb");
+    if (!file)
+        return false;
+    Header header;
+    memcpy(header.magic, AB_BIS_TABLE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.top_k = top_k;
+    header.input_hash = input_hash;
+    header.profiles = MAX_AB_PROFILES;
+    header.levels = DEFAULT_MAX_LEVEL + 1;
+    header.slots = MAX_INVTYPE;
+    header.reserved = 0;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    std::vector<char> cell(CellSize(top_k));
+    AbRankedSlots ranked;
+    for (uint32 profileId = 0; ok && profileId < MAX_AB_PROFILES; ++profileId) {
+        for (uint32 level = 0; ok && level <= DEFAULT_MAX_LEVEL; ++level) {
+            AutoBis::RankCandidates(*roles[profileId], level, ranked);
+            for (uint32 slot = 0; ok && slot < MAX_INVTYPE; ++slot) {
+                std::fill(cell.begin(), cell.end(), 0);
+                std::vector<AbRankedSlots::Entry> const& entries = ranked.slots[slot];
+                CellHeader cell_header;
+                cell_header.count = std::min<uint32>(entries.size(), top_k);
+                cell_header.total = entries.size();
+                memcpy(cell.data(), &cell_header, sizeof(cell_header));
+                for (uint32 idx = 0; idx < cell_header.count; ++idx) {
+                    Entry entry;
+                    entry.item_id = entries[idx].item->ItemId;
+                    entry.ench_id = entries[idx].ench_id;
+                    entry.score = entries[idx].score;
+                    memcpy(cell.data() + sizeof(CellHeader) + idx * sizeof(Entry), &entry, sizeof(entry));
+                }
+                ok = fwrite(cell.data(), cell.size(), 1, file) == 1;
+            }
+        }
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (ok)
+        ok = (std::rename(tmp_path.c_str(), path.c_str()) == 0);
+    if (!ok)
+        std::remove(tmp_path.c_str());
+    return ok;
+}
+
+bool AbBisTable::Map(std::string const& path, uint32 top_k, uint64 input_hash)
+{
+    Unmap();
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    _data = static_cast<char const*>(data);
+    _size = st.st_size;
+    _mapped = true;
+#else
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    _buffer.resize(size > 0 ? size_t(size) : 0);
+    bool read_ok = size > 0 && fread(_buffer.data(), _buffer.size(), 1, file) == 1;
+    fclose(file);
+    if (!read_ok || _buffer.size() < sizeof(Header)) {
+        _buffer.clear();
+        return false;
+    }
+    _data = _buffer.data();
+    _size = _buffer.size();
+#endif
+    Header header;
+    memcpy(&header, _data, sizeof(header));
+    size_t expected = sizeof(Header) + CellSize(header.top_k) * CellIndex(header.profiles, 0, 0);
+    if (memcmp(header.magic, AB_BIS_TABLE_MAGIC, sizeof(header.magic)) != 0 || header.version != VERSION
+        || header.top_k != top_k || header.input_hash != input_hash || header.profiles != MAX_AB_PROFILES
+        || header.levels != DEFAULT_MAX_LEVEL + 1 || header.slots != MAX_INVTYPE || _size != expected) {
+        Unmap();
+        return false;
+    }
+    _topK = header.top_k;
+    _profiles = header.profiles;
+    BuildPrefixIndex();
+    return true;
+}
+
+void AbBisTable::BuildPrefixIndex()
+{
+    size_t cells = CellIndex(_profiles, 0, 0);
+    _prefixCells.assign(cells, CellHeader{ 0, 0 });
+    _prefixEntries.assign(cells * _topK, PrefixEntry{ 0, 0, 0.0 });
+    std::vector<PrefixEntry> running, level_entries, merged;
+    for (uint32 profileId = 0; profileId < _profiles; ++profileId) {
+        for (uint32 slot = 0; slot < MAX_INVTYPE; ++slot) {
+            running.clear();
+            uint32 total = 0;
+            for (uint32 level = 0; level <= DEFAULT_MAX_LEVEL; ++level) {
+                size_t index = CellIndex(profileId, level, slot);
+                char const* cell = _data + sizeof(Header) + CellSize(_topK) * index;
+                CellHeader cell_header;
+                memcpy(&cell_header, cell, sizeof(cell_header));
+                level_entries.clear();
+                for (uint32 idx = 0; idx < cell_header.count; ++idx) {
+                    Entry entry;
+                    memcpy(&entry, cell + sizeof(CellHeader) + idx * sizeof(Entry), sizeof(entry));
+                    uint32 row = abItemCatalog.RowOf(entry.item_id);
+                    level_entries.push_back(PrefixEntry{ row, entry.ench_id, entry.score });
+                }
+                // Both are sorted best first, and the top K of the union can only come from their top Ks:
+                merged.clear();
+                std::merge(running.begin(), running.end(), level_entries.begin(), level_entries.end(),
+                           std::back_inserter(merged), [](PrefixEntry const& left, PrefixEntry const& right) {
+                    return left.score > right.score;
+                });
+                if (merged.size() > _topK)
+                    merged.resize(_topK);
+                running.swap(merged);
+                total += cell_header.total;
+                _prefixCells[index] = CellHeader{ uint32(running.size()), total };
+                std::copy(running.begin(), running.end(), _prefixEntries.begin() + index * _topK);
+            }
+        }
+    }
+}
+
+void AbBisTable::Unmap()
+{
+#ifndef _WIN32
+    if (_mapped)
+        munmap(const_cast<char*>(_data), _size);
+    _mapped = false;
+#endif
+    _buffer.clear();
+    _data = nullptr;
+    _size = 0;
+}
+
+bool AbBisTable::Fill(AbWeightProfile const& profile, uint8 minLevel, uint8 maxLevel, AbRankedSlots &ranked) const
+{
+    uint32 profileId = std::find(_roles.begin(), _roles.end(), &profile) - _roles.begin();
+    if (!_data || profileId >= _profiles || maxLevel > DEFAULT_MAX_LEVEL || minLevel > maxLevel)
+        return false;
+    ranked.profile_id = profile.id;
+    ranked.min_level = minLevel;
+    ranked.level = maxLevel;
+    if (minLevel != maxLevel) {
+        for (uint32 slot = 0; slot < MAX_INVTYPE; ++slot) {
+            size_t index = CellIndex(profileId, maxLevel, slot);
+            CellHeader const& cell_header = _prefixCells[index];
+            std::vector<AbRankedSlots::Entry> &entries = ranked.slots[slot];
+            entries.clear();
+            // Dropping the entries below minLevel can only make the list shorter, so it's as truncated as before:
+            ranked.truncated[slot] = cell_header.total > cell_header.count;
+            for (uint32 idx = 0; idx < cell_header.count; ++idx) {
+                PrefixEntry const& entry = _prefixEntries[index * _topK + idx];
+                if (entry.row == AbItemCatalog::NO_ROW)
+                    return false; // can't happen as long as the input hash matched
+                ItemTemplate const* itemTemplate = abItemCatalog._items[entry.row];
+                if (itemTemplate->RequiredLevel >= minLevel)
+                    entries.push_back(AbRankedSlots::Entry{ itemTemplate, entry.score, entry.ench_id, entry.row });
+            }
+        }
+        return true;
+    }
+    uint8 level = maxLevel;
+    for (uint32 slot = 0; slot < MAX_INVTYPE; ++slot) {
+        char const* cell = _data + sizeof(Header) + CellSize(_topK) * CellIndex(profileId, level, slot);
+        CellHeader cell_header;
+        memcpy(&cell_header, cell, sizeof(cell_header));
+        std::vector<AbRankedSlots::Entry> &entries = ranked.slots[slot];
+        entries.clear();
+        ranked.truncated[slot] = cell_header.total > cell_header.count;
+        for (uint32 idx = 0; idx < cell_header.count; ++idx) {
+            Entry entry;
+            memcpy(&entry, cell + sizeof(CellHeader) + idx * sizeof(Entry), sizeof(entry));
+            uint32 row = abItemCatalog.RowOf(entry.item_id);
+            if (row == AbItemCatalog::NO_ROW)
+                return false; // can't happen as long as the input hash matched
+            entries.push_back(AbRankedSlots::Entry{ abItemCatalog._items[row], entry.score, entry.ench_id, row });
+        }
+    }
+    return true;
+}
+
+bool AutoBis::GetRanking(const AbWeightProfile &profile, uint8 minLevel, uint8 maxLevel, AbRankedSlots &ranked)
+{
+    // Only the weight tables GetWeightProfile() hands out are in the table:
+    std::shared_ptr<AbBisTable const> table = std::atomic_load(&abBisTable);
+    if (table && table->Fill(profile, minLevel, maxLevel, ranked))
+        return true;
+    RankCandidates(profile, minLevel, maxLevel, ranked, AB_RANK_DEPTH);
+    return false;
+}
+
+// return: the table for "set", or nullptr if it's disabled or can't be written:
+static std::shared_ptr<AbBisTable const> LoadBisTable(std::shared_ptr<AbProfileSet const> const& set)
+{
+    if (!sConfigMgr->GetBoolDefault("AutoBis.BisTable.Enable", true))
+        return nullptr;
+    std::string path = sConfigMgr->GetStringDefault("AutoBis.BisTable.Path", "autobis_bis.tbl");
+    uint32 top_k = std::max(sConfigMgr->GetIntDefault("AutoBis.BisTable.TopK", 16), 2);
+    uint64 input_hash = AbBisTable::HashInputs(set->roles, top_k);
+    std::shared_ptr<AbBisTable> table = std::make_shared<AbBisTable>(set);
+    if (table->Map(path, top_k, input_hash)) {
+        printf("AutoBis: mapped the precomputed BiS table from %s.\n", path.c_str());
+        return table;
+    }
+    // NOTE: rename() over a file some older table still has mapped is fine; that mapping keeps the old contents:
+    if (!AbBisTable::Write(set->roles, path, top_k, input_hash) || !table->Map(path, top_k, input_hash)) {
+        printf("AutoBis: couldn't write the precomputed BiS table to %s; rankings will be computed per request.\n",
+               path.c_str());
+        return nullptr;
+    }
+    printf("AutoBis: computed the BiS table (top %u per slot) and saved it to %s.\n", top_k, path.c_str());
+    return table;
+}
+
+// The only place that decides whether "items" can all be given, and where: each one must pass the core's unique and
+//  limit category checks (CanTakeMoreSimilarItems()), counting the ones planned before it too, since the core only
+//  sees what's already stored; then it takes the first free slot, backpack first and then the equipped bags in
+//  order, of a bag that accepts it (see ItemCanGoIntoBag()).
+// return: EQUIP_ERR_OK with one position per item in "plan", or why "offending" can't be given; nothing has been
+//  stored either way:
+static InventoryResult PlanGrants(Player *player, std::vector<Item*> const& items, std::vector<ItemPosCountVec> &plan,
+                                  uint32 &offending)
+{
+    struct FreeSlot {
+        uint8 bag;
+        uint8 slot;
+        ItemTemplate const* bagTemplate;    // nullptr for the backpack
+        bool taken;
+    };
+    std::vector<FreeSlot> free_slots;
+    for (uint8 slot = INVENTORY_SLOT_ITEM_START; slot < INVENTORY_SLOT_ITEM_END; ++slot) {
+        if (!player->GetItemByPos(INVENTORY_SLOT_BAG_0, slot))
+            free_slots.push_back(FreeSlot{ uint8(INVENTORY_SLOT_BAG_0), slot, nullptr, false });
+    }
+    for (uint8 bagSlot = INVENTORY_SLOT_BAG_START; bagSlot < INVENTORY_SLOT_BAG_END; ++bagSlot) {
+        Bag* bag = player->GetBagByPos(bagSlot);
+        if (!bag)
+            continue;
+        for (uint32 slot = 0; slot < bag->GetBagSize(); ++slot) {
+            if (!bag->GetItemByPos(slot))
+                free_slots.push_back(FreeSlot{ bagSlot, uint8(slot), bag->GetTemplate(), false });
+        }
+    }
+    plan.clear();
+    std::map<uint32, uint32> planned_entries;       // by item entry
+    std::map<uint32, uint32> planned_categories;    // by ItemLimitCategory, "have" ones only
+    for (Item* item : items) {
+        InventoryResult msg = player->CanTakeMoreSimilarItems(item, &offending);
+        if (msg != EQUIP_ERR_OK)
+            return msg;
+        ItemTemplate const* proto = item->GetTemplate();
+        uint32 &planned_entry = planned_entries[proto->ItemId];
+        if (proto->MaxCount > 0
+            && player->GetItemCount(proto->ItemId, true) + planned_entry + 1 > uint32(proto->MaxCount)) {
+            offending = proto->ItemId;
+            return EQUIP_ERR_CANT_CARRY_MORE_OF_THIS;
+        }
+        ++planned_entry;
+        if (proto->ItemLimitCategory) {
+            ItemLimitCategoryEntry const* limitEntry = sItemLimitCategoryStore.LookupEntry(proto->ItemLimitCategory);
+            if (limitEntry && limitEntry->mode == ITEM_LIMIT_CATEGORY_MODE_HAVE) {
+                uint32 &planned_category = planned_categories[proto->ItemLimitCategory];
+                if (player->GetItemCountWithLimitCategory(proto->ItemLimitCategory) + planned_category + 1
+                    > limitEntry->maxCount) {
+                    offending = proto->ItemId;
+                    return EQUIP_ERR_ITEM_MAX_LIMIT_CATEGORY_COUNT_EXCEEDED_IS;
+                }
+                ++planned_category;
+            }
+        }
+        auto fiter = std::find_if(free_slots.begin(), free_slots.end(), [item](FreeSlot const& free_slot) {
+            return !free_slot.taken
+                && (!free_slot.bagTemplate || ItemCanGoIntoBag(item->GetTemplate(), free_slot.bagTemplate));
+        });
+        if (fiter == free_slots.end()) {
+            offending = item->GetEntry();
+            return EQUIP_ERR_INVENTORY_FULL;
+        }
+        fiter->taken = true;
+        plan.push_back(ItemPosCountVec(1, ItemPosCount(uint16((fiter->bag << 8) | fiter->slot), 1)));
+    }
+    return EQUIP_ERR_OK;
+}
+
+bool AutoBis::ApplyGrants(Player *player, ChatHandler* handler, std::vector<AbGrant> const& grants)
+{
+    AbPhaseTimer timer(abMetrics, AB_PHASE_GRANTS);
+    if (grants.empty())
+        return true;
+    // 1. Create every item up front, so that they can be checked and placed all at once:
+    std::vector<Item*> items;
+    items.reserve(grants.size());
+    uint32 offending = 0;
+    InventoryResult msg = EQUIP_ERR_OK;
+    for (AbGrant const& grant : grants) {
+        Item* item = Item::CreateItem(grant.item_id, 1, player);
+        if (!item) {
+            msg = EQUIP_ERR_ITEM_NOT_FOUND;
+            offending = grant.item_id;
+            break;
+        }
+        items.push_back(item);
+    }
+    // 2. Decide where each of them goes before storing any:
+    std::vector<ItemPosCountVec> plan;
+    if (msg == EQUIP_ERR_OK)
+        msg = PlanGrants(player, items, plan, offending);
+    // All or nothing:
+    if (msg != EQUIP_ERR_OK) {
+        // NOTE: nothing has been done to these yet that would have queued them for saving, so they can just go:
+        for (Item* item : items)
+            delete item;
+        abMetrics.Add(AB_COUNTER_GRANTS_REJECTED);
+        player->SendEquipError(msg, nullptr, nullptr, offending);
+        handler->PSendSysMessage(LANG_ITEM_CANNOT_CREATE, offending, 1);
+        std::ostringstream out;
+        out << "autobis: your " << grants.size() << " upgrades don't all fit in your bags; none were given.";
+        handler->SendSysMessage(out.str().c_str());
+        return false;
+    }
+    // 3. Store them all, doing what StoreNewItem() does besides storing (random properties go on before the item
+    //  is stored, so it enters the inventory complete). A random-stat item nobody picked a property for still
+    //  rolls one, like any other created item would:
+    for (uint32 idx = 0; idx < items.size(); ++idx) {
+        int32 ench_id = grants[idx].ench_id;
+        ItemTemplate const* itemTemplate = items[idx]->GetTemplate();
+        if (!ench_id && (itemTemplate->RandomProperty || itemTemplate->RandomSuffix))
+            ench_id = GenerateItemRandomPropertyId(grants[idx].item_id);
+        if (ench_id)
+            items[idx]->SetItemRandomProperties(ench_id);
+        player->ItemAddedQuestCheck(grants[idx].item_id, 1);
+        player->UpdateAchievementCriteria(ACHIEVEMENT_CRITERIA_TYPE_RECEIVE_EPIC_ITEM, grants[idx].item_id, 1);
+        player->UpdateAchievementCriteria(ACHIEVEMENT_CRITERIA_TYPE_OWN_ITEM, grants[idx].item_id, 1);
+        items[idx] = player->StoreItem(plan[idx], items[idx], true);
+    }
+    // 4. Save just the new items, in one transaction, and only then tell the client. Item::SaveToDB() writes the
+    //  item_instance row; the character_inventory row is otherwise only written by Player::_SaveInventory(), which
+    //  skips items SaveToDB() has already marked unchanged, so it's written here too:
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    for (Item* item : items) {
+        Bag* container = item->GetContainer();
+        CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_REP_INVENTORY_ITEM);
+        stmt->setUInt32(0, player->GetGUID().GetCounter());
+        stmt->setUInt32(1, container ? container->GetGUID().GetCounter() : 0);
+        stmt->setUInt8(2, item->GetSlot());
+        stmt->setUInt32(3, item->GetGUID().GetCounter());
+        trans->Append(stmt);
+        item->SaveToDB(trans);
+    }
+    CharacterDatabase.CommitTransaction(trans);
+    abMetrics.Add(AB_COUNTER_DB_QUERIES);
+    for (Item* item : items)
+        player->SendNewItem(item, 1, false, true);
+    abMetrics.Add(AB_COUNTER_ITEMS_GRANTED, items.size());
+    return true;
+}
+
+// Players with a request somewhere between TakeSnapshot() and ApplyGrants(). Only touched on the world thread
+//  (chat commands and AbCompletionQueue::Drain() both run there), so it needs no lock:
+static std::unordered_set<ObjectGuid> abInFlight;
+// Level ranges of queued requests that asked for one (".autobis upto" and such), until they're dispatched:
+static std::unordered_map<ObjectGuid, AbLevelRange> abQueuedRanges;
+static AbWorkerPool abWorkers;
+static AbCompletionQueue abCompletions;
+static AbAdmission abAdmission;
+
+//
+// ".autobis loadtest": fires synthetic requests at a fixed rate and reports what world ticks looked like meanwhile,
+//  compared to a couple of idle seconds beforehand. Each synthetic request is a clone of a player who was online when
+//  the test started (round robin), asking for the items of a pseudo-random level in the test's range, and goes down
+//  the same path as a real one: the live admission controller (with an account of its own, so the per-account rate
+//  limit doesn't apply), StartRequest(), and from there the worker pool or the time slicer, snapshotting the player
+//  it clones on the world thread. Only the end differs: nothing is handed out; the grants are counted, along with the
+//  character DB transaction ApplyGrants() would have committed for each request that got any. Synthetic requests
+//  have GUIDs of their own, past any real character's, so they don't get in the way of the player they clone.
+class AbLoadTest {
+    public:
+        struct Config {
+            uint32 requests = 1000;
+            uint32 per_second = 200;
+            uint8 min_level = 10;
+            uint8 max_level = 80;
+        };
+        // World thread; starts synthetic request "guid" against "player", the way StartRequest() would:
+        using Starter = std::function<void(ObjectGuid guid, Player *player, AbLevelRange const& range)>;
+
+        static bool IsSynthetic(ObjectGuid guid) { return guid.GetCounter() >= FIRST_COUNTER; }
+
+        bool IsRunning() const { return _running; }
+        // "sources" are the players to clone:
+        void Start(Config const& config, ObjectGuid requester, std::vector<ObjectGuid> const& sources, Starter start);
+        // Stops firing; whatever's in flight or queued still completes, and then the report goes out:
+        void Stop() { _stopping = true; }
+        // Once per world tick:
+        void Update(uint32 diff);
+        void Progress(std::vector<std::string> &lines) const;
+        // The player synthetic request "guid" is a clone of, if they're still online:
+        Player* GetSource(ObjectGuid guid) const;
+        AbLevelRange GetRange(ObjectGuid guid) const;
+        // Synthetic request "guid" ended, with what it would have granted; real requests are ignored:
+        void Completed(ObjectGuid guid, std::vector<AbGrant> const& grants);
+        // Synthetic request "guid" couldn't start because the player it clones logged out; real ones are ignored:
+        void Dropped(ObjectGuid guid);
+    private:
+        static constexpr uint32 IDLE_MS = 2000;
+        static constexpr uint32 FIRST_COUNTER = 0xFFF00000;    // room for HandleLoadTest()'s 1000000 requests
+
+        // return: the sequence number of synthetic request "guid", or -1 if it isn't one of this run's:
+        int32 GetSeq(ObjectGuid guid) const;
+        void Finish();
+
+        Config _config;
+        ObjectGuid _requester;
+        std::vector<ObjectGuid> _sources;
+        Starter _start;
+        bool _running = false;
+        bool _stopping = false;
+        uint32 _elapsed = 0;            // ms since Start()
+        double _credit = 0.0;           // requests due but not fired yet
+        uint32 _fired = 0;
+        uint32 _rejected = 0;
+        uint32 _dropped = 0;
+        uint32 _completed = 0;
+        uint64 _granted = 0;
+        uint32 _transactions = 0;
+        uint64 _dbQueries = 0;          // AB_COUNTER_DB_QUERIES when firing started
+        std::vector<AbMetrics::Clock::time_point> _submitted;
+        AbMetrics::Clock::time_point _firingStarted;
+        AbLatencyHistogram _idleTicks;  // world tick durations, before firing
+        AbLatencyHistogram _loadTicks;  // the same, from the first request to the last completion
+        AbLatencyHistogram _latency;    // submission to completion, queueing included
+};
+
+static AbLoadTest abLoadTest;
+
+// The player a request runs against: its own, or for a load test request, the one it's a clone of:
+static Player* FindRequestPlayer(ObjectGuid guid)
+{
+    return AbLoadTest::IsSynthetic(guid) ? abLoadTest.GetSource(guid) : ObjectAccessor::FindPlayer(guid);
+}
+
+// Every request that StartRequest() took on ends here, once, after its grants were applied (or not):
+static void EndRequest(ObjectGuid guid, std::vector<AbGrant> const& grants, AbMetrics::Clock::time_point started)
+{
+    abInFlight.erase(guid);
+    abAdmission.Finished();
+    abLoadTest.Completed(guid, grants);
+    abMetrics.Record(AB_PHASE_REQUEST, started);
+}
+
+//
+// Time-sliced requests, for servers that run without worker threads (AutoBis.Async.Threads = 0) and would rather not
+//  stall a tick on a big request. Each request steps through the same phases as TakeSnapshot() and Select() (owned
+//  items, candidates one RequiredLevel at a time, ranking one slot at a time, selection, grants), and every world
+//  tick the requests in progress take turns, one step each, until AutoBis.TimeSlice.BudgetUs is spent. At least one
+//  step runs per tick, so a budget that's too small still makes progress. World thread only.
+struct AbSlicedRequest {
+    enum Stage {
+        STAGE_HAVE_SCAN,
+        STAGE_CANDIDATES,
+        STAGE_RANKING,          // from the BiS table when it can, else on to STAGE_RANK_SLOTS
+        STAGE_RANK_SLOTS,
+        STAGE_SELECT,
+        STAGE_GRANTS,
+    };
+    ObjectGuid guid;
+    AbLevelRange range;
+    AbMetrics::Clock::time_point started;
+    Stage stage = STAGE_HAVE_SCAN;
+    uint32 cursor = 0;          // level of STAGE_CANDIDATES, slot of STAGE_RANK_SLOTS
+    uint32 slices = 0;
+    bool from_table = false;
+    uint32 depth = AB_RANK_DEPTH;   // of STAGE_RANK_SLOTS; 0 once that wasn't deep enough
+    AbPlayerSnapshot snapshot;
+    AbRankedSlots ranked;
+    std::vector<AbGrant> grants;
+};
+
+class AbTimeSlicer {
+    public:
+        void SetBudget(uint32 micros) { _budget = micros; }
+        uint32 GetBudget() const { return _budget; }
+        bool IsEnabled() const { return _budget != 0; }
+        void Add(ObjectGuid guid, AbLevelRange const& range, AbMetrics::Clock::time_point started)
+        {
+            _requests.emplace_back();
+            AbSlicedRequest &request = _requests.back();
+            request.guid = guid;
+            request.range = range;
+            request.started = started;
+        }
+        uint32 GetInProgress() const { return _requests.size(); }
+        uint64 GetFinished() const { return _finished; }
+        uint64 GetSlices() const { return _slices; }
+        // Round robin, one step per turn, until the budget's spent; "done" is called for every request that finished:
+        void Update(std::function<bool(AbSlicedRequest &request)> const& step,
+                    std::function<void(AbSlicedRequest &request)> const& done);
+    private:
+        uint32 _budget = 0;     // us per tick; 0 = run requests inline, in one go
+        std::deque<AbSlicedRequest> _requests;
+        uint64 _finished = 0;
+        uint64 _slices = 0;     // of the finished requests
+};
+
+static AbTimeSlicer abTimeSlicer;
+
+void AbTimeSlicer::Update(std::function<bool(AbSlicedRequest &request)> const& step,
+                          std::function<void(AbSlicedRequest &request)> const& done)
+{
+    if (_requests.empty())
+        return;
+    AbMetrics::Clock::time_point started = AbMetrics::Clock::now();
+    AbMetrics::Clock::time_point deadline = started + std::chrono::microseconds(_budget);
+    do {
+        abMetrics.Add(AB_COUNTER_SLICES);
+        ++_requests.front().slices;
+        if (step(_requests.front())) {
+            _slices += _requests.front().slices;
+            done(_requests.front());
+            _requests.pop_front();
+            ++_finished;
+        } else {
+            _requests.push_back(std::move(_requests.front()));
+            _requests.pop_front();
+        }
+    } while (!_requests.empty() && AbMetrics::Clock::now() < deadline);
+    if (!_requests.empty())
+        abMetrics.Add(AB_COUNTER_SLICE_BUDGET_EXHAUSTED);
+    abMetrics.Record(AB_PHASE_SLICED_TICK, started);
+}
+
+static void LoadAdmissionConfig()
+{
+    AbAdmission::Config config;
+    config.max_in_flight = sConfigMgr->GetIntDefault("AutoBis.Admission.MaxInFlight", 16);
+    config.queue_depth = sConfigMgr->GetIntDefault("AutoBis.Admission.QueueDepth", 200);
+    config.dispatch_per_tick = sConfigMgr->GetIntDefault("AutoBis.Admission.DispatchPerTick", 8);
+    config.bucket_burst = sConfigMgr->GetIntDefault("AutoBis.RateLimit.Burst", 5);
+    config.bucket_per_minute = sConfigMgr->GetFloatDefault("AutoBis.RateLimit.PerMinute", 10.0f);
+    abAdmission.SetConfig(config);
+    abTimeSlicer.SetBudget(std::max(sConfigMgr->GetIntDefault("AutoBis.TimeSlice.BudgetUs", 0), 0));
+}
+
+// Every request admitted by abAdmission ends up here, exactly once, and in EndRequest() when it's done. "guid" is the
+//  request's: "player"'s own, or a load test's synthetic one (which is never granted anything):
+bool AutoBis::StartRequest(ObjectGuid guid, Player *player, ChatHandler* handler, AbLevelRange const& range)
+{
+    AbMetrics::Clock::time_point started = AbMetrics::Clock::now();
+    abMetrics.Add(AB_COUNTER_REQUESTS);
+    if (!abWorkers.IsRunning() && abTimeSlicer.IsEnabled()) {
+        abInFlight.insert(guid);
+        abTimeSlicer.Add(guid, range, started);
+        return true;
+    }
+    // 1. Snapshot everything we need from the player, here on the world thread:
+    std::shared_ptr<AbPlayerSnapshot> snapshot = std::make_shared<AbPlayerSnapshot>();
+    if (!TakeSnapshot(player, *snapshot, range)) {
+        EndRequest(guid, std::vector<AbGrant>(), started);
+        return true;
+    }
+    snapshot->guid = guid;
+    if (!abWorkers.IsRunning()) {
+        std::vector<AbGrant> grants;
+        Select(*snapshot, grants);
+        bool result = AbLoadTest::IsSynthetic(guid) || ApplyGrants(player, handler, grants);
+        EndRequest(guid, grants, started);
+        return result;
+    }
+    // 2. Score and select on a worker thread, against data that never changes after startup, sharing the ranking with
+    //  any other request in flight that needs the same one...
+    abInFlight.insert(guid);
+    std::shared_ptr<AbRankingFlight> flight = abRankingFlights.Join(*snapshot);
+    abWorkers.Enqueue([snapshot, flight, started]() {
+        std::shared_ptr<std::vector<AbGrant>> grants = std::make_shared<std::vector<AbGrant>>();
+        Select(*snapshot, *grants, flight.get());
+        abRankingFlights.Leave(flight);
+        // 3. ...and hand out the items back on the world thread, if the player is still around (a synthetic GUID
+        //  never finds one):
+        abCompletions.Post([snapshot, grants, started]() {
+            if (Player* player = ObjectAccessor::FindPlayer(snapshot->guid)) {
+                ChatHandler handler(player->GetSession());
+                ApplyGrants(player, &handler, *grants);
+            }
+            EndRequest(snapshot->guid, *grants, started);
+        });
+    });
+    return true;
+}
+
+bool AutoBis::StepSliced(AbSlicedRequest &request)
+{
+    Player* player = FindRequestPlayer(request.guid);
+    if (!player)
+        return true;
+    AbPlayerSnapshot &snapshot = request.snapshot;
+    switch (request.stage) {
+        case AbSlicedRequest::STAGE_HAVE_SCAN: {
+            if (!StartSnapshot(player, snapshot, request.range))
+                return true;
+            AbPhaseTimer timer(abMetrics, AB_PHASE_HAVE_SCAN);
+            CollectHaveItems(player, snapshot);
+            snapshot.guid = request.guid;
+            request.cursor = snapshot.min_level;
+            request.stage = AbSlicedRequest::STAGE_CANDIDATES;
+            return false;
+        }
+        case AbSlicedRequest::STAGE_CANDIDATES: {
+            AbPhaseTimer timer(abMetrics, AB_PHASE_CANDIDATES);
+            AddCandidates(player, snapshot, request.cursor);
+            if (++request.cursor <= snapshot.max_level)
+                return false;
+            if (snapshot.candidate_rows.empty())
+                return true;
+            request.stage = AbSlicedRequest::STAGE_RANKING;
+            return false;
+        }
+        case AbSlicedRequest::STAGE_RANKING: {
+            AbPhaseTimer timer(abMetrics, AB_PHASE_SCORING);
+            std::shared_ptr<AbBisTable const> table = std::atomic_load(&abBisTable);
+            request.from_table = table && table->Fill(*snapshot.profile, snapshot.min_level, snapshot.max_level,
+                                                      request.ranked);
+            if (!request.from_table) {
+                abMetrics.Add(AB_COUNTER_BIS_TABLE_MISSES);
+                request.ranked.profile_id = snapshot.profile->id;
+                request.ranked.min_level = snapshot.min_level;
+                request.ranked.level = snapshot.max_level;
+                request.ranked.truncated.fill(false);
+                request.cursor = 0;
+                request.stage = AbSlicedRequest::STAGE_RANK_SLOTS;
+            } else
+                request.stage = AbSlicedRequest::STAGE_SELECT;
+            return false;
+        }
+        case AbSlicedRequest::STAGE_RANK_SLOTS: {
+            AbPhaseTimer timer(abMetrics, AB_PHASE_SCORING);
+            request.ranked.truncated[request.cursor] = RankSlot(*snapshot.profile, snapshot.min_level,
+                                                                snapshot.max_level, request.cursor,
+                                                                request.ranked.slots[request.cursor], request.depth);
+            if (++request.cursor == MAX_INVTYPE)
+                request.stage = AbSlicedRequest::STAGE_SELECT;
+            return false;
+        }
+        case AbSlicedRequest::STAGE_SELECT:
+            request.grants.clear();
+            if (!Select(snapshot, request.ranked, request.grants)) {
+                // The top K (from the table or not) wasn't deep enough for this player; rank everything after all:
+                abMetrics.Add(AB_COUNTER_BIS_TABLE_MISSES);
+                request.from_table = false;
+                request.depth = 0;
+                request.ranked.truncated.fill(false);
+                request.cursor = 0;
+                request.stage = AbSlicedRequest::STAGE_RANK_SLOTS;
+                return false;
+            }
+            if (request.from_table)
+                abMetrics.Add(AB_COUNTER_BIS_TABLE_HITS);
+            request.stage = AbSlicedRequest::STAGE_GRANTS;
+            return false;
+        case AbSlicedRequest::STAGE_GRANTS:
+        default: {
+            if (!AbLoadTest::IsSynthetic(request.guid)) {
+                ChatHandler handler(player->GetSession());
+                ApplyGrants(player, &handler, request.grants);
+            }
+            return true;
+        }
+    }
+}
+
+void AutoBis::UpdateSliced()
+{
+    abTimeSlicer.Update(StepSliced, [](AbSlicedRequest &request) {
+        EndRequest(request.guid, request.grants, request.started);
+    });
+}
+
+void AutoBis::DispatchQueued()
+{
+    abAdmission.Update([](ObjectGuid guid) {
+        AbLevelRange range;
+        auto fiter = abQueuedRanges.find(guid);
+        if (fiter != abQueuedRanges.end()) {
+            range = fiter->second;
+            abQueuedRanges.erase(fiter);
+        } else if (AbLoadTest::IsSynthetic(guid))
+            range = abLoadTest.GetRange(guid);
+        Player* player = FindRequestPlayer(guid);
+        if (!player) {
+            abLoadTest.Dropped(guid);
+            return false;
+        }
+        ChatHandler handler(player->GetSession());
+        StartRequest(guid, player, &handler, range);
+        return true;
+    });
+}
+
+// ".autobis group" / ".autobis online": gear many players at once. Players are grouped by everything that decides
+//  what they could be handed, and each group's candidates get ranked once, on a worker thread. After that, every
+//  player only pays for comparing against what they own, and for the grants. Nothing in here asks admission control
+//  for a slot; this is a GM tool.
+bool AutoBis::HandleBulk(ChatHandler* handler, std::vector<Player*> const& players)
+{
+    if (!abItemCatalog._loaded) {
+        printf("INTERNAL ERROR: item catalog not loaded; is AddSC_autobis() being called?\n");
+        return true;
+    }
+    struct BulkGroup {
+        AbRankedSlots ranked;
+        std::vector<AbPlayerSnapshot> snapshots;
+        std::vector<std::vector<AbGrant>> grants;
+    };
+    // (class, weight profile, level, dual wield, Titan's Grip):
+    std::map<std::tuple<uint8, uint32, uint8, bool, bool>, std::shared_ptr<BulkGroup>> groups;
+    uint32 count = 0, busy = 0;
+    for (Player* player : players) {
+        if (abInFlight.find(player->GetGUID()) != abInFlight.end() || abAdmission.IsQueued(player->GetGUID())) {
+            ++busy;
+            continue;
+        }
+        AbPlayerSnapshot snapshot;
+        if (!TakeSnapshot(player, snapshot))
+            continue;
+        auto key = std::make_tuple(player->GetClass(), snapshot.profile->id, snapshot.level, snapshot.oh_dual,
+                                   snapshot.titans_grip);
+        std::shared_ptr<BulkGroup> &group = groups[key];
+        if (!group)
+            group = std::make_shared<BulkGroup>();
+        group->snapshots.push_back(std::move(snapshot));
+        ++count;
+    }
+    for (auto &itr : groups) {
+        std::shared_ptr<BulkGroup> group = itr.second;
+        for (AbPlayerSnapshot const& snapshot : group->snapshots)
+            abInFlight.insert(snapshot.guid);
+        auto work = [group]() {
+            AbPlayerSnapshot const& first = group->snapshots.front();
+            bool from_table;
+            {
+                AbPhaseTimer timer(abMetrics, AB_PHASE_SCORING);
+                from_table = GetRanking(*first.profile, first.min_level, first.max_level, group->ranked);
+            }
+            abMetrics.Add(from_table ? AB_COUNTER_BIS_TABLE_HITS : AB_COUNTER_BIS_TABLE_MISSES);
+            bool complete = false;
+            group->grants.resize(group->snapshots.size());
+            for (uint32 idx = 0; idx < group->snapshots.size(); ++idx) {
+                if (Select(group->snapshots[idx], group->ranked, group->grants[idx]))
+                    continue;
+                // Not deep enough; rank everything once, for the rest of the group too:
+                if (!complete) {
+                    abMetrics.Add(AB_COUNTER_BIS_TABLE_MISSES);
+                    AbPhaseTimer timer(abMetrics, AB_PHASE_SCORING);
+                    RankCandidates(*first.profile, first.min_level, first.max_level, group->ranked);
+                    complete = true;
+                }
+                group->grants[idx].clear();
+                Select(group->snapshots[idx], group->ranked, group->grants[idx]);
+            }
+        };
+        auto apply = [group]() {
+            for (uint32 idx = 0; idx < group->snapshots.size(); ++idx) {
+                abInFlight.erase(group->snapshots[idx].guid);
+                if (Player* player = ObjectAccessor::FindPlayer(group->snapshots[idx].guid)) {
+                    ChatHandler player_handler(player->GetSession());
+                    ApplyGrants(player, &player_handler, group->grants[idx]);
+                }
+            }
+        };
+        if (abWorkers.IsRunning()) {
+            abWorkers.Enqueue([work, apply]() {
+                work();
+                abCompletions.Post(apply);
+            });
+        } else {
+            work();
+            apply();
+        }
+    }
+    std::ostringstream out;
+    out << "autobis: gearing " << count << " players in " << groups.size() << " groups";
+    if (busy)
+        out << " (" << busy << " skipped: already running)";
+    out << ".";
+    handler->SendSysMessage(out.str().c_str());
+    return true;
+}
+
+static bool HandleQueueStats(ChatHandler* handler)
+{
+    AbAdmission::Stats const& stats = abAdmission.GetStats();
+    AbAdmission::Config const& config = abAdmission.GetConfig();
+    std::ostringstream out;
+    out << "autobis admission: in flight " << abAdmission.GetInFlight() << "/" << config.max_in_flight
+        << ", queued " << abAdmission.GetQueueDepth() << "/" << config.queue_depth
+        << " (max seen " << stats.max_queue_depth << ")";
+    handler->SendSysMessage(out.str().c_str());
+    out.str("");
+    out << "  admitted " << stats.admitted << ", queued " << stats.queued
+        << ", dispatched from queue " << stats.dispatched_from_queue
+        << ", dropped from queue " << stats.dropped_from_queue;
+    handler->SendSysMessage(out.str().c_str());
+    out.str("");
+    out << "  rejected: rate limited " << stats.rejected_rate_limited << ", queue full " << stats.rejected_queue_full;
+    handler->SendSysMessage(out.str().c_str());
+    out.str("");
+    out << "  queue wait: avg "
+        << (stats.dispatched_from_queue ? stats.total_wait_ms / stats.dispatched_from_queue : 0)
+        << " ms, max " << stats.max_wait_ms << " ms";
+    handler->SendSysMessage(out.str().c_str());
+    if (abTimeSlicer.IsEnabled() || abTimeSlicer.GetInProgress()) {
+        uint64 finished = abTimeSlicer.GetFinished();
+        out.str("");
+        out << "  time-sliced: " << abTimeSlicer.GetInProgress() << " in progress, budget "
+            << abTimeSlicer.GetBudget() << " us/tick, " << finished << " finished, "
+            << (finished ? abTimeSlicer.GetSlices() / finished : 0) << " slices per request, "
+            << abMetrics.Get(AB_COUNTER_SLICE_BUDGET_EXHAUSTED) << " ticks over budget";
+        handler->SendSysMessage(out.str().c_str());
+    }
+    return true;
+}
+
+static void ReportMetrics(std::vector<std::string> &lines)
+{
+    abMetrics.Report(lines);
+    uint64 hits = abScoreCache._hits.load(std::memory_order_relaxed);
+    uint64 misses = abScoreCache._misses.load(std::memory_order_relaxed);
+    std::ostringstream out;
+    out << "score cache: " << hits << " hits, " << misses << " misses";
+    if (hits + misses)
+        out << " (" << (100 * hits / (hits + misses)) << "% hit rate)";
+    lines.push_back(out.str());
+}
+
+//
+// ".autobis bench [iterations] [update]": times the scoring engine against the loaded catalog, with synthetic players,
+//  and checks its results against a golden file so that a speed-up can't silently change what gets handed out. A
+//  missing or empty golden file is an error; "update" (re)writes it from this run instead. Runs on the world thread
+//  and stalls it for a while, so only use it on a test server. tools/autobis_bench does the same without a server.
+bool AutoBis::HandleBench(ChatHandler* handler, std::string const& args)
+{
+    uint32 iterations = 1;
+    bool update = false;
+    std::istringstream words(args);
+    for (std::string word; words >> word; ) {
+        if (word == "update")
+            update = true;
+        else if (atoi(word.c_str()) > 0)
+            iterations = std::min(atoi(word.c_str()), 100);
+        else
+            return false;
+    }
+    Player* player = handler->GetSession()->GetPlayer();
+    ItemList const& items = abItemCatalog._items;
+    // The weight tables GetWeightProfile() hands out, so the golden file changes whenever a reload changes them:
+    std::shared_ptr<AbProfileSet const> set = CurrentProfiles();
+    std::array<AbWeightProfile const*, MAX_AB_PROFILES> const& roles = set->roles;
+    std::vector<std::string> golden;
+    std::ostringstream out;
+    auto report = [handler, &out](char const* name, uint64 ops, AbMetrics::Clock::time_point started) {
+        uint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(AbMetrics::Clock::now() - started).count();
+        out.str("");
+        out << "autobis bench: " << name << ": " << ops << " ops, " << (ops ? ns / ops : 0) << " ns/op";
+        handler->SendSysMessage(out.str().c_str());
+        printf("AutoBis %s\n", out.str().c_str() + strlen("autobis "));
+    };
+    char line[64];
+    // ComputePawnScore(), uncached; the golden file gets one hash of every item's score per weight table:
+    AbMetrics::Clock::time_point started = AbMetrics::Clock::now();
+    for (uint32 iteration = 0; iteration < iterations; ++iteration) {
+        for (AbWeightProfile const* role : roles) {
+            const AbWeightProfile &profile = *role;
+            uint64 hash = 14695981039346656037ULL;
+            for (ItemTemplate const* itemTemplate : items) {
+                double score = ComputePawnScore(profile, itemTemplate);
+                if (iteration == 0) {
+                    snprintf(line, sizeof(line), "%u %.4f", itemTemplate->ItemId, score);
+                    HashBytes(hash, line, strlen(line));
+                }
+            }
+            if (iteration == 0) {
+                snprintf(line, sizeof(line), "score %s %016llx", profile.name, (unsigned long long)hash);
+                golden.push_back(line);
+            }
+        }
+    }
+    report("ComputePawnScore", uint64(iterations) * MAX_AB_PROFILES * items.size(), started);
+    // CalculateBestRandomEnchant(), for the items that have one:
+    uint64 ops = 0;
+    started = AbMetrics::Clock::now();
+    for (uint32 iteration = 0; iteration < iterations; ++iteration) {
+        for (AbWeightProfile const* role : roles) {
+            const AbWeightProfile &profile = *role;
+            for (uint32 row = 0; row < items.size(); ++row) {
+                if (!abItemFeatures._hasRandomEnchant[row])
+                    continue;
+                int32 enchId;
+                CalculateBestRandomEnchant(profile, items[row], enchId);
+                ++ops;
+            }
+        }
+    }
+    report("CalculateBestRandomEnchant", ops, started);
+    // PlayerCanUseItem(), against whoever ran the command:
+    uint32 usable = 0;
+    started = AbMetrics::Clock::now();
+    for (uint32 iteration = 0; iteration < iterations; ++iteration) {
+        for (ItemTemplate const* itemTemplate : items)
+            usable += PlayerCanUseItem(player, itemTemplate);
+    }
+    report("PlayerCanUseItem", uint64(iterations) * items.size(), started);
+    // Full selection, per weight table and level; the golden file gets every grant. Synthetic players own a fixed,
+    //  pseudo-random handful of catalog items at their level, and can use every candidate. That keeps the numbers and
+    //  the golden file independent of whoever runs the command:
+    auto make_snapshot = [](AbWeightProfile const& profile, uint8 level, AbPlayerSnapshot &snapshot) {
+        snapshot = AbPlayerSnapshot();
+        snapshot.level = level;
+        snapshot.min_level = level;
+        snapshot.max_level = level;
+        snapshot.profile = &profile;
+        for (AbItemCatalog::Range const& range : abItemCatalog.GetLevel(level)) {
+            for (uint32 row = range.first; row < range.last; ++row)
+                snapshot.candidate_rows.push_back(row);
+        }
+        std::sort(snapshot.candidate_rows.begin(), snapshot.candidate_rows.end());
+        uint32 seed = profile.id * 7919 + level;
+        for (uint32 idx = 0; idx < 20 && !snapshot.candidate_rows.empty(); ++idx) {
+            seed = seed * 1103515245 + 12345;
+            uint32 row = snapshot.candidate_rows[(seed >> 8) % snapshot.candidate_rows.size()];
+            ItemTemplate const* itemTemplate = abItemCatalog._items[row];
+            uint32 inv_type = itemTemplate->InventoryType;
+            AdjustInvType(false, inv_type);
+            int32 enchId;
+            snapshot.have_items[inv_type].Push(itemTemplate, ScoreItem(profile, itemTemplate, enchId));
+            snapshot.owned_rows.push_back(row);
+        }
+        std::sort(snapshot.owned_rows.begin(), snapshot.owned_rows.end());
+    };
+    ops = 0;
+    AbPlayerSnapshot snapshot;
+    started = AbMetrics::Clock::now();
+    for (AbWeightProfile const* role : roles) {
+        const AbWeightProfile &profile = *role;
+        for (uint8 level = 10; level <= DEFAULT_MAX_LEVEL; level += 10) {
+            make_snapshot(profile, level, snapshot);
+            std::vector<AbGrant> grants;
+            for (uint32 iteration = 0; iteration < iterations; ++iteration) {
+                grants.clear();
+                Select(snapshot, grants);
+                ++ops;
+            }
+            std::ostringstream selected;
+            selected << "select " << profile.name << " " << uint32(level);
+            for (AbGrant const& grant : grants)
+                selected << " " << grant.item_id << ":" << grant.ench_id;
+            golden.push_back(selected.str());
+        }
+    }
+    report("Select", ops, started);
+    // Golden results:
+    std::string path = sConfigMgr->GetStringDefault("AutoBis.Bench.GoldenPath", "autobis_bench.golden");
+    out.str("");
+    if (update) {
+        bool written = AbWriteLines(path, golden);
+        out << "autobis bench: " << (written ? "wrote " : "couldn't write ") << golden.size()
+            << " golden results to " << path << ".";
+        handler->SendSysMessage(out.str().c_str());
+        if (!written)
+            handler->SetSentErrorMessage(true);
+        return written;
+    }
+    std::vector<std::string> expected;
+    if (!AbReadLines(path, expected) || expected.empty()) {
+        printf("AutoBis bench: no golden results in %s.\n", path.c_str());
+        out << "autobis bench: no golden results in " << path << "; \".autobis bench update\" writes them.";
+        handler->SendSysMessage(out.str().c_str());
+        handler->SetSentErrorMessage(true);
+        return false;
+    }
+    uint32 mismatches = 0;
+    for (uint32 idx = 0; idx < std::max(golden.size(), expected.size()); ++idx) {
+        std::string const got = idx < golden.size() ? golden[idx] : "(missing)";
+        std::string const want = idx < expected.size() ? expected[idx] : "(missing)";
+        if (got == want)
+            continue;
+        if (++mismatches <= 5) {
+            printf("AutoBis bench: golden mismatch: expected \"%s\"; got \"%s\"\n", want.c_str(), got.c_str());
+            handler->SendSysMessage(("autobis bench: expected \"" + want + "\"; got \"" + got + "\"").c_str());
+        }
+    }
+    out << "autobis bench: " << golden.size() << " golden results checked, " << mismatches << " mismatches"
+        << " (you can use " << usable / iterations << " of " << items.size() << " catalog items).";
+    handler->SendSysMessage(out.str().c_str());
+    if (mismatches)
+        handler->SetSentErrorMessage(true);
+    return !mismatches;
+}
+
+// Files named in chat (".autobis analyze", ".autobis export") are confined to AutoBis.Analyze.OutputDir: only relative
+//  names without any ".." component are accepted.
+// return: the path to use, "" if "name" isn't acceptable:
+static std::string AnalyzePath(std::string const& name)
+{
+    if (name.empty() || name[0] == '/' || name[0] == '\\' || name.find(':') != std::string::npos)
+        return "";
+    for (std::string::size_type start = 0; start <= name.size(); ) {
+        std::string::size_type end = std::min(name.find_first_of("/\\", start), name.size());
+        if (name.compare(start, end - start, "..") == 0)
+            return "";
+        start = end + 1;
+    }
+    std::string dir = sConfigMgr->GetStringDefault("AutoBis.Analyze.OutputDir", ".");
+    return (dir.empty() ? std::string(".") : dir) + "/" + name;
+}
+
+//
+// ".autobis analyze [file] [baseline]": the best item per (class, weight table, level, slot), for tuning the weight
+//  tables (see AbAnalyze()). Runs on a worker, using all cores. With a baseline report, the changed lines are also
+//  written to "file.diff". Both files are under AutoBis.Analyze.OutputDir (see AnalyzePath()).
+bool AutoBis::HandleAnalyze(ChatHandler* handler, std::string const& args)
+{
+    static std::atomic<bool> running{false};
+    std::istringstream in(args);
+    std::string name, baselineName;
+    in >> name >> baselineName;
+    if (name.empty())
+        name = "autobis_analysis.txt";
+    std::string path = AnalyzePath(name);
+    std::string baseline = baselineName.empty() ? std::string() : AnalyzePath(baselineName);
+    if (path.empty() || (!baselineName.empty() && baseline.empty())) {
+        handler->SendSysMessage("autobis analyze: files must be under AutoBis.Analyze.OutputDir (no \"..\").");
+        return true;
+    }
+    if (running.exchange(true)) {
+        handler->SendSysMessage("autobis analyze: an analysis is already running.");
+        return true;
+    }
+    ObjectGuid requester = handler->GetSession()->GetPlayer()->GetGUID();
+    std::shared_ptr<AbProfileSet const> set = CurrentProfiles();
+    auto work = [path, baseline, requester, set]() {
+        AbMetrics::Clock::time_point started = AbMetrics::Clock::now();
+        uint32 threads = sConfigMgr->GetIntDefault("AutoBis.Analyze.Threads", 0);
+        if (!threads)
+            threads = std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<std::string> lines;
+        AbAnalyze(ScoringContext(), set->roles.data(), threads, lines);
+        // Report, then the diff against the baseline:
+        uint32 changed = 0;
+        bool written = AbWriteLines(path, lines);
+        if (written && !baseline.empty()) {
+            std::vector<std::string> before, diff;
+            AbReadLines(baseline, before);
+            changed = AbDiffAnalysis(lines, before, diff);
+            AbWriteLines(path + ".diff", diff);
+        }
+        uint64 ms = std::chrono::duration_cast<std::chrono::milliseconds>(AbMetrics::Clock::now() - started).count();
+        std::ostringstream out;
+        if (!written)
+            out << "autobis analyze: couldn't write " << path << ".";
+        else {
+            out << "autobis analyze: wrote " << lines.size() << " lines to " << path << " in " << ms << " ms on "
+                << threads << " threads";
+            if (!baseline.empty())
+                out << "; " << changed << " slots changed against " << baseline << " (see " << path << ".diff)";
+            out << ".";
+        }
+        std::string message = out.str();
+        printf("AutoBis: %s\n", message.c_str() + strlen("autobis "));
+        abCompletions.Post([requester, message]() {
+            running = false;
+            if (Player* player = ObjectAccessor::FindPlayer(requester))
+                ChatHandler(player->GetSession()).SendSysMessage(message.c_str());
+        });
+    };
+    handler->SendSysMessage("autobis analyze: started; you'll be told when it's done.");
+    if (abWorkers.IsRunning())
+        abWorkers.Enqueue(work);
+    else
+        work();
+    return true;
+}
+
+// "stat:value,stat:value,...":
+static std::string FormatExportStats(AbScoreData::Stat const* first, AbScoreData::Stat const* last)
+{
+    std::string stats;
+    for (AbScoreData::Stat const* stat = first; stat != last; ++stat)
+        stats += (stats.empty() ? "" : ",") + std::to_string(stat->stat_id) + ":" + std::to_string(stat->value);
+    return stats;
+}
+
+//
+// ".autobis export [dir]": what tools/autobis_analyze needs to rank items without a server, as tab-separated files
+//  (with a header line) in "dir" (default autobis_export, under AutoBis.Analyze.OutputDir):
+//  - item_template.tsv, item_enchantment_template.tsv: the columns of the tables they're named after that autobis
+//    reads, so they may as well come from "mysql --batch";
+//  - autobis_equip_spells.tsv, autobis_random_enchants.tsv, autobis_suffix_factors.tsv: what SpellMgr and the DBC
+//    stores say about those, as AbServerScoreData sees it.
+static bool HandleExport(ChatHandler* handler, std::string const& args)
+{
+    std::istringstream in(args);
+    std::string name;
+    in >> name;
+    if (name.empty())
+        name = "autobis_export";
+    std::string dir = AnalyzePath(name);
+    if (dir.empty()) {
+        handler->SendSysMessage("autobis export: the directory must be under AutoBis.Analyze.OutputDir (no \"..\").");
+        return true;
+    }
+#ifndef _WIN32
+    bool created = mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+#else
+    bool created = _mkdir(dir.c_str()) == 0 || errno == EEXIST;
+#endif
+    std::vector<std::string> items, enchantments, spells, enchants, factors;
+    items.push_back("entry\tname\tclass\tsubclass\tQuality\tFlagsExtra\tInventoryType\tAllowableClass\tItemLevel"
+                    "\tRequiredLevel\tRequiredReputationFaction\tSellPrice\tarmor\tblock\tdelay\tdmg_min1\tdmg_max1"
+                    "\tStatsCount");
+    for (uint32 idx = 1; idx <= MAX_ITEM_PROTO_STATS; ++idx)
+        items.back() += "\tstat_type" + std::to_string(idx) + "\tstat_value" + std::to_string(idx);
+    for (uint32 idx = 1; idx <= MAX_ITEM_PROTO_SPELLS; ++idx)
+        items.back() += "\tspellid_" + std::to_string(idx) + "\tspelltrigger_" + std::to_string(idx);
+    items.back() += "\tRandomProperty\tRandomSuffix";
+    factors.push_back("entry\tfactor");
+    char buffer[512];
+    for (auto const& itr : sObjectMgr->GetItemTemplateStore()) {
+        ItemTemplate const* t = &itr.second;
+        snprintf(buffer, sizeof(buffer), "%u\t%s\t%u\t%u\t%u\t%u\t%u\t%d\t%u\t%u\t%u\t%u\t%u\t%u\t%u\t%.9g\t%.9g\t%u",
+                 t->ItemId, t->Name1.c_str(), t->Class, t->SubClass, t->Quality, t->Flags2, t->InventoryType,
+                 t->AllowableClass, t->ItemLevel, t->RequiredLevel, t->RequiredReputationFaction, t->SellPrice,
+                 t->Armor, t->Block, t->Delay, t->Damage[0].DamageMin, t->Damage[0].DamageMax, t->StatsCount);
+        std::string line = buffer;
+        for (uint32 idx = 0; idx < MAX_ITEM_PROTO_STATS; ++idx)
+            line += "\t" + std::to_string(t->ItemStat[idx].ItemStatType) + "\t"
+                    + std::to_string(t->ItemStat[idx].ItemStatValue);
+        for (uint32 idx = 0; idx < MAX_ITEM_PROTO_SPELLS; ++idx)
+            line += "\t" + std::to_string(t->Spells[idx].SpellId) + "\t" + std::to_string(t->Spells[idx].SpellTrigger);
+        line += "\t" + std::to_string(t->RandomProperty) + "\t" + std::to_string(t->RandomSuffix);
+        items.push_back(line);
+        if (t->RandomSuffix)
+            factors.push_back(std::to_string(t->ItemId) + "\t" + std::to_string(abScoreData.GetSuffixFactor(t)));
+    }
+    enchantments.push_back("entry\tench\tchance");
+    //                                                 0      1      2
+    QueryResult result = WorldDatabase.Query("SELECT entry, ench, chance FROM item_enchantment_template");
+    abMetrics.Add(AB_COUNTER_DB_QUERIES);
+    if (result) {
+        do {
+            Field* fields = result->Fetch();
+            snprintf(buffer, sizeof(buffer), "%u\t%u\t%.9g", fields[0].GetUInt32(), fields[1].GetUInt32(),
+                     fields[2].GetFloat());
+            enchantments.push_back(buffer);
+        } while (result->NextRow());
+    }
+    enchants.push_back("suffix\tench\tstats");
+    std::set<uint32> seen;
+    for (auto const& pool : abScoreData._pools) {
+        for (uint32 ench : pool.second) {
+            if (!seen.insert(ench).second)
+                continue;
+            // Pools don't say whether they're properties or suffixes; the items using them do:
+            for (bool rand_suffix : { false, true }) {
+                AbScoreData::RandomEnchant enchant;
+                if (abScoreData.GetRandomEnchant(ench, rand_suffix, enchant))
+                    enchants.push_back(std::string(rand_suffix ? "1" : "0") + "\t" + std::to_string(ench) + "\t"
+                                       + FormatExportStats(enchant.stats, enchant.stats + enchant.count));
+            }
+        }
+    }
+    spells.push_back("spell\tstats");
+    for (auto const& spell : abScoreData._spells) {
+        AbScoreData::Stat const* first = abScoreData._stats.data() + spell.second.first;
+        AbScoreData::Stat const* last = abScoreData._stats.data() + spell.second.second;
+        spells.push_back(std::to_string(spell.first) + "\t" + FormatExportStats(first, last));
+    }
+    bool written = created && AbWriteLines(dir + "/item_template.tsv", items)
+                   && AbWriteLines(dir + "/item_enchantment_template.tsv", enchantments)
+                   && AbWriteLines(dir + "/autobis_equip_spells.tsv", spells)
+                   && AbWriteLines(dir + "/autobis_random_enchants.tsv", enchants)
+                   && AbWriteLines(dir + "/autobis_suffix_factors.tsv", factors);
+    std::ostringstream out;
+    if (!written)
+        out << "autobis export: couldn't write to " << dir << ".";
+    else
+        out << "autobis export: wrote " << items.size() - 1 << " item templates, " << enchants.size() - 1
+            << " random enchants and " << spells.size() - 1 << " equip spells to " << dir << ".";
+    handler->SendSysMessage(out.str().c_str());
+    return true;
+}
+
+// Reads "path", or AutoBis.Profiles.Path if empty ("" = only the built-in weight tables).
+// return: nullptr, with "errors" set, if the file can't be used:
+static std::shared_ptr<AbProfileSet> ReadProfileSet(std::string path, std::vector<std::string> &errors)
+{
+    if (path.empty())
+        path = sConfigMgr->GetStringDefault("AutoBis.Profiles.Path", "");
+    std::vector<AbPawnScale> scales;
+    if (!path.empty()) {
+        std::vector<std::string> ignored;
+        if (!LoadPawnScales(path, scales, errors, ignored))
+            return nullptr;
+        std::string list;
+        for (std::string const& stat : ignored)
+            list += (list.empty() ? "" : ", ") + stat;
+        if (!list.empty())
+            printf("AutoBis: %s: ignored Pawn stats AutoBis doesn't weigh: %s\n", path.c_str(), list.c_str());
+    }
+    std::shared_ptr<AbProfileSet> set = BuildProfileSet(scales, path.empty() ? "built-in" : path);
+    for (uint32 role = 0; role < MAX_AB_PROFILES; ++role) {
+        if (set->roles[role] != &set->profiles[role])
+            printf("AutoBis: %s uses \"%s\".\n", abWeightProfiles[role].name, set->roles[role]->name);
+    }
+    return set;
+}
+
+// Precomputes the best enchants of "set" into a new store and builds a new BiS table, then publishes all three and
+//  drops the scores and owned item lists computed with the previous profiles. Nothing is locked: a request that already got a profile from the previous set keeps it (and its set) alive and
+//  keeps scoring with it. Its enchants aren't in the new store and its BiS table is no longer used, so it computes
+//  them from scratch. Whatever was published before is freed once nothing uses it anymore.
+static void PublishProfiles(std::shared_ptr<AbProfileSet const> const& set)
+{
+    std::shared_ptr<AbBestEnchants> enchStore = std::make_shared<AbBestEnchants>();
+    enchStore->Precompute(abScoreData, abItemCatalog._items, set->profiles.data(), set->profiles.size());
+    std::atomic_store(&randomItemEnch, std::shared_ptr<AbBestEnchants const>(enchStore));
+    std::atomic_store(&abBisTable, LoadBisTable(set));
+    std::atomic_store(&abProfiles, set);
+    abScoreCache.Invalidate();
+    abOwnedIndex._generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ".autobis reload [path]": swaps in the weight tables from a Pawn Wowhead.lua (by default AutoBis.Profiles.Path).
+//  The file is parsed and everything derived from it rebuilt on a worker; if anything's wrong with it, the tables
+//  in use are left alone and the errors are reported instead.
+static bool HandleReload(ChatHandler* handler, std::string const& args)
+{
+    static std::atomic<bool> running{false};
+    std::istringstream in(args);
+    std::string path;
+    in >> path;
+    if (running.exchange(true)) {
+        handler->SendSysMessage("autobis reload: a reload is already running.");
+        return true;
+    }
+    ObjectGuid requester = handler->GetSession()->GetPlayer()->GetGUID();
+    auto work = [path, requester]() {
+        std::vector<std::string> errors;
+        std::vector<std::string> messages;
+        std::shared_ptr<AbProfileSet> set = ReadProfileSet(path, errors);
+        if (!set) {
+            messages.push_back("autobis reload: kept the current weight tables; " + std::to_string(errors.size())
+                               + " errors:");
+            for (uint32 idx = 0; idx < errors.size() && idx < 5; ++idx)
+                messages.push_back("  " + errors[idx]);
+        } else {
+            PublishProfiles(set);
+            uint32 replaced = 0;
+            for (uint32 role = 0; role < MAX_AB_PROFILES; ++role)
+                replaced += (set->roles[role] != &set->profiles[role]);
+            messages.push_back("autobis reload: loaded " + std::to_string(set->profiles.size() - MAX_AB_PROFILES)
+                               + " weight tables from " + set->source + "; " + std::to_string(replaced) + " of "
+                               + std::to_string(uint32(MAX_AB_PROFILES)) + " built-in ones replaced.");
+        }
+        for (std::string const& message : messages)
+            printf("AutoBis: %s\n", message.c_str() + strlen("autobis "));
+        abCompletions.Post([requester, messages]() {
+            running = false;
+            if (Player* player = ObjectAccessor::FindPlayer(requester)) {
+                for (std::string const& message : messages)
+                    ChatHandler(player->GetSession()).SendSysMessage(message.c_str());
+            }
+        });
+    };
+    if (abWorkers.IsRunning())
+        abWorkers.Enqueue(work);
+    else
+        work();
+    return true;
+}
+
+// ".autobis weights [show|set <weights>|reset]": your own weight table, in Pawn's stat names, instead of the one
+//  picked from your talents:
+bool AutoBis::HandleWeights(ChatHandler* handler, std::string const& args)
+{
+    Player* player = handler->GetSession()->GetPlayer();
+    std::string action = args.substr(0, args.find(' '));
+    std::string rest = action.size() < args.size() ? args.substr(action.size() + 1) : std::string();
+    ScoreWeightMap weights;
+    if (action == "set") {
+        std::string error;
+        if (!AbParsePawnWeights(rest, weights, error)) {
+            handler->SendSysMessage(("autobis weights: " + error + ".").c_str());
+            handler->SendSysMessage("autobis weights: e.g. .autobis weights set Strength=1 HitRating=0.8 Dps=3");
+            return true;
+        }
+        abCustomWeights.Set(player->GetGUID(), weights);
+        handler->SendSysMessage(("autobis weights: now using " + AbFormatPawnWeights(weights) + ".").c_str());
+    } else if (action == "reset") {
+        abCustomWeights.Reset(player->GetGUID());
+        handler->SendSysMessage(("autobis weights: back to the built-in " + std::string(GetWeightProfile(player)->name)
+                                 + " table.").c_str());
+    } else if (action.empty() || action == "show") {
+        if (abCustomWeights.GetWeights(player->GetGUID(), weights))
+            handler->SendSysMessage(("autobis weights: " + AbFormatPawnWeights(weights)).c_str());
+        else {
+            std::string name = GetWeightProfile(player)->name;
+            handler->SendSysMessage(("autobis weights: using the built-in " + name + " table, from your talents.")
+                                    .c_str());
+        }
+    } else
+        return false;
+    return true;
+}
+
+// ".autobis stats [reset]":
+static bool HandleStats(ChatHandler* handler, std::string const& args)
+{
+    if (args == "reset") {
+        abMetrics.Reset();
+        handler->SendSysMessage("autobis: statistics reset.");
+        return true;
+    }
+    std::vector<std::string> lines;
+    ReportMetrics(lines);
+    for (std::string const& line : lines)
+        handler->SendSysMessage(("autobis " + line).c_str());
+    return true;
+}
+
+// "<min>-<max>", both RequiredLevels, inclusive:
+static bool ParseLevelRange(std::string const& text, AbLevelRange &range)
+{
+    unsigned int min_level, max_level;
+    char trailing;
+    if (sscanf(text.c_str(), "%u-%u%c", &min_level, &max_level, &trailing) != 2 || min_level > max_level
+        || max_level > DEFAULT_MAX_LEVEL)
+        return false;
+    range.min = uint8(min_level);
+    range.max = uint8(max_level);
+    return true;
+}
+
+void AbLoadTest::Start(Config const& config, ObjectGuid requester, std::vector<ObjectGuid> const& sources,
+                       Starter start)
+{
+    _config = config;
+    _requester = requester;
+    _sources = sources;
+    _start = std::move(start);
+    _running = true;
+    _stopping = false;
+    _elapsed = 0;
+    _credit = 0.0;
+    _fired = _rejected = _dropped = _completed = _transactions = 0;
+    _granted = 0;
+    _submitted.assign(config.requests, AbMetrics::Clock::time_point());
+    _idleTicks.Reset();
+    _loadTicks.Reset();
+    _latency.Reset();
+}
+
+int32 AbLoadTest::GetSeq(ObjectGuid guid) const
+{
+    if (!_running || !IsSynthetic(guid) || guid.GetCounter() - FIRST_COUNTER >= _fired)
+        return -1;
+    return int32(guid.GetCounter() - FIRST_COUNTER);
+}
+
+Player* AbLoadTest::GetSource(ObjectGuid guid) const
+{
+    int32 seq = GetSeq(guid);
+    if (seq < 0 || _sources.empty())
+        return nullptr;
+    return ObjectAccessor::FindPlayer(_sources[seq % _sources.size()]);
+}
+
+AbLevelRange AbLoadTest::GetRange(ObjectGuid guid) const
+{
+    // Picked by sequence number, so that two runs with the same arguments and players see the same mix:
+    uint32 seed = (guid.GetCounter() - FIRST_COUNTER) * 2654435761u + 12345;
+    seed = seed * 1103515245 + 12345;
+    AbLevelRange range;
+    range.min = range.max = uint8(_config.min_level + (seed >> 8) % (_config.max_level - _config.min_level + 1));
+    return range;
+}
+
+void AbLoadTest::Completed(ObjectGuid guid, std::vector<AbGrant> const& grants)
+{
+    int32 seq = GetSeq(guid);
+    if (seq < 0)
+        return;
+    ++_completed;
+    _latency.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+        AbMetrics::Clock::now() - _submitted[seq]).count());
+    if (!grants.empty()) {
+        _granted += grants.size();
+        ++_transactions;
+    }
+}
+
+void AbLoadTest::Dropped(ObjectGuid guid)
+{
+    if (GetSeq(guid) >= 0)
+        ++_dropped;
+}
+
+void AbLoadTest::Update(uint32 diff)
+{
+    if (!_running)
+        return;
+    AbMetrics::Clock::time_point started = AbMetrics::Clock::now();
+    bool firing = _elapsed >= IDLE_MS;
+    _elapsed += diff;
+    if (!firing) {
+        _idleTicks.Record(uint64(diff) * 1000);
+        if (_elapsed < IDLE_MS)
+            return;
+        _firingStarted = started;
+        _dbQueries = abMetrics.Get(AB_COUNTER_DB_QUERIES);
+        diff = _elapsed - IDLE_MS;
+    } else
+        _loadTicks.Record(uint64(diff) * 1000);
+    // Fire whatever's due by now, through the live admission controller; each synthetic request has an account of
+    //  its own. Queued ones are started by AutoBis::DispatchQueued(), like everyone else's:
+    if (!_stopping) {
+        _credit += _config.per_second * diff / 1000.0;
+        for (; _credit >= 1.0 && _fired < _config.requests; _credit -= 1.0) {
+            uint32 seq = _fired++;
+            ObjectGuid guid(HighGuid::Player, FIRST_COUNTER + seq);
+            _submitted[seq] = AbMetrics::Clock::now();
+            uint32 position;
+            switch (abAdmission.Submit(guid, guid.GetCounter(), position)) {
+                case AbAdmission::ADMIT_NOW:
+                    if (Player* player = GetSource(guid))
+                        _start(guid, player, GetRange(guid));
+                    else {
+                        abAdmission.Finished();
+                        ++_dropped;
+                    }
+                    break;
+                case AbAdmission::ADMIT_QUEUED:
+                    break;
+                default:
+                    ++_rejected;
+                    break;
+            }
+        }
+        if (_fired == _config.requests)
+            _stopping = true;
+    }
+    if (_stopping && _completed + _rejected + _dropped == _fired)
+        Finish();
+}
+
+static void AppendSummary(std::ostringstream &out, AbLatencyHistogram::Summary const& summary)
+{
+    out << "n=" << summary.count << " p50=" << summary.p50 << "us p95=" << summary.p95 << "us p99=" << summary.p99
+        << "us max=" << summary.max << "us";
+}
+
+void AbLoadTest::Progress(std::vector<std::string> &lines) const
+{
+    std::ostringstream out;
+    out << "loadtest: " << _fired << "/" << _config.requests << " fired, " << _completed << " completed, "
+        << _rejected << " rejected, " << _dropped << " dropped, " << abAdmission.GetInFlight() << " in flight, "
+        << abAdmission.GetQueueDepth() << " queued (real requests included)";
+    lines.push_back(out.str());
+}
+
+void AbLoadTest::Finish()
+{
+    _running = false;
+    double seconds = std::chrono::duration<double>(AbMetrics::Clock::now() - _firingStarted).count();
+    std::vector<std::string> lines;
+    std::ostringstream out;
+    out << "loadtest: " << _fired << " requests at " << _config.per_second << "/s (levels " << uint32(_config.min_level)
+        << "-" << uint32(_config.max_level) << ", cloning " << _sources.size() << " players): " << _completed
+        << " completed, " << _rejected << " rejected, " << _dropped << " dropped in " << std::fixed
+        << std::setprecision(1) << seconds << "s, " << (seconds > 0.0 ? _completed / seconds : 0.0) << " requests/s";
+    lines.push_back(out.str());
+    out.str("");
+    out << "  world tick, idle: ";
+    AppendSummary(out, _idleTicks.Summarize());
+    lines.push_back(out.str());
+    out.str("");
+    out << "  world tick, under load: ";
+    AppendSummary(out, _loadTicks.Summarize());
+    lines.push_back(out.str());
+    out.str("");
+    out << "  request latency: ";
+    AppendSummary(out, _latency.Summarize());
+    lines.push_back(out.str());
+    out.str("");
+    out << "  " << _granted << " items would have been granted, in " << _transactions << " character DB transactions; "
+        << abMetrics.Get(AB_COUNTER_DB_QUERIES) - _dbQueries << " other DB queries";
+    lines.push_back(out.str());
+    Player* player = ObjectAccessor::FindPlayer(_requester);
+    for (std::string const& line : lines) {
+        printf("AutoBis %s\n", line.c_str());
+        if (player)
+            ChatHandler(player->GetSession()).SendSysMessage(("autobis " + line).c_str());
+    }
+}
+
+bool AutoBis::HandleLoadTest(ChatHandler* handler, std::string const& args)
+{
+    if (args == "stop" || args == "status") {
+        if (!abLoadTest.IsRunning()) {
+            handler->SendSysMessage("autobis loadtest: not running.");
+            return true;
+        }
+        if (args == "stop")
+            abLoadTest.Stop();
+        std::vector<std::string> lines;
+        abLoadTest.Progress(lines);
+        for (std::string const& line : lines)
+            handler->SendSysMessage(("autobis " + line).c_str());
+        return true;
+    }
+    if (abLoadTest.IsRunning()) {
+        handler->SendSysMessage("autobis loadtest: a load test is already running; '.autobis loadtest stop' ends it.");
+        return true;
+    }
+    AbLoadTest::Config config;
+    std::istringstream in(args);
+    uint32 requests, per_second;
+    std::string range;
+    if (in >> requests) {
+        config.requests = requests;
+        if (in >> per_second) {
+            config.per_second = per_second;
+            in >> range;
+        }
+    }
+    AbLevelRange levels;
+    if (!range.empty()) {
+        if (!ParseLevelRange(range, levels) || levels.min < 1) {
+            handler->SendSysMessage("autobis loadtest: the level range should look like 10-80.");
+            return true;
+        }
+        config.min_level = levels.min;
+        config.max_level = levels.max;
+    }
+    config.requests = std::min<uint32>(config.requests, 1000000);
+    config.per_second = std::max<uint32>(config.per_second, 1);
+    // The players to clone: everyone online who could run the command themselves:
+    std::vector<ObjectGuid> sources;
+    for (auto const& itr : sWorld->GetAllSessions()) {
+        Player* player = itr.second->GetPlayer();
+        if (player && player->IsInWorld() && player->GetLevel() >= 2)
+            sources.push_back(player->GetGUID());
+    }
+    if (sources.empty()) {
+        handler->SendSysMessage("autobis loadtest: there's no one online of level 2 or more to clone.");
+        return true;
+    }
+    abLoadTest.Start(config, handler->GetSession()->GetPlayer()->GetGUID(), sources,
+                     [](ObjectGuid guid, Player *player, AbLevelRange const& range) {
+        ChatHandler player_handler(player->GetSession());
+        StartRequest(guid, player, &player_handler, range);
+    });
+    std::ostringstream out;
+    out << "autobis loadtest: measuring idle ticks, then firing " << config.requests << " requests at "
+        << config.per_second << "/s, cloning " << sources.size() << " online players. The report goes to you and the "
+        << "server console.";
+    handler->SendSysMessage(out.str().c_str());
+    return true;
+}
+
+bool AutoBis::Process(ChatHandler* handler, char const* args)
+{
+    std::string subcommand = (args && *args) ? std::string(args) : std::string();
+    std::string subargs;
+    auto space = std::find_if(subcommand.begin(), subcommand.end(), [](char c) { return c == ' '; });
+    if (space != subcommand.end())
+        subargs.assign(space + 1, subcommand.end());
+    subcommand.erase(space, subcommand.end());
+    if (subcommand == "queue")
+        return HandleQueueStats(handler);
+    else if (subcommand == "stats")
+        return HandleStats(handler, subargs);
+    else if (subcommand == "bench")
+        return HandleBench(handler, subargs);
+    else if (subcommand == "analyze")
+        return HandleAnalyze(handler, subargs);
+    else if (subcommand == "export")
+        return HandleExport(handler, subargs);
+    else if (subcommand == "reload")
+        return HandleReload(handler, subargs);
+    else if (subcommand == "weights")
+        return HandleWeights(handler, subargs);
+    else if (subcommand == "loadtest")
+        return HandleLoadTest(handler, subargs);
+    else if (subcommand == "group") {
+        Player* leader = handler->GetSession()->GetPlayer();
+        std::vector<Player*> players;
+        if (Group* group = leader->GetGroup()) {
+            for (GroupReference* itr = group->GetFirstMember(); itr != nullptr; itr = itr->next()) {
+                if (Player* member = itr->GetSource())
+                    players.push_back(member);
+            }
+        } else
+            players.push_back(leader);
+        return HandleBulk(handler, players);
+    } else if (subcommand == "online") {
+        std::vector<Player*> players;
+        for (auto const& itr : sWorld->GetAllSessions()) {
+            Player* player = itr.second->GetPlayer();
+            if (player && player->IsInWorld())
+                players.push_back(player);
+        }
+        return HandleBulk(handler, players);
+    }
+    // Items up to the player's level ("upto"), or with a RequiredLevel in "<min>-<max>", instead of exactly at it:
+    AbLevelRange range;
+    if (subcommand == "upto")
+        range.min = 0;
+    else if (!subcommand.empty() && !ParseLevelRange(subcommand, range))
+        return false;
+    Player* player = handler->GetSession()->GetPlayer();
+    if (player->GetLevel() < 2)
+        return true;
+    if (!abItemCatalog._loaded) {
+        printf("INTERNAL ERROR: item catalog not loaded; is AddSC_autobis() being called?\n");
+        return true;
+    }
+    if (abInFlight.find(player->GetGUID()) != abInFlight.end() || abAdmission.IsQueued(player->GetGUID())) {
+        handler->SendSysMessage("autobis is still working on your previous request.");
+        return true;
+    }
+    uint32 position = 0;
+    switch (abAdmission.Submit(player->GetGUID(), handler->GetSession()->GetAccountId(), position)) {
+        case AbAdmission::ADMIT_NOW:
+            return StartRequest(player->GetGUID(), player, handler, range);
+        case AbAdmission::ADMIT_QUEUED:
+            if (!range.IsDefault())
+                abQueuedRanges[player->GetGUID()] = range;
+            handler->SendSysMessage(("autobis: queued, position " + std::to_string(position) + ".").c_str());
+            return true;
+        case AbAdmission::REJECT_RATE_LIMITED:
+            handler->SendSysMessage("autobis: you're using this command too often; please wait a bit.");
+            return true;
+        case AbAdmission::REJECT_QUEUE_FULL:
+        default:
+            handler->SendSysMessage("autobis: the server is busy; please try again later.");
+            return true;
+    }
+}
+
+void AutoBis::LoadStaticData()
+{
+    // (PublishProfiles(), below, invalidates the score cache and the owned item index.)
+    abScoreCache.SetMaxEntries(sConfigMgr->GetIntDefault("AutoBis.ScoreCache.MaxEntries", 131072));
+    abOwnedIndex._enabled = sConfigMgr->GetBoolDefault("AutoBis.OwnedIndex.Enable", false);
+    AutoBis::ItemList templates;
+    for (auto const& itr : sObjectMgr->GetItemTemplateStore())
+        templates.push_back(&itr.second);
+    abScoreData.LoadEquipSpellStats(templates);
+    abScoreData.LoadRandomEnchantmentsTable();
+    abSpecResolver.Load();
+    abItemCatalog.Load(templates);
+    abItemFeatures.Load(abScoreData, abItemCatalog._items);
+    printf("AutoBis: loaded %u candidate items into the item catalog (%u feature columns).\n",
+           uint32(abItemCatalog._items.size()), uint32(abItemFeatures._columnIds.size()));
+    std::vector<std::string> errors;
+    std::shared_ptr<AbProfileSet> set = ReadProfileSet("", errors);
+    for (std::string const& error : errors)
+        printf("AutoBis: Wowhead.lua: %s\n", error.c_str());
+    if (!set) {
+        printf("AutoBis: couldn't load the weight tables; using the built-in ones.\n");
+        set = BuildProfileSet(std::vector<AbPawnScale>(), "built-in");
+    }
+    PublishProfiles(set);
+    printf("AutoBis: loaded %u random enchantment pools (%u precomputed best enchants).\n",
+           uint32(abScoreData._pools.size()), uint32(std::atomic_load(&randomItemEnch)->_best.size()));
+#ifdef AUTOBIS_SELFTEST
+    SelfTestFeatures();
+#endif
+}
+
+class autobis_worldscript : public WorldScript
+{
+public:
+    autobis_worldscript() : WorldScript("autobis_worldscript") { }
+
+    // Everything AutoBis needs that only depends on static data gets built here, once item_template, the DBC
+    //  stores and the spells have been loaded:
+    void OnStartup() override
+    {
+        AutoBis::LoadStaticData();
+        LoadAdmissionConfig();
+        LoadMetricsConfig();
+        abCustomWeights.LoadConfig();
+        abWorkers.Start(sConfigMgr->GetIntDefault("AutoBis.Async.Threads", 2));
+    }
+
+    // Only called on ".reload config"; at startup it runs before scripts are loaded, so OnStartup() reads all of
+    //  this too:
+    void OnConfigLoad(bool reload) override
+    {
+        if (!reload)
+            return;
+        LoadAdmissionConfig();
+        LoadMetricsConfig();
+        abCustomWeights.LoadConfig();
+    }
+
+    void OnUpdate(uint32 diff) override
+    {
+        abCompletions.Drain();
+        AutoBis::DispatchQueued();
+        AutoBis::UpdateSliced();
+        abLoadTest.Update(diff);
+        abCustomWeights.Update(diff);
+        if (_metricsInterval) {
+            _metricsElapsed += diff;
+            if (_metricsElapsed >= _metricsInterval) {
+                _metricsElapsed = 0;
+                std::vector<std::string> lines;
+                ReportMetrics(lines);
+                for (std::string const& line : lines)
+                    printf("AutoBis: %s\n", line.c_str());
+            }
+        }
+    }
+
+    void OnShutdown() override
+    {
+        abCustomWeights.Flush();
+        abWorkers.Stop();
+    }
+
+private:
+    void LoadMetricsConfig()
+    {
+        _metricsInterval = std::max(sConfigMgr->GetIntDefault("AutoBis.Metrics.LogInterval", 0), 0) * 1000;
+    }
+
+    uint32 _metricsInterval = 0;   // ms; 0 = never
+    uint32 _metricsElapsed = 0;
+};
+
+class autobis_playerscript : public PlayerScript
+{
+public:
+    autobis_playerscript() : PlayerScript("autobis_playerscript") { }
+
+    void OnLogin(Player* player, bool /*firstLogin*/) override
+    {
+        abCustomWeights.Load(player);
+    }
+
+    void OnLogout(Player* player) override
+    {
+        AutoBis::ForgetPlayer(player);
+        abSpecResolver.Forget(player->GetGUID());
+        abCustomWeights.Forget(player->GetGUID());
+    }
+
+    // Learning a talent spends a free point; leveling up grants one:
+    void OnFreeTalentPointsChanged(Player* player, uint32 /*points*/) override
+    {
+        abSpecResolver.Forget(player->GetGUID());
+    }
+
+    void OnTalentsReset(Player* player, bool /*noCost*/) override
+    {
+        abSpecResolver.Forget(player->GetGUID());
+    }
+
+    void OnLevelChanged(Player* player, uint8 /*oldLevel*/) override
+    {
+        abSpecResolver.Forget(player->GetGUID());
+    }
+
+    // Switching specs, or learning the second one:
+    void OnSpellCast(Player* player, Spell* spell, bool /*skipCheck*/) override
+    {
+        SpellInfo const* spellInfo = spell->GetSpellInfo();
+        if (spellInfo->HasEffect(SPELL_EFFECT_ACTIVATE_SPEC) || spellInfo->HasEffect(SPELL_EFFECT_TALENT_SPEC_COUNT))
+            abSpecResolver.Forget(player->GetGUID());
+    }
+};
+
+void AddSC_autobis()
+{
+    new autobis_worldscript();
+    new autobis_playerscript();
 }
@@ -1,30 +1,119 @@
 #ifndef __AUTOBIS_MISC_H__
 #define __AUTOBIS_MISC_H__
 
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "autobis_score.h"
 #include "Chat.h"
 #include "Player.h"
 
+// RequiredLevels of the items a request looks at, inclusive. PLAYER_LEVEL stands for the level of whoever it's for;
+//  "max" never goes beyond it. The default is the player's level, and nothing else:
+struct AbLevelRange {
+    static constexpr uint8 PLAYER_LEVEL = 0xFF;
+    uint8 min = PLAYER_LEVEL;
+    uint8 max = PLAYER_LEVEL;
+
+    bool IsDefault() const { return min == PLAYER_LEVEL && max == PLAYER_LEVEL; }
+};
+
+// Everything Process() needs to know about a player, captured on the world thread so that the scoring and selection
+//  can run anywhere:
+struct AbPlayerSnapshot : AbSelectionInput {
+    ObjectGuid guid;
+    // Keeps "profile" alive: the player's own ones (see ".autobis weights") can be evicted at any time, and a reload
+    //  replaces the set the built-in ones come from:
+    std::shared_ptr<AbWeightProfile const> profile_owner;
+};
+
+struct AbRankingFlight;
+struct AbSlicedRequest;
+
 class AutoBis {
     public:
-        using ItemScore = std::pair<ItemTemplate const*, double>;
-        using SlotItems = std::vector<ItemScore>;
-        using ItemSlotMap = std::map<uint32, SlotItems>;
-        using ScoreWeightMap = std::map<int32, double>;
+        using ScoreWeightMap = AbScoreWeightMap;
+        using ItemList = AbItemList;
     private:
-        static const ScoreWeightMap& GetScoreWeightMap(Player *player);
-        static void AdjustInvType(Player* player, uint32 &inv_type);
+        // Aliases the profile set it comes from, so it stays valid across a reload:
+        static std::shared_ptr<AbWeightProfile const> GetWeightProfile(Player *player);
+        static void AdjustInvType(bool oh_dual, uint32 &inv_type);
         // return: score of the best enchant; also populates "enchid" (set to 0 if invalid):
-        static double CalculateBestRandomEnchant(const ScoreWeightMap &score_weights, ItemTemplate const* itemProto, int32& enchId);
-        static double ComputePawnScore(const ScoreWeightMap &score_weights, ItemTemplate const* itemTemplate);
+        static double CalculateBestRandomEnchant(const AbWeightProfile &profile, ItemTemplate const* itemProto, int32& enchId);
+        static double ComputePawnScore(const AbWeightProfile &profile, ItemTemplate const* itemTemplate);
+        // Cached ComputePawnScore(); also returns the best random enchant (and, optionally, its share of the score):
+        static double ScoreItem(const AbWeightProfile &profile, ItemTemplate const* itemTemplate, int32& enchId,
+                                double* enchScore = nullptr);
         static bool PlayerCanUseItem(Player *player, ItemTemplate const* itemTemplate);
-        static void PopulateSingleHaveItem(Player *player, const ScoreWeightMap &swm, Item *item,
-                                           ItemSlotMap &have_items, bool test_canuse);
-        static void PopulateHaveItems(Player *player, ItemSlotMap &have_items);
+        static void PopulateSingleHaveItem(Player *player, Item *item, std::vector<Item*> &owned, bool test_canuse);
+        static void PopulateHaveItems(Player *player, std::vector<Item*> &owned);
+        // Fills snapshot.have_items and owned_rows, from the owned item index when it's enabled and up to date:
+        static void CollectHaveItems(Player *player, AbPlayerSnapshot &snapshot);
+        // Process() is split in three: TakeSnapshot() and ApplyGrants() need the player and run on the world thread;
+        //  Select() only reads the snapshot and immutable data, so it can run on a worker thread.
+        // return: false if there's nothing to look for (e.g. the player's level is out of range):
+        static bool TakeSnapshot(Player *player, AbPlayerSnapshot &snapshot, AbLevelRange const& range = AbLevelRange());
+        // TakeSnapshot() in steps, for time-sliced requests: everything but the owned items and the candidates (return:
+        //  false if the level is out of range), then the candidates, one RequiredLevel at a time:
+        static bool StartSnapshot(Player *player, AbPlayerSnapshot &snapshot, AbLevelRange const& range);
+        static void AddCandidates(Player *player, AbPlayerSnapshot &snapshot, uint8 level);
+        // "flight", if given, is shared with concurrent requests that need the same ranking (see AbRankingFlights):
+        static void Select(AbPlayerSnapshot const& snapshot, std::vector<AbGrant> &grants,
+                           AbRankingFlight* flight = nullptr);
+        // return: false if "ranked" was truncated too early to be sure of the selection:
+        static bool Select(AbPlayerSnapshot const& snapshot, AbRankedSlots const& ranked, std::vector<AbGrant> &grants);
+        static void BuildHaveItems(const AbWeightProfile &profile, ItemList const& owned, bool oh_dual,
+                                   AbHaveSlots &have_items);
     public:
+        // Ranks every candidate with a RequiredLevel in [minLevel, maxLevel], down to "depth" (0: all) per slot:
+        static void RankCandidates(const AbWeightProfile &profile, uint8 minLevel, uint8 maxLevel,
+                                   AbRankedSlots &ranked, uint32 depth = 0);
+        static void RankCandidates(const AbWeightProfile &profile, uint8 level, AbRankedSlots &ranked)
+        {
+            RankCandidates(profile, level, level, ranked);
+        }
+        // One slot of RankCandidates(). return: true if "depth" left any out:
+        static bool RankSlot(const AbWeightProfile &profile, uint8 minLevel, uint8 maxLevel, uint32 slot,
+                             std::vector<AbRankedSlots::Entry> &entries, uint32 depth = 0);
+    private:
+        // Reads the ranking from the precomputed BiS table when it has one (return: true), else ranks every candidate
+        //  down to AB_RANK_DEPTH:
+        static bool GetRanking(const AbWeightProfile &profile, uint8 minLevel, uint8 maxLevel, AbRankedSlots &ranked);
+        static bool HandleBulk(ChatHandler* handler, std::vector<Player*> const& players);
+        static bool ApplyGrants(Player *player, ChatHandler* handler, std::vector<AbGrant> const& grants);
+        static bool StartRequest(ObjectGuid guid, Player *player, ChatHandler* handler, AbLevelRange const& range);
+        // Runs the next step of a time-sliced request (see AutoBis.TimeSlice.BudgetUs). return: true once it's done:
+        static bool StepSliced(AbSlicedRequest &request);
+        static bool HandleBench(ChatHandler* handler, std::string const& args);
+        static bool HandleAnalyze(ChatHandler* handler, std::string const& args);
+        static bool HandleWeights(ChatHandler* handler, std::string const& args);
+        static bool HandleLoadTest(ChatHandler* handler, std::string const& args);
+#ifdef AUTOBIS_SELFTEST
+        static void SelfTestFeatures();
+#endif
+    public:
+        // Builds the in-memory item catalog; called once at startup (see AddSC_autobis()):
+        static void LoadStaticData();
         static bool Process(ChatHandler* handler, char const* args);
+        // Starts requests that were queued by admission control; called once per world tick:
+        static void DispatchQueued();
+        // Steps time-sliced requests until this tick's budget is spent; called once per world tick:
+        static void UpdateSliced();
+        // Keep the owned item index up to date (AutoBis.OwnedIndex.Enable). The core has no script hooks for these,
+        //  so they have to be called from Player::_StoreItem(), EquipItem(), RemoveItem() and DestroyItem() (see
+        //  README.md). May be called from map update threads:
+        static void NotifyItemAdded(Player *player, Item *item);
+        static void NotifyItemRemoved(Player *player, Item *item);
+        static void ForgetPlayer(Player *player);
 };
 
-// returns INT_MIN if sei doesn't map in a valid fashion:
-int32 SpellEffectInfoToItemMod(const SpellEffectInfo& sei);
+// returns INT_MIN if sei doesn't map in a valid fashion; also sets "unknownAura" if its aura isn't handled at all:
+int32 SpellEffectInfoToItemMod(const SpellEffectInfo& sei, bool* unknownAura = nullptr);
+
+// Registers the world script that loads AutoBis' static data on startup. Call from AddSC_misc_commandscript():
+void AddSC_autobis();
 
 #endif
@@ -0,0 +1,458 @@
+#include "autobis_pawn.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+
+#include "ItemTemplate.h"
+
+// Pawn stat name -> what AutoBis weighs. Pawn's "Dps" is the weapon's DPS, whatever the weapon:
+static const std::map<std::string, int32> abPawnStats = {
+    { "Strength",           ITEM_MOD_STRENGTH },
+    { "Agility",            ITEM_MOD_AGILITY },
+    { "Stamina",            ITEM_MOD_STAMINA },
+    { "Intellect",          ITEM_MOD_INTELLECT },
+    { "Spirit",             ITEM_MOD_SPIRIT },
+    { "HitRating",          ITEM_MOD_HIT_RATING },
+    { "CritRating",         ITEM_MOD_CRIT_RATING },
+    { "HasteRating",        ITEM_MOD_HASTE_RATING },
+    { "ExpertiseRating",    ITEM_MOD_EXPERTISE_RATING },
+    { "ArmorPenetration",   ITEM_MOD_ARMOR_PENETRATION_RATING },
+    { "Ap",                 ITEM_MOD_ATTACK_POWER },
+    { "Rap",                ITEM_MOD_RANGED_ATTACK_POWER },
+    { "FeralAp",            ITEM_MOD_FERAL_ATTACK_POWER },
+    { "SpellPower",         ITEM_MOD_SPELL_POWER },
+    { "SpellPenetration",   ITEM_MOD_SPELL_PENETRATION },
+    { "Mp5",                ITEM_MOD_MANA_REGENERATION },
+    { "Hp5",                ITEM_MOD_HEALTH_REGEN },
+    { "DefenseRating",      ITEM_MOD_DEFENSE_SKILL_RATING },
+    { "DodgeRating",        ITEM_MOD_DODGE_RATING },
+    { "ParryRating",        ITEM_MOD_PARRY_RATING },
+    { "BlockRating",        ITEM_MOD_BLOCK_RATING },
+    { "BlockValue",         ITEM_MOD_BLOCK_VALUE },
+    { "ResilienceRating",   ITEM_MOD_RESILIENCE_RATING },
+    { "Dps",                -1 },
+    { "MeleeDps",           -1 },
+    { "Armor",              -2 },
+    { "RangedDps",          -3 },
+};
+
+namespace {
+
+enum AbTokenType {
+    TOKEN_END,
+    TOKEN_NAME,
+    TOKEN_STRING,
+    TOKEN_NUMBER,
+    TOKEN_SYMBOL,
+};
+
+struct AbToken {
+    AbTokenType type = TOKEN_END;
+    std::string text;
+    double number = 0.0;
+    uint32 line = 0;
+};
+
+class AbLuaLexer {
+    public:
+        explicit AbLuaLexer(std::string const& text) : _text(text) { }
+        // return: false (with "error" set) on an unterminated string or comment:
+        bool Next(AbToken &token, std::string &error);
+    private:
+        bool SkipLongBracket(std::string* out, std::string &error);
+        char Peek(size_t ahead = 0) const { return _pos + ahead < _text.size() ? _text[_pos + ahead] : '\0'; }
+
+        std::string const& _text;
+        size_t _pos = 0;
+        uint32 _line = 1;
+};
+
+// A value in a call or a table; tables keep whichever of their fields have a name (or string key) and a number:
+struct AbLuaValue {
+    AbTokenType type = TOKEN_END;
+    bool is_table = false;
+    std::string text;
+    std::vector<std::pair<std::string, double>> fields;
+};
+
+class AbLuaParser {
+    public:
+        AbLuaParser(std::string const& text, std::vector<std::string> &errors) : _lexer(text), _errors(errors) { }
+        bool Parse(std::vector<std::pair<uint32, std::vector<AbLuaValue>>> &calls);
+    private:
+        bool Advance();
+        bool Expect(char const* symbol);
+        bool IsSymbol(char const* symbol) const { return _token.type == TOKEN_SYMBOL && _token.text == symbol; }
+        bool ParseValue(AbLuaValue &value);
+        bool ParseTable(AbLuaValue &value);
+        bool ParseArguments(std::vector<AbLuaValue> &args);
+        bool Fail(std::string const& message);
+
+        AbLuaLexer _lexer;
+        AbToken _token;
+        std::vector<std::string> &_errors;
+};
+
+}
+
+// [[ ... ]], [==[ ... ]==], etc; _pos is on the first '[':
+bool AbLuaLexer::SkipLongBracket(std::string* out, std::string &error)
+{
+    size_t level = 0;
+    while (Peek(1 + level) == '=')
+        ++level;
+    if (Peek(1 + level) != '[')
+        return false;
+    _pos += 2 + level;
+    std::string close = "]" + std::string(level, '=') + "]";
+    size_t end = _text.find(close, _pos);
+    if (end == std::string::npos) {
+        error = "line " + std::to_string(_line) + ": unterminated long string or comment";
+        _pos = _text.size();
+        return false;
+    }
+    for (size_t idx = _pos; idx < end; ++idx)
+        _line += (_text[idx] == '\n');
+    if (out)
+        out->assign(_text, _pos, end - _pos);
+    _pos = end + close.size();
+    return true;
+}
+
+bool AbLuaLexer::Next(AbToken &token, std::string &error)
+{
+    for (;;) {
+        while (_pos < _text.size() && isspace((unsigned char)_text[_pos]))
+            _line += (_text[_pos++] == '\n');
+        if (Peek() == '-' && Peek(1) == '-') {
+            _pos += 2;
+            if (Peek() == '[' && SkipLongBracket(nullptr, error))
+                continue;
+            if (!error.empty())
+                return false;
+            while (_pos < _text.size() && _text[_pos] != '\n')
+                ++_pos;
+            continue;
+        }
+        break;
+    }
+    token = AbToken();
+    token.line = _line;
+    if (_pos >= _text.size())
+        return true;
+    char c = Peek();
+    if (isalpha((unsigned char)c) || c == '_') {
+        size_t start = _pos;
+        while (isalnum((unsigned char)Peek()) || Peek() == '_' || Peek() == '.' || Peek() == ':')
+            ++_pos;
+        token.type = TOKEN_NAME;
+        token.text.assign(_text, start, _pos - start);
+    } else if (isdigit((unsigned char)c) || (c == '.' && isdigit((unsigned char)Peek(1)))) {
+        char const* start = _text.c_str() + _pos;
+        char* end = nullptr;
+        token.type = TOKEN_NUMBER;
+        token.number = strtod(start, &end);
+        _pos += end - start;
+    } else if (c == '"' || c == '\'') {
+        ++_pos;
+        token.type = TOKEN_STRING;
+        while (_pos < _text.size() && _text[_pos] != c && _text[_pos] != '\n') {
+            if (_text[_pos] == '\\' && _pos + 1 < _text.size())
+                ++_pos;
+            token.text += _text[_pos++];
+        }
+        if (Peek() != c) {
+            error = "line " + std::to_string(token.line) + ": unterminated string";
+            return false;
+        }
+        ++_pos;
+    } else if (c == '[' && (Peek(1) == '[' || Peek(1) == '=')) {
+        token.type = TOKEN_STRING;
+        if (!SkipLongBracket(&token.text, error))
+            return false;
+    } else {
+        token.type = TOKEN_SYMBOL;
+        token.text = std::string(1, c);
+        ++_pos;
+    }
+    return true;
+}
+
+bool AbLuaParser::Fail(std::string const& message)
+{
+    _errors.push_back("line " + std::to_string(_token.line) + ": " + message);
+    return false;
+}
+
+bool AbLuaParser::Advance()
+{
+    std::string error;
+    if (!_lexer.Next(_token, error)) {
+        _errors.push_back(error);
+        return false;
+    }
+    return true;
+}
+
+bool AbLuaParser::Expect(char const* symbol)
+{
+    if (!IsSymbol(symbol))
+        return Fail(std::string("expected '") + symbol + "'" + (_token.text.empty() ? "" : ", got '" + _token.text + "'"));
+    return Advance();
+}
+
+bool AbLuaParser::ParseValue(AbLuaValue &value)
+{
+    value = AbLuaValue();
+    if (IsSymbol("{"))
+        return ParseTable(value);
+    bool negative = false;
+    if (IsSymbol("-")) {
+        negative = true;
+        if (!Advance())
+            return false;
+    }
+    value.type = _token.type;
+    switch (_token.type) {
+        case TOKEN_NUMBER:
+            value.text = std::to_string(negative ? -_token.number : _token.number);
+            return Advance();
+        case TOKEN_STRING:
+        case TOKEN_NAME: {
+            if (negative)
+                return Fail("expected a number after '-'");
+            value.text = _token.text;
+            if (!Advance())
+                return false;
+            // A nested call, e.g. a localized name; its arguments don't matter:
+            if (value.type == TOKEN_NAME && IsSymbol("(")) {
+                std::vector<AbLuaValue> ignored;
+                return ParseArguments(ignored);
+            }
+            return true;
+        }
+        default:
+            return Fail(_token.type == TOKEN_END ? "unexpected end of file" : "unexpected '" + _token.text + "'");
+    }
+}
+
+bool AbLuaParser::ParseTable(AbLuaValue &value)
+{
+    value.is_table = true;
+    if (!Expect("{"))
+        return false;
+    while (!IsSymbol("}")) {
+        std::string key;
+        if (IsSymbol("[")) {
+            if (!Advance())
+                return false;
+            AbLuaValue key_value;
+            if (!ParseValue(key_value) || !Expect("]") || !Expect("="))
+                return false;
+            key = key_value.text;
+        } else if (_token.type == TOKEN_NAME) {
+            // Either "Name = value", or a bare value that happens to be a name:
+            AbToken name = _token;
+            if (!Advance())
+                return false;
+            if (IsSymbol("=")) {
+                key = name.text;
+                if (!Advance())
+                    return false;
+            } else if (IsSymbol("(")) {
+                std::vector<AbLuaValue> ignored;
+                if (!ParseArguments(ignored))
+                    return false;
+                if (!IsSymbol(",") && !IsSymbol(";") && !IsSymbol("}"))
+                    return Fail("expected ',' or '}' in table");
+                if (!IsSymbol("}") && !Advance())
+                    return false;
+                continue;
+            } else {
+                if (!IsSymbol(",") && !IsSymbol(";") && !IsSymbol("}"))
+                    return Fail("expected ',' or '}' in table");
+                if (!IsSymbol("}") && !Advance())
+                    return false;
+                continue;
+            }
+        }
+        AbLuaValue field;
+        if (!ParseValue(field))
+            return false;
+        if (!key.empty() && field.type == TOKEN_NUMBER && !field.is_table)
+            value.fields.emplace_back(key, atof(field.text.c_str()));
+        if (IsSymbol(",") || IsSymbol(";")) {
+            if (!Advance())
+                return false;
+        } else if (!IsSymbol("}"))
+            return Fail("expected ',' or '}' in table");
+    }
+    return Advance();
+}
+
+bool AbLuaParser::ParseArguments(std::vector<AbLuaValue> &args)
+{
+    if (!Expect("("))
+        return false;
+    while (!IsSymbol(")")) {
+        AbLuaValue arg;
+        if (!ParseValue(arg))
+            return false;
+        args.push_back(arg);
+        if (IsSymbol(",")) {
+            if (!Advance())
+                return false;
+        } else if (!IsSymbol(")"))
+            return Fail("expected ',' or ')' in argument list");
+    }
+    return Advance();
+}
+
+bool AbLuaParser::Parse(std::vector<std::pair<uint32, std::vector<AbLuaValue>>> &calls)
+{
+    if (!Advance())
+        return false;
+    // Everything outside of the calls we care about (function definitions, locals, ...) is skipped token by token:
+    while (_token.type != TOKEN_END) {
+        if (_token.type == TOKEN_NAME && _token.text.compare(0, 18, "PawnAddPluginScale") == 0) {
+            uint32 line = _token.line;
+            if (!Advance())
+                return false;
+            if (!IsSymbol("("))
+                continue;
+            std::vector<AbLuaValue> args;
+            if (!ParseArguments(args))
+                return false;
+            calls.emplace_back(line, args);
+        } else if (!Advance())
+            return false;
+    }
+    return true;
+}
+
+bool AbParsePawnScales(std::string const& text, std::vector<AbPawnScale> &scales, std::vector<std::string> &errors,
+                       std::vector<std::string> &ignored)
+{
+    std::vector<std::pair<uint32, std::vector<AbLuaValue>>> calls;
+    AbLuaParser parser(text, errors);
+    if (!parser.Parse(calls))
+        return false;
+    std::set<std::string> names, ignoredStats;
+    for (auto const& call : calls) {
+        AbLuaValue const* name = nullptr;
+        AbLuaValue const* table = nullptr;
+        for (AbLuaValue const& arg : call.second) {
+            if (!name && arg.type == TOKEN_STRING && !arg.is_table)
+                name = &arg;
+            else if (!table && arg.is_table && !arg.fields.empty())
+                table = &arg; // not e.g. a { r, g, b } color
+        }
+        std::string where = "line " + std::to_string(call.first) + ": ";
+        if (!name || !table) {
+            errors.push_back(where + "scale without a name or without weights");
+            continue;
+        }
+        if (!names.insert(name->text).second) {
+            errors.push_back(where + "scale \"" + name->text + "\" is defined twice");
+            continue;
+        }
+        AbPawnScale scale;
+        scale.name = name->text;
+        for (auto const& field : table->fields) {
+            auto fiter = abPawnStats.find(field.first);
+            if (fiter == abPawnStats.end()) {
+                if (ignoredStats.insert(field.first).second)
+                    ignored.push_back(field.first);
+                continue;
+            }
+            // Negative weights mark things Pawn wants avoided (e.g. armor types); AutoBis decides that by itself:
+            if (field.second <= 0)
+                continue;
+            double &weight = scale.weights[fiter->second];
+            weight = std::max(weight, field.second);
+        }
+        if (scale.weights.empty()) {
+            errors.push_back(where + "scale \"" + scale.name + "\" has no usable weights");
+            continue;
+        }
+        scales.push_back(scale);
+    }
+    if (scales.empty() && errors.empty())
+        errors.push_back("no PawnAddPluginScale() calls found");
+    return errors.empty();
+}
+
+bool AbParsePawnWeights(std::string const& text, std::map<int32, double> &weights, std::string &error)
+{
+    std::string list = text;
+    // Pawn tags: everything up to the last ':' is the version and scale name:
+    if (list.find("Pawn:") != std::string::npos) {
+        list = list.substr(list.rfind(':') + 1);
+        size_t close = list.rfind(')');
+        if (close != std::string::npos)
+            list.erase(close);
+    }
+    for (char &c : list) {
+        if (c == ',' || c == '\t')
+            c = ' ';
+    }
+    weights.clear();
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(' ', pos);
+        if (end == std::string::npos)
+            end = list.size();
+        std::string pair = list.substr(pos, end - pos);
+        pos = end + 1;
+        if (pair.empty())
+            continue;
+        size_t equals = pair.find('=');
+        auto fiter = abPawnStats.find(pair.substr(0, equals));
+        if (equals == std::string::npos || fiter == abPawnStats.end()) {
+            error = "unknown stat \"" + pair.substr(0, equals) + "\"";
+            return false;
+        }
+        char const* value = pair.c_str() + equals + 1;
+        char* value_end = nullptr;
+        double weight = strtod(value, &value_end);
+        if (value_end == value || *value_end || !std::isfinite(weight) || weight < 0) {
+            error = "bad value for " + fiter->first + ": \"" + std::string(value) + "\"";
+            return false;
+        }
+        if (weight > 0)
+            weights[fiter->second] = weight;
+    }
+    if (weights.empty()) {
+        error = "no weights given";
+        return false;
+    }
+    // They're normalized by their total, which has to be a number too:
+    double total = 0.0;
+    for (auto const& weight : weights)
+        total += weight.second;
+    if (!std::isfinite(total)) {
+        error = "the weights are too large";
+        return false;
+    }
+    return true;
+}
+
+std::string AbFormatPawnWeights(std::map<int32, double> const& weights)
+{
+    std::string text;
+    char value[32];
+    for (auto const& weight : weights) {
+        for (auto const& stat : abPawnStats) {
+            if (stat.second != weight.first)
+                continue;
+            snprintf(value, sizeof(value), "%g", weight.second);
+            text += (text.empty() ? "" : " ") + stat.first + "=" + value;
+            break;
+        }
+    }
+    return text;
+}
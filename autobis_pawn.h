@@ -0,0 +1,34 @@
+#ifndef __AUTOBIS_PAWN_H__
+#define __AUTOBIS_PAWN_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Define.h"
+
+// One scale from Pawn's Wowhead.lua, with Pawn's stat names already translated into a ScoreWeightMap (ITEM_MOD ids,
+//  plus -1 = melee DPS, -2 = armor, -3 = ranged DPS):
+struct AbPawnScale {
+    std::string name;
+    std::map<int32, double> weights;
+};
+
+// Reads every PawnAddPluginScale(...)/PawnAddPluginScaleFromTemplate(...) call out of a Wowhead.lua: the first string
+//  argument names the scale, the first table with named fields holds its weights. Only a small subset of Lua is
+//  understood (literals, tables, comments, nested calls as arguments), which is all that file uses.
+//
+// return: false on any syntax error, in which case "errors" says where and "scales" shouldn't be used. Stats that
+//  AutoBis doesn't weigh (sockets, armor types, ...) aren't errors; they're listed in "ignored", once each.
+bool AbParsePawnScales(std::string const& text, std::vector<AbPawnScale> &scales, std::vector<std::string> &errors,
+                       std::vector<std::string> &ignored);
+
+// Parses a list of "Stat=value" pairs (Pawn's stat names, separated by spaces or commas), or a whole Pawn scale tag,
+//  e.g. ( Pawn: v1: "My scale": Strength=1, Agility=0.5 ).
+//
+// return: false, with "error" set, on unknown stats, bad or negative values, or if nothing was given:
+bool AbParsePawnWeights(std::string const& text, std::map<int32, double> &weights, std::string &error);
+// The reverse: "Stat=value" pairs, space-separated:
+std::string AbFormatPawnWeights(std::map<int32, double> const& weights);
+
+#endif
@@ -0,0 +1,146 @@
+#include "autobis_scheduler.h"
+
+#include <algorithm>
+
+void AbWorkerPool::Start(uint32 threads)
+{
+    Stop();
+    _stopping = false;
+    for (uint32 idx = 0; idx < threads; ++idx)
+        _threads.emplace_back(&AbWorkerPool::Run, this);
+}
+
+void AbWorkerPool::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stopping = true;
+    }
+    _cond.notify_all();
+    for (std::thread &thread : _threads)
+        thread.join();
+    _threads.clear();
+}
+
+void AbWorkerPool::Enqueue(Task&& task)
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _tasks.push_back(std::move(task));
+    }
+    _cond.notify_one();
+}
+
+void AbWorkerPool::Run()
+{
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _cond.wait(guard, [this]() { return _stopping || !_tasks.empty(); });
+            if (_tasks.empty())
+                return; // stopping, and nothing left to do
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void AbCompletionQueue::Post(Completion&& completion)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _pending.push_back(std::move(completion));
+}
+
+void AbCompletionQueue::Drain()
+{
+    std::vector<Completion> ready;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        ready.swap(_pending);
+    }
+    for (Completion &completion : ready)
+        completion();
+}
+
+bool AbAdmission::TakeToken(uint32 accountId, Clock::time_point now)
+{
+    if (!_config.bucket_burst)
+        return true;
+    auto fiter = _buckets.find(accountId);
+    if (fiter == _buckets.end())
+        fiter = _buckets.emplace(accountId, Bucket{ double(_config.bucket_burst), now }).first;
+    Bucket &bucket = fiter->second;
+    double minutes = std::chrono::duration<double>(now - bucket.refilled).count() / 60.0;
+    bucket.tokens = std::min<double>(_config.bucket_burst, bucket.tokens + minutes * _config.bucket_per_minute);
+    bucket.refilled = now;
+    if (bucket.tokens < 1.0)
+        return false;
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+AbAdmission::Decision AbAdmission::Submit(ObjectGuid guid, uint32 accountId, uint32 &position)
+{
+    Clock::time_point now = Clock::now();
+    // Checked before taking a token, so being turned away for a full queue doesn't also cost the player a token:
+    bool run_now = HasRoom() && _queue.empty();
+    if (!run_now && _queue.size() >= _config.queue_depth) {
+        ++_stats.rejected_queue_full;
+        return REJECT_QUEUE_FULL;
+    }
+    if (!TakeToken(accountId, now)) {
+        ++_stats.rejected_rate_limited;
+        return REJECT_RATE_LIMITED;
+    }
+    if (run_now) {
+        ++_inFlight;
+        ++_stats.admitted;
+        return ADMIT_NOW;
+    }
+    _queue.push_back(Waiting{ guid, now });
+    _queuedGuids.insert(guid);
+    ++_stats.queued;
+    _stats.max_queue_depth = std::max<uint32>(_stats.max_queue_depth, _queue.size());
+    position = uint32(_queue.size());
+    return ADMIT_QUEUED;
+}
+
+void AbAdmission::Finished()
+{
+    if (_inFlight)
+        --_inFlight;
+}
+
+void AbAdmission::Update(Dispatcher const& dispatch)
+{
+    Clock::time_point now = Clock::now();
+    for (uint32 started = 0; started < _config.dispatch_per_tick && !_queue.empty() && HasRoom(); ) {
+        Waiting waiting = _queue.front();
+        _queue.pop_front();
+        _queuedGuids.erase(waiting.guid);
+        ++_inFlight;
+        if (!dispatch(waiting.guid)) {
+            --_inFlight;
+            ++_stats.dropped_from_queue;
+            continue;
+        }
+        uint64 waited = std::chrono::duration_cast<std::chrono::milliseconds>(now - waiting.since).count();
+        ++_stats.dispatched_from_queue;
+        _stats.total_wait_ms += waited;
+        _stats.max_wait_ms = std::max(_stats.max_wait_ms, waited);
+        ++started;
+    }
+    // Once a minute, forget about accounts whose bucket has filled back up:
+    if (now - _bucketsPruned > std::chrono::minutes(1)) {
+        _bucketsPruned = now;
+        for (auto itr = _buckets.begin(); itr != _buckets.end(); ) {
+            double minutes = std::chrono::duration<double>(now - itr->second.refilled).count() / 60.0;
+            if (itr->second.tokens + minutes * _config.bucket_per_minute >= _config.bucket_burst)
+                itr = _buckets.erase(itr);
+            else
+                ++itr;
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef __AUTOBIS_SCHEDULER_H__
+#define __AUTOBIS_SCHEDULER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Define.h"
+#include "ObjectGuid.h"
+
+// Small fixed-size thread pool that runs AutoBis' scoring and selection off the world thread.
+class AbWorkerPool {
+    public:
+        using Task = std::function<void()>;
+        ~AbWorkerPool() { Stop(); }
+        // threads == 0 leaves the pool stopped, in which case Process() does all of its work inline:
+        void Start(uint32 threads);
+        // Finishes whatever is queued, then joins every thread:
+        void Stop();
+        bool IsRunning() const { return !_threads.empty(); }
+        void Enqueue(Task&& task);
+    private:
+        void Run();
+        std::vector<std::thread> _threads;
+        std::deque<Task> _tasks;
+        std::mutex _lock;
+        std::condition_variable _cond;
+        bool _stopping = false;
+};
+
+// Hands finished work back to the world thread. Post() may be called from any thread; Drain() runs every posted
+//  completion, and must only be called from the world thread (see autobis_worldscript::OnUpdate()).
+class AbCompletionQueue {
+    public:
+        using Completion = std::function<void()>;
+        void Post(Completion&& completion);
+        void Drain();
+    private:
+        std::mutex _lock;
+        std::vector<Completion> _pending;
+};
+
+// Admission control in front of AutoBis::Process(): a global limit on requests in flight, a token bucket per account,
+//  and a bounded FIFO for whatever doesn't fit right now, dispatched at a fixed rate per world tick.
+//
+// World thread only (chat commands and world updates both run there), so nothing here locks.
+class AbAdmission {
+    public:
+        using Clock = std::chrono::steady_clock;
+        struct Config {
+            uint32 max_in_flight = 16;      // 0 = unlimited
+            uint32 queue_depth = 200;
+            uint32 dispatch_per_tick = 8;
+            uint32 bucket_burst = 5;        // 0 = no per-account rate limit
+            double bucket_per_minute = 10.0;
+        };
+        enum Decision {
+            ADMIT_NOW,
+            ADMIT_QUEUED,
+            REJECT_RATE_LIMITED,
+            REJECT_QUEUE_FULL,
+        };
+        struct Stats {
+            uint64 admitted = 0;            // dispatched straight away
+            uint64 queued = 0;
+            uint64 dispatched_from_queue = 0;
+            uint64 dropped_from_queue = 0;  // the player logged out while waiting
+            uint64 rejected_rate_limited = 0;
+            uint64 rejected_queue_full = 0;
+            uint64 total_wait_ms = 0;       // over dispatched_from_queue
+            uint64 max_wait_ms = 0;
+            uint32 max_queue_depth = 0;
+        };
+        // Starts a queued request; returns false if it couldn't (e.g. the player is gone). A request that was started
+        //  must eventually call Finished():
+        using Dispatcher = std::function<bool(ObjectGuid guid)>;
+
+        void SetConfig(Config const& config) { _config = config; }
+        Config const& GetConfig() const { return _config; }
+        // position is set to the 1-based queue position for ADMIT_QUEUED:
+        Decision Submit(ObjectGuid guid, uint32 accountId, uint32 &position);
+        bool IsQueued(ObjectGuid guid) const { return _queuedGuids.find(guid) != _queuedGuids.end(); }
+        void Finished();
+        // Once per world tick:
+        void Update(Dispatcher const& dispatch);
+
+        uint32 GetInFlight() const { return _inFlight; }
+        uint32 GetQueueDepth() const { return uint32(_queue.size()); }
+        Stats const& GetStats() const { return _stats; }
+    private:
+        struct Bucket {
+            double tokens;
+            Clock::time_point refilled;
+        };
+        struct Waiting {
+            ObjectGuid guid;
+            Clock::time_point since;
+        };
+        bool TakeToken(uint32 accountId, Clock::time_point now);
+        bool HasRoom() const { return !_config.max_in_flight || _inFlight < _config.max_in_flight; }
+
+        Config _config;
+        Stats _stats;
+        uint32 _inFlight = 0;
+        std::deque<Waiting> _queue;
+        std::unordered_set<ObjectGuid> _queuedGuids;
+        std::unordered_map<uint32, Bucket> _buckets;
+        Clock::time_point _bucketsPruned;
+};
+
+#endif
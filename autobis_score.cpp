@@ -0,0 +1,803 @@
+#include "autobis_metrics.h"
+#include "autobis_score.h"
+#include "autobis_weights.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+#include "SharedDefines.h"
+
+AbWeightProfile AbCompileWeightProfile(AbScoreWeightMap const& score_weights, uint32 id, char const* name)
+{
+    AbWeightProfile profile;
+    profile.id = id;
+    profile.name = name;
+    double totalWeight = 0.0;
+    for (auto entry : score_weights) {
+        totalWeight += entry.second;
+    }
+    if (!std::isfinite(totalWeight) || totalWeight <= 0.0)
+        return profile;
+    for (auto entry : score_weights) {
+        double weight = entry.second / totalWeight;
+        if (entry.first == -1)
+            profile.melee_dps = weight;
+        else if (entry.first == -2)
+            profile.armor = weight;
+        else if (entry.first == -3)
+            profile.ranged_dps = weight;
+        else if (entry.first >= 0 && uint32(entry.first) < AbWeightProfile::MAX_STATS - 1)
+            profile.stats[entry.first] = weight;
+    }
+    return profile;
+}
+
+void AbAdjustStaticInvType(uint32 &inv_type)
+{
+    if (inv_type == INVTYPE_ROBE) {
+        inv_type = INVTYPE_CHEST;
+    } else if (inv_type == INVTYPE_HOLDABLE || inv_type == INVTYPE_WEAPONOFFHAND) {
+        inv_type = INVTYPE_SHIELD;
+    } else if (inv_type == INVTYPE_THROWN || inv_type == INVTYPE_RANGEDRIGHT) {
+        inv_type = INVTYPE_RANGED;
+    }
+}
+
+bool AbItemCatalog::IsCandidate(ItemTemplate const* itemTemplate)
+{
+    // (class=2 || class=4) && (Quality<=3) && (FlagsExtra!=8192) && (ItemLevel<200) &&
+    //  (RequiredReputationFaction = 0) && (SellPrice > 0):
+    if (itemTemplate->Class != ITEM_CLASS_WEAPON && itemTemplate->Class != ITEM_CLASS_ARMOR)
+        return false;
+    return (itemTemplate->Quality <= ITEM_QUALITY_RARE && itemTemplate->Flags2 != 8192
+            && itemTemplate->ItemLevel < 200 && itemTemplate->RequiredReputationFaction == 0
+            && itemTemplate->SellPrice > 0);
+}
+
+static uint32 CatalogInvType(ItemTemplate const* itemTemplate)
+{
+    uint32 inv_type = itemTemplate->InventoryType;
+    AbAdjustStaticInvType(inv_type);
+    return inv_type;
+}
+
+void AbItemCatalog::Load(AbItemList const& templates)
+{
+    _items.clear();
+    for (ItemTemplate const* itemTemplate : templates) {
+        if (!IsCandidate(itemTemplate) || itemTemplate->RequiredLevel > DEFAULT_MAX_LEVEL)
+            continue;
+        if (CatalogInvType(itemTemplate) >= MAX_INVTYPE)
+            continue;
+        _items.push_back(itemTemplate);
+    }
+    std::sort(_items.begin(), _items.end(), [](ItemTemplate const* left, ItemTemplate const* right) {
+        uint32 left_slot = CatalogInvType(left), right_slot = CatalogInvType(right);
+        if (left->RequiredLevel != right->RequiredLevel)
+            return left->RequiredLevel < right->RequiredLevel;
+        if (left_slot != right_slot)
+            return left_slot < right_slot;
+        return left->ItemId < right->ItemId;
+    });
+    for (SlotRanges &level : _ranges)
+        level.fill(Range());
+    _rows.clear();
+    for (uint32 row = 0; row < _items.size(); ++row) {
+        _rows[_items[row]->ItemId] = row;
+        Range &range = _ranges[_items[row]->RequiredLevel][CatalogInvType(_items[row])];
+        if (!range.size())
+            range.first = row;
+        range.last = row + 1;
+    }
+    _loaded = true;
+}
+
+//
+// see src/server/game/Entities/Item/ItemEnchantmentMgr.cpp
+//
+// Unlike GenerateItemRandomPropertyId(), we don't care about the chances (except to initially populate the pools).
+double AbFindBestEnchant(AbScoreData const& data, AbWeightProfile const& profile, uint32 ench_idx, bool rand_suffix,
+                         uint32 scalefact, int32& enchId)
+{
+    enchId = 0;
+    bool do_debug = false; // (ench_idx == 25117);
+    double best_score = -1000.0; // because we want at least 1 enchant
+    std::vector<uint32> const* pool = data.GetEnchantPool(ench_idx);
+    if (!pool)
+        return best_score; // Internal error!?
+    AbScoreData::RandomEnchant enchant;
+    for (uint32 ench : *pool) {
+        if (!data.GetRandomEnchant(ench, rand_suffix, enchant)) {
+            if (do_debug)
+                printf("  ench=%u doesn't have an ItemRandom%sEntry?!\n", ench, rand_suffix ? "Suffix" : "Properties");
+            continue; // Internal error!?
+        }
+        double cur_score = 0;
+        for (uint32 idx = 0; idx < enchant.count; ++idx) {
+            AbScoreData::Stat const& stat = enchant.stats[idx];
+            if (!rand_suffix) {
+                cur_score += stat.value * profile.Stat(stat.stat_id);
+                continue;
+            }
+            // Items with RandomSuffix are handled way differently than RandomProp. Suffixes are scaled based
+            //  on a scaling factor, which can be queried for. We need to calculate how much value per item:
+            uint32 enchant_amount = uint32((uint32(stat.value) * scalefact) / 10000);
+            if (do_debug) {
+                printf("      enchId=%u:%u, stat = %d, AllocationPct = %d, scale = %u, amount=%u\n",
+                       ench_idx, ench, stat.stat_id, stat.value, scalefact, enchant_amount);
+            }
+            cur_score += enchant_amount * profile.Stat(stat.stat_id);
+        }
+        if (do_debug)
+            printf("       enchId = %u, score = %f\n", ench, cur_score);
+        if (cur_score > best_score) {
+            if (!rand_suffix)
+                enchId = ((int32) ench);
+            else
+                enchId = -((int32) ench);
+            best_score = cur_score;
+        }
+    }
+    return best_score;
+}
+
+void AbBestEnchants::Precompute(AbScoreData const& data, AbItemList const& items, AbWeightProfile const* profiles,
+                                uint32 profileCount)
+{
+    for (ItemTemplate const* itemProto : items) {
+        if (!itemProto->RandomProperty && !itemProto->RandomSuffix)
+            continue;
+        bool rand_suffix = !itemProto->RandomProperty;
+        uint32 ench_idx = rand_suffix ? itemProto->RandomSuffix : itemProto->RandomProperty;
+        uint32 scalefact = rand_suffix ? data.GetSuffixFactor(itemProto) : 0;
+        for (uint32 idx = 0; idx < profileCount; ++idx) {
+            if (!FitsKey(profiles[idx].id, ench_idx, scalefact))
+                continue;
+            uint64 key = Key(profiles[idx].id, ench_idx, rand_suffix, scalefact);
+            if (_best.find(key) != _best.end())
+                continue;
+            BestEnchant best;
+            best.score = AbFindBestEnchant(data, profiles[idx], ench_idx, rand_suffix, scalefact, best.ench_id);
+            _best[key] = best;
+        }
+    }
+}
+
+AbBestEnchants::BestEnchant const* AbBestEnchants::Get(uint32 profileId, uint32 ench_idx, bool rand_suffix,
+                                                       uint32 scalefact) const
+{
+    if (!FitsKey(profileId, ench_idx, scalefact))
+        return nullptr;
+    auto fiter = _best.find(Key(profileId, ench_idx, rand_suffix, scalefact));
+    return fiter != _best.end() ? &fiter->second : nullptr;
+}
+
+double AbBestRandomEnchant(AbScoringContext const& context, AbWeightProfile const& profile,
+                           ItemTemplate const* itemProto, int32& enchId)
+{
+    enchId = 0;
+    // Items with random suffixes/properties must have one of the two:
+    // RandomSuffix and RandomProperty _should_ be mutually exclusive.
+    //  If, for some reason, both are set. Just take from "RandomProperty":
+    if (!itemProto->RandomProperty && !itemProto->RandomSuffix)
+        return 0;
+    bool rand_suffix = false;
+    uint32 ench_idx = itemProto->RandomProperty;
+    if (!ench_idx) {
+        ench_idx = itemProto->RandomSuffix;
+        rand_suffix = true;
+    }
+    AbScoreData const& data = *context.data;
+    if (!data.GetEnchantPool(ench_idx))
+        return 0; // Internal error!?
+    uint32 scalefact = rand_suffix ? data.GetSuffixFactor(itemProto) : 0;
+    double best_score;
+    AbBestEnchants::BestEnchant const* best = nullptr;
+    if (context.enchants)
+        best = context.enchants->Get(profile.id, ench_idx, rand_suffix, scalefact);
+    if (best) {
+        enchId = best->ench_id;
+        best_score = best->score;
+    } else
+        best_score = AbFindBestEnchant(data, profile, ench_idx, rand_suffix, scalefact, enchId);
+    if (best_score <= 0) {
+        // None is worth anything; ApplyGrants() rolls one when the item is handed out, like the core would. Rolling
+        //  here would bake one roll into the score cache and the BiS table, for everyone:
+        enchId = 0;
+        return 0;
+    }
+    return best_score;
+}
+
+// Calls visit(statId, value) for every "Equip: Increase X by Y" stat we weigh on itemTemplate:
+template <typename Visitor>
+static void VisitEquipSpellStats(AbScoreData const& data, ItemTemplate const* itemTemplate, Visitor&& visit)
+{
+    // A stat only counts once per item, even when two of its spells give it:
+    uint64 seen_stat_ids = 0;
+    for (uint32 idx = 0; idx < MAX_ITEM_PROTO_SPELLS; ++idx) {
+        uint32 spellid = itemTemplate->Spells[idx].SpellId;
+        if (spellid <= 0 || itemTemplate->Spells[idx].SpellTrigger != ITEM_SPELLTRIGGER_ON_EQUIP)
+            continue;
+        AbScoreData::Stat const* first;
+        AbScoreData::Stat const* last;
+        data.GetEquipSpellStats(spellid, first, last);
+        for (AbScoreData::Stat const* stat = first; stat != last; ++stat) {
+            uint64 bit = uint64(1) << std::min<uint32>(stat->stat_id, AbWeightProfile::MAX_STATS - 1);
+            if (seen_stat_ids & bit)
+                continue;
+            seen_stat_ids |= bit;
+            visit(stat->stat_id, stat->value);
+        }
+    }
+}
+
+double AbWeaponDps(ItemTemplate const* itemTemplate)
+{
+    if (itemTemplate->Class != ITEM_CLASS_WEAPON || !itemTemplate->Delay)
+        return 0.0;
+    double dmg_min1 = itemTemplate->Damage[0].DamageMin;
+    double dmg_max1 = itemTemplate->Damage[0].DamageMax;
+    return 1000 * (dmg_min1 + dmg_max1) / 2 / itemTemplate->Delay;
+}
+
+double AbBaseScore(AbScoreData const& data, AbWeightProfile const& profile, ItemTemplate const* itemTemplate)
+{
+    uint32 armor = itemTemplate->Armor;
+    double totalScore = 0.0;
+    totalScore += itemTemplate->Block * profile.Stat(ITEM_MOD_BLOCK_VALUE);
+    if (itemTemplate->Class == ITEM_CLASS_WEAPON) {
+        double dps = std::max(AbWeaponDps(itemTemplate), 0.0);
+        uint32 invtype = itemTemplate->InventoryType;
+        bool ranged = (invtype == INVTYPE_RANGED || invtype == INVTYPE_THROWN || invtype == INVTYPE_RANGEDRIGHT);
+        totalScore += dps * (ranged ? profile.ranged_dps : profile.melee_dps);
+    }
+    totalScore += armor * profile.armor;
+    for (uint32 idx = 0; idx < itemTemplate->StatsCount; ++idx) {
+        int32 statId = itemTemplate->ItemStat[idx].ItemStatType;
+        int32 statVal = itemTemplate->ItemStat[idx].ItemStatValue;
+        totalScore += std::max(statVal, 0) * profile.Stat(statId);
+    }
+    // Items can also have: "Equip: Increase X by Y" attributes. These are separate:
+    VisitEquipSpellStats(data, itemTemplate, [&](int32 statId, int32 value) {
+        totalScore += value * profile.Stat(statId);
+    });
+    return totalScore;
+}
+
+double AbItemFeatures::ColumnWeight(AbWeightProfile const& profile, int32 column)
+{
+    switch (column) {
+        case -1: return profile.melee_dps;
+        case -2: return profile.armor;
+        case -3: return profile.ranged_dps;
+        default: return profile.Stat(column);
+    }
+}
+
+void AbItemFeatures::Load(AbScoreData const& data, AbItemList const& items)
+{
+    // Gather every row's stats first, so we know which columns we need:
+    std::vector<std::map<int32, double>> rows(items.size());
+    std::map<int32, uint32> columns;
+    for (uint32 row = 0; row < items.size(); ++row) {
+        ItemTemplate const* itemTemplate = items[row];
+        std::map<int32, double> &features = rows[row];
+        if (itemTemplate->Block)
+            features[ITEM_MOD_BLOCK_VALUE] += itemTemplate->Block;
+        if (itemTemplate->Class == ITEM_CLASS_WEAPON) {
+            double dps = AbWeaponDps(itemTemplate);
+            uint32 invtype = itemTemplate->InventoryType;
+            bool ranged = (invtype == INVTYPE_RANGED || invtype == INVTYPE_THROWN || invtype == INVTYPE_RANGEDRIGHT);
+            if (dps > 0)
+                features[ranged ? -3 : -1] += dps;
+        }
+        if (itemTemplate->Armor)
+            features[-2] += itemTemplate->Armor;
+        for (uint32 idx = 0; idx < itemTemplate->StatsCount; ++idx) {
+            int32 statId = itemTemplate->ItemStat[idx].ItemStatType;
+            int32 statVal = itemTemplate->ItemStat[idx].ItemStatValue;
+            if (statVal > 0)
+                features[statId] += statVal;
+        }
+        VisitEquipSpellStats(data, itemTemplate, [&](int32 statId, int32 value) {
+            features[statId] += value;
+        });
+        for (auto const& feature : features)
+            columns[feature.first] = 0;
+    }
+    _columnIds.clear();
+    for (auto &column : columns) {
+        column.second = _columnIds.size();
+        _columnIds.push_back(column.first);
+    }
+    _rows = items.size();
+    _stride = (_rows + 7) & ~7u; // keep every column a whole number of 8-wide blocks
+    _values.assign(size_t(_stride) * _columnIds.size(), 0.0f);
+    _hasRandomEnchant.assign(_rows, 0);
+    for (uint32 row = 0; row < _rows; ++row) {
+        for (auto const& feature : rows[row])
+            _values[size_t(columns[feature.first]) * _stride + row] = float(feature.second);
+        _hasRandomEnchant[row] = (items[row]->RandomProperty || items[row]->RandomSuffix);
+    }
+}
+
+static void ScoreRowsScalar(float const* values, uint32 stride, double const* weights, uint32 columns,
+                            uint32 first, uint32 last, double* out)
+{
+    for (uint32 row = first; row < last; ++row) {
+        double score = 0.0;
+        for (uint32 c = 0; c < columns; ++c)
+            score += values[size_t(c) * stride + row] * weights[c];
+        out[row - first] = score;
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AUTOBIS_AVX2_KERNEL
+// Same as ScoreRowsScalar(), 8 rows at a time. The columns are stored as floats but accumulated as doubles, so the
+//  result matches AbBaseScore() up to the float rounding of the stored DPS.
+__attribute__((target("avx2,fma")))
+static void ScoreRowsAvx2(float const* values, uint32 stride, double const* weights, uint32 columns,
+                          uint32 first, uint32 last, double* out)
+{
+    uint32 row = first;
+    for (; row + 8 <= last; row += 8) {
+        __m256d lo = _mm256_setzero_pd();
+        __m256d hi = _mm256_setzero_pd();
+        for (uint32 c = 0; c < columns; ++c) {
+            __m256 v = _mm256_loadu_ps(values + size_t(c) * stride + row);
+            __m256d w = _mm256_broadcast_sd(weights + c);
+            lo = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), w, lo);
+            hi = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), w, hi);
+        }
+        _mm256_storeu_pd(out + (row - first), lo);
+        _mm256_storeu_pd(out + (row - first) + 4, hi);
+    }
+    ScoreRowsScalar(values, stride, weights, columns, row, last, out + (row - first));
+}
+#endif
+
+void AbItemFeatures::Score(AbWeightProfile const& profile, uint32 first, uint32 last, double* out) const
+{
+    uint32 columns = _columnIds.size();
+    double weights[AbWeightProfile::MAX_STATS + 3];
+    for (uint32 c = 0; c < columns; ++c)
+        weights[c] = ColumnWeight(profile, _columnIds[c]);
+#ifdef AUTOBIS_AVX2_KERNEL
+    static const bool use_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (use_avx2) {
+        ScoreRowsAvx2(_values.data(), _stride, weights, columns, first, last, out);
+        return;
+    }
+#endif
+    ScoreRowsScalar(_values.data(), _stride, weights, columns, first, last, out);
+}
+
+static const uint32 abItemWeaponSkills[MAX_ITEM_SUBCLASS_WEAPON] = {
+    SKILL_AXES,     SKILL_2H_AXES,  SKILL_BOWS,          SKILL_GUNS,      SKILL_MACES,
+    SKILL_2H_MACES, SKILL_POLEARMS, SKILL_SWORDS,        SKILL_2H_SWORDS, 0,
+    SKILL_STAVES,   0,              0,                   SKILL_FIST_WEAPONS,   0,
+    SKILL_DAGGERS,  SKILL_THROWN,   SKILL_ASSASSINATION, SKILL_CROSSBOWS, SKILL_WANDS,
+    SKILL_FISHING
+}; //Copy from function Item::GetSkill()
+
+uint32 AbWeaponSkill(uint32 subclass)
+{
+    return subclass < MAX_ITEM_SUBCLASS_WEAPON ? abItemWeaponSkills[subclass] : 0;
+}
+
+bool AbClassCanUseArmor(uint8 classId, uint8 level, ItemTemplate const* itemTemplate)
+{
+    uint32 subclass = itemTemplate->SubClass;
+    if (itemTemplate->InventoryType == INVTYPE_SHIELD) {
+        // only shamans, warriors, and paladins can use shields:
+        if (classId != CLASS_WARRIOR && classId != CLASS_PALADIN && classId != CLASS_SHAMAN)
+            return false;
+    }
+    if (itemTemplate->Class == ITEM_CLASS_ARMOR) {
+        if (classId == CLASS_WARRIOR || classId == CLASS_PALADIN || classId == CLASS_DEATH_KNIGHT) {
+            // plate doesn't start to show up til lvl 40. Don't do checks for pal/warr/DKs..
+        } else if (classId == CLASS_SHAMAN || classId == CLASS_HUNTER) {
+            if (subclass == ITEM_SUBCLASS_ARMOR_PLATE)
+                return false;
+            if (level < 40 && subclass == ITEM_SUBCLASS_ARMOR_MAIL)
+                return false;
+        } else if (classId == CLASS_DRUID || classId == CLASS_ROGUE) {
+            if (subclass == ITEM_SUBCLASS_ARMOR_PLATE
+             || subclass == ITEM_SUBCLASS_ARMOR_MAIL)
+                return false;
+        } else {
+            // player is mage/wlock/priest:
+            if (subclass == ITEM_SUBCLASS_ARMOR_PLATE
+              || subclass == ITEM_SUBCLASS_ARMOR_MAIL
+              || subclass == ITEM_SUBCLASS_ARMOR_LEATHER)
+                return false;
+        }
+        // Totems, Sigils, etc need to be checked against player class:
+        if (subclass == ITEM_SUBCLASS_ARMOR_LIBRAM) {
+            if (classId != CLASS_PALADIN)
+                return false;
+        } else if (subclass == ITEM_SUBCLASS_ARMOR_IDOL) {
+            if (classId != CLASS_DRUID)
+                return false;
+        } else if (subclass == ITEM_SUBCLASS_ARMOR_TOTEM) {
+            if (classId != CLASS_SHAMAN)
+                return false;
+        } else if (subclass == ITEM_SUBCLASS_ARMOR_SIGIL) {
+            if (classId != CLASS_DEATH_KNIGHT)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Weapon skills every class can train:
+static bool ClassHasWeaponSkill(uint8 classId, uint32 skill)
+{
+    static const std::map<uint8, std::vector<uint32>> classSkills = {
+        { CLASS_WARRIOR,        { SKILL_AXES, SKILL_2H_AXES, SKILL_BOWS, SKILL_GUNS, SKILL_MACES, SKILL_2H_MACES,
+                                  SKILL_POLEARMS, SKILL_SWORDS, SKILL_2H_SWORDS, SKILL_STAVES, SKILL_FIST_WEAPONS,
+                                  SKILL_DAGGERS, SKILL_THROWN, SKILL_CROSSBOWS } },
+        { CLASS_PALADIN,        { SKILL_AXES, SKILL_2H_AXES, SKILL_MACES, SKILL_2H_MACES, SKILL_POLEARMS,
+                                  SKILL_SWORDS, SKILL_2H_SWORDS } },
+        { CLASS_HUNTER,         { SKILL_AXES, SKILL_2H_AXES, SKILL_BOWS, SKILL_GUNS, SKILL_POLEARMS, SKILL_SWORDS,
+                                  SKILL_2H_SWORDS, SKILL_STAVES, SKILL_FIST_WEAPONS, SKILL_DAGGERS, SKILL_THROWN,
+                                  SKILL_CROSSBOWS } },
+        { CLASS_ROGUE,          { SKILL_BOWS, SKILL_GUNS, SKILL_MACES, SKILL_SWORDS, SKILL_FIST_WEAPONS, SKILL_DAGGERS,
+                                  SKILL_THROWN, SKILL_CROSSBOWS } },
+        { CLASS_PRIEST,         { SKILL_MACES, SKILL_STAVES, SKILL_DAGGERS, SKILL_WANDS } },
+        { CLASS_DEATH_KNIGHT,   { SKILL_AXES, SKILL_2H_AXES, SKILL_MACES, SKILL_2H_MACES, SKILL_POLEARMS,
+                                  SKILL_SWORDS, SKILL_2H_SWORDS } },
+        { CLASS_SHAMAN,         { SKILL_AXES, SKILL_2H_AXES, SKILL_MACES, SKILL_2H_MACES, SKILL_STAVES,
+                                  SKILL_FIST_WEAPONS, SKILL_DAGGERS } },
+        { CLASS_MAGE,           { SKILL_SWORDS, SKILL_STAVES, SKILL_DAGGERS, SKILL_WANDS } },
+        { CLASS_WARLOCK,        { SKILL_SWORDS, SKILL_STAVES, SKILL_DAGGERS, SKILL_WANDS } },
+        { CLASS_DRUID,          { SKILL_MACES, SKILL_2H_MACES, SKILL_POLEARMS, SKILL_STAVES, SKILL_FIST_WEAPONS,
+                                  SKILL_DAGGERS } },
+    };
+    auto fiter = classSkills.find(classId);
+    return fiter != classSkills.end()
+        && std::find(fiter->second.begin(), fiter->second.end(), skill) != fiter->second.end();
+}
+
+bool AbClassCanUseItem(uint8 classId, uint8 level, ItemTemplate const* itemTemplate)
+{
+    if (!(itemTemplate->AllowableClass & (1 << (classId - 1))))
+        return false;
+    if (itemTemplate->Class == ITEM_CLASS_WEAPON
+        && (itemTemplate->SubClass >= MAX_ITEM_SUBCLASS_WEAPON
+            || !ClassHasWeaponSkill(classId, AbWeaponSkill(itemTemplate->SubClass))))
+        return false;
+    return AbClassCanUseArmor(classId, level, itemTemplate);
+}
+
+bool AbRankSlot(AbScoringContext const& context, AbWeightProfile const& profile, uint8 minLevel, uint8 maxLevel,
+                uint32 slot, std::vector<AbRankedSlots::Entry> &entries, uint32 depth)
+{
+    AbItemCatalog const& catalog = *context.catalog;
+    AbItemFeatures const& features = *context.features;
+    // Every candidate is scored into scratch space that's reused across calls; only the best "depth" of them are
+    //  copied out, so a ranking into an "entries" that was used before doesn't allocate at all:
+    static thread_local std::vector<AbRankedSlots::Entry> scored_entries;
+    static thread_local std::vector<double> bucket_scores;
+    scored_entries.clear();
+    uint32 scored = 0;
+    for (uint32 level = minLevel; level <= maxLevel; ++level)
+        scored += catalog.GetLevel(level)[slot].size();
+    scored_entries.reserve(scored);
+    for (uint32 level = minLevel; level <= maxLevel; ++level) {
+        AbItemCatalog::Range const& range = catalog.GetLevel(level)[slot];
+        if (!range.size())
+            continue;
+        // One pass over the bucket for the stats; random enchants on top of that, below:
+        if (bucket_scores.size() < range.size())
+            bucket_scores.resize(range.size());
+        features.Score(profile, range.first, range.last, bucket_scores.data());
+        for (uint32 row = range.first; row < range.last; ++row) {
+            AbRankedSlots::Entry entry;
+            entry.item = catalog._items[row];
+            entry.row = row;
+            entry.score = bucket_scores[row - range.first];
+            entry.ench_id = 0;
+            scored_entries.push_back(entry);
+        }
+    }
+    // Timed once for the whole slot; most lookups take well under a microsecond:
+    uint32 enchants = 0;
+    {
+        AbMetrics::Clock::time_point started = AbMetrics::Clock::now();
+        for (AbRankedSlots::Entry &entry : scored_entries) {
+            if (!features._hasRandomEnchant[entry.row])
+                continue;
+            entry.score += AbBestRandomEnchant(context, profile, entry.item, entry.ench_id);
+            ++enchants;
+        }
+        if (context.metrics)
+            context.metrics->Record(AB_PHASE_RANDOM_ENCHANT, started);
+    }
+    if (context.metrics) {
+        context.metrics->Add(AB_COUNTER_ITEMS_SCORED, scored);
+        context.metrics->Add(AB_COUNTER_RANDOM_ENCHANTS, enchants);
+    }
+    // Ties go to the lower catalog row, so a ranking cut off at any depth is a prefix of the complete one:
+    auto better = [](AbRankedSlots::Entry const& left, AbRankedSlots::Entry const& right) {
+        return left.score > right.score || (left.score == right.score && left.row < right.row);
+    };
+    bool truncated = depth != 0 && scored_entries.size() > depth;
+    auto last = truncated ? scored_entries.begin() + depth : scored_entries.end();
+    if (truncated)
+        std::partial_sort(scored_entries.begin(), last, scored_entries.end(), better);
+    else
+        std::sort(scored_entries.begin(), last, better);
+    entries.assign(scored_entries.begin(), last);
+    return truncated;
+}
+
+void AbRankCandidates(AbScoringContext const& context, AbWeightProfile const& profile, uint8 minLevel,
+                      uint8 maxLevel, AbRankedSlots &ranked, uint32 depth)
+{
+    ranked.profile_id = profile.id;
+    ranked.min_level = minLevel;
+    ranked.level = maxLevel;
+    for (uint32 slot = 0; slot < MAX_INVTYPE; ++slot)
+        ranked.truncated[slot] = AbRankSlot(context, profile, minLevel, maxLevel, slot, ranked.slots[slot], depth);
+}
+
+// Candidates the player can use are exactly the ones in candidate_rows:
+static bool InputCanUse(AbSelectionInput const& input, AbRankedSlots::Entry const& entry)
+{
+    return std::binary_search(input.candidate_rows.begin(), input.candidate_rows.end(), entry.row);
+}
+
+static bool InputOwns(AbSelectionInput const& input, AbRankedSlots::Entry const& entry)
+{
+    return std::binary_search(input.owned_rows.begin(), input.owned_rows.end(), entry.row);
+}
+
+bool AbSelectFromRanked(AbRankedSlots const& ranked, AbSelectionInput const& input, std::vector<AbGrant> &grants)
+{
+    bool oh_dual = input.oh_dual;
+    bool titans_grip = input.titans_grip;
+    // At most two grants per slot; one allocation instead of growing one grant at a time:
+    grants.reserve(grants.size() + 2 * MAX_INVTYPE);
+    for (uint32 invtype = 0; invtype < MAX_INVTYPE; ++invtype) {
+        // "Main Hand" items are either ranked along with "One Handed" ones (see below), or skipped:
+        if (invtype == INVTYPE_WEAPONMAINHAND)
+            continue;
+        if (invtype == INVTYPE_SHIELD) {
+            // Don't bother with "Main Hand" and "Shield/Offhand" items. "One Handed" items are sufficient.
+            if (oh_dual || titans_grip)
+                continue;
+        }
+        // don't give one-handed weapons to warriors with Titan's Grip
+        if (invtype == INVTYPE_WEAPON && titans_grip)
+            continue;
+        // Players that can't dual wield see "Main Hand" items as "One Handed" (see AutoBis::AdjustInvType()):
+        std::vector<AbRankedSlots::Entry> const& primary = ranked.slots[invtype];
+        std::vector<AbRankedSlots::Entry> const* secondary = nullptr;
+        if (invtype == INVTYPE_WEAPON && !oh_dual)
+            secondary = &ranked.slots[INVTYPE_WEAPONMAINHAND];
+        AbTopItems<2> const& cur_items = input.have_items[invtype];
+        // The two best items that the player can use, but doesn't already have:
+        AbRankedSlots::Entry const* best[2] = { nullptr, nullptr };
+        uint32 found = 0;
+        auto pi = primary.begin();
+        auto si = secondary ? secondary->begin() : primary.end();
+        auto se = secondary ? secondary->end() : primary.end();
+        while (found < 2 && (pi != primary.end() || si != se)) {
+            // Past the end of a truncated list, we no longer know what the next best item is:
+            if ((pi == primary.end() && ranked.truncated[invtype])
+                || (secondary && si == se && ranked.truncated[INVTYPE_WEAPONMAINHAND]))
+                return false;
+            AbRankedSlots::Entry const* entry;
+            if (si == se || (pi != primary.end() && pi->score >= si->score))
+                entry = &*pi++;
+            else
+                entry = &*si++;
+            if (InputCanUse(input, *entry) && !InputOwns(input, *entry))
+                best[found++] = entry;
+        }
+        if (found < 2 && (ranked.truncated[invtype] || (secondary && ranked.truncated[INVTYPE_WEAPONMAINHAND])))
+            return false;
+        if (!found)
+            continue;
+        ItemTemplate const* cur_have = nullptr;
+        double prevscore = 0.0;
+        if (cur_items.size > 0) {
+            cur_have = cur_items.items[0].first;
+            prevscore = cur_items.items[0].second;
+        }
+        ItemTemplate const* next_item_templ = best[0]->item;
+        double nextscore = best[0]->score;
+        bool second_best = false;
+        bool use_two = (invtype == INVTYPE_FINGER || invtype == INVTYPE_TRINKET || (invtype == INVTYPE_WEAPON && oh_dual)
+                        || (invtype == INVTYPE_2HWEAPON && titans_grip));
+        // We don't beat the 1st item, but let's see if we beat the 2nd item:
+        if (cur_have && prevscore >= nextscore && use_two) {
+            // don't give duplicates:
+            if (cur_have->ItemId != next_item_templ->ItemId) {
+                if (cur_items.size > 1) {
+                    if (cur_items.items[1].first->ItemId != next_item_templ->ItemId && nextscore > cur_items.items[1].second)
+                        second_best = true;
+                } else
+                    second_best = true;
+            }
+        }
+        if (!cur_have || prevscore < nextscore || second_best) {
+            AbGrant grant;
+            grant.item_id = next_item_templ->ItemId;
+            grant.ench_id = best[0]->ench_id;
+            grants.push_back(grant);
+            // let's see if we can add two items!
+            if (!second_best && use_two && best[1]) {
+                ItemTemplate const* next_next_proto = best[1]->item;
+                double nextnext = best[1]->score;
+                // We need to beat out the best item we already have (if it exists, otherwise win automatically).
+                if (cur_have) {
+                    if (next_next_proto->ItemId != cur_have->ItemId && nextnext > prevscore)
+                        second_best = true;
+                } else
+                    second_best = true;
+                if (second_best) {
+                    AbGrant grant2;
+                    grant2.item_id = next_next_proto->ItemId;
+                    grant2.ench_id = best[1]->ench_id;
+                    grants.push_back(grant2);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+struct AbAnalyzeRow {
+    uint8 classId;
+    AbProfileId profileId;
+    char const* className;
+};
+
+static const AbAnalyzeRow abAnalyzeRows[] = {
+    { CLASS_WARRIOR,        AB_PROFILE_FURY_WARRIOR,        "warrior" },
+    { CLASS_WARRIOR,        AB_PROFILE_PROT_WARRIOR,        "warrior" },
+    { CLASS_PALADIN,        AB_PROFILE_RET_PALADIN,         "paladin" },
+    { CLASS_PALADIN,        AB_PROFILE_PROT_PALADIN,        "paladin" },
+    { CLASS_PALADIN,        AB_PROFILE_HOLY_PALADIN,        "paladin" },
+    { CLASS_HUNTER,         AB_PROFILE_BM_HUNTER,           "hunter" },
+    { CLASS_ROGUE,          AB_PROFILE_COMBAT_ROGUE,        "rogue" },
+    { CLASS_PRIEST,         AB_PROFILE_SHADOW_PRIEST,       "priest" },
+    { CLASS_PRIEST,         AB_PROFILE_DISC_PRIEST,         "priest" },
+    { CLASS_PRIEST,         AB_PROFILE_HOLY_PRIEST,         "priest" },
+    { CLASS_DEATH_KNIGHT,   AB_PROFILE_FROST_DK,            "death_knight" },
+    { CLASS_DEATH_KNIGHT,   AB_PROFILE_UNHOLY_DK,           "death_knight" },
+    { CLASS_DEATH_KNIGHT,   AB_PROFILE_BLOOD_DK,            "death_knight" },
+    { CLASS_SHAMAN,         AB_PROFILE_ENH_SHAMAN,          "shaman" },
+    { CLASS_SHAMAN,         AB_PROFILE_ELE_SHAMAN,          "shaman" },
+    { CLASS_SHAMAN,         AB_PROFILE_RESTO_SHAMAN,        "shaman" },
+    { CLASS_MAGE,           AB_PROFILE_FROST_MAGE,          "mage" },
+    { CLASS_WARLOCK,        AB_PROFILE_AFFLICTION_WARLOCK,  "warlock" },
+    { CLASS_WARLOCK,        AB_PROFILE_DESTRO_WARLOCK,      "warlock" },
+    { CLASS_DRUID,          AB_PROFILE_BOOMKIN,             "druid" },
+    { CLASS_DRUID,          AB_PROFILE_CAT_DRUID,           "druid" },
+    { CLASS_DRUID,          AB_PROFILE_BEAR_DRUID,          "druid" },
+    { CLASS_DRUID,          AB_PROFILE_RESTO_DRUID,         "druid" },
+};
+
+static char const* const abInvTypeNames[MAX_INVTYPE] = {
+    "non_equip", "head", "neck", "shoulders", "body", "chest", "waist", "legs", "feet", "wrists", "hands", "finger",
+    "trinket", "weapon", "shield", "ranged", "cloak", "2hweapon", "bag", "tabard", "robe", "weaponmainhand",
+    "weaponoffhand", "holdable", "ammo", "thrown", "rangedright", "quiver", "relic"
+};
+
+void AbAnalyze(AbScoringContext const& context, AbWeightProfile const* const* roles, uint32 threads,
+               std::vector<std::string> &lines)
+{
+    uint32 const rows = sizeof(abAnalyzeRows) / sizeof(abAnalyzeRows[0]);
+    uint32 const jobs = rows * DEFAULT_MAX_LEVEL;
+    std::vector<std::vector<std::string>> results(jobs);
+    std::atomic<uint32> next{0};
+    auto run = [&]() {
+        AbRankedSlots ranked;
+        char line[256];
+        for (uint32 job = next++; job < jobs; job = next++) {
+            AbAnalyzeRow const& row = abAnalyzeRows[job / DEFAULT_MAX_LEVEL];
+            uint8 level = job % DEFAULT_MAX_LEVEL + 1;
+            AbWeightProfile const& profile = *roles[row.profileId];
+            AbRankCandidates(context, profile, level, level, ranked);
+            for (uint32 slot = 0; slot < MAX_INVTYPE; ++slot) {
+                uint32 wanted = (slot == INVTYPE_FINGER || slot == INVTYPE_TRINKET) ? 2 : 1;
+                uint32 found = 0;
+                for (AbRankedSlots::Entry const& entry : ranked.slots[slot]) {
+                    if (found == wanted)
+                        break;
+                    if (!AbClassCanUseItem(row.classId, level, entry.item))
+                        continue;
+                    snprintf(line, sizeof(line), "%s %s L%02u %s#%u %u %d %.2f %s", row.className, profile.name,
+                             uint32(level), abInvTypeNames[slot], found + 1, entry.item->ItemId, entry.ench_id,
+                             entry.score, entry.item->Name1.c_str());
+                    results[job].push_back(line);
+                    ++found;
+                }
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (uint32 idx = 1; idx < threads; ++idx)
+        pool.emplace_back(run);
+    run();
+    for (std::thread &thread : pool)
+        thread.join();
+    for (std::vector<std::string> const& job : results)
+        lines.insert(lines.end(), job.begin(), job.end());
+}
+
+// "class profile level slot" -> "item ench":
+static std::pair<std::string, std::string> SplitAnalyzeLine(std::string const& line)
+{
+    std::istringstream fields(line);
+    std::string field, key, item;
+    for (uint32 idx = 0; idx < 6 && fields >> field; ++idx)
+        (idx < 4 ? key : item) += (idx == 0 || idx == 4 ? "" : " ") + field;
+    return std::make_pair(key, item);
+}
+
+uint32 AbDiffAnalysis(std::vector<std::string> const& lines, std::vector<std::string> const& baseline,
+                      std::vector<std::string> &diff)
+{
+    std::map<std::string, std::string> before;
+    for (std::string const& line : baseline)
+        before[SplitAnalyzeLine(line).first] = line;
+    uint32 changed = 0;
+    for (std::string const& line : lines) {
+        std::pair<std::string, std::string> fields = SplitAnalyzeLine(line);
+        auto fiter = before.find(fields.first);
+        // Scores may move without the item changing; only report different items:
+        if (fiter != before.end() && SplitAnalyzeLine(fiter->second).second == fields.second) {
+            before.erase(fiter);
+            continue;
+        }
+        if (fiter != before.end()) {
+            diff.push_back("- " + fiter->second);
+            before.erase(fiter);
+        }
+        diff.push_back("+ " + line);
+        ++changed;
+    }
+    for (auto const& gone : before) {
+        diff.push_back("- " + gone.second);
+        ++changed;
+    }
+    return changed;
+}
+
+bool AbReadLines(std::string const& path, std::vector<std::string> &lines)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        while (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        lines.push_back(line);
+    }
+    return true;
+}
+
+bool AbWriteLines(std::string const& path, std::vector<std::string> const& lines)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+    for (std::string const& line : lines)
+        fprintf(file, "%s\n", line.c_str());
+    return fclose(file) == 0;
+}
@@ -0,0 +1,274 @@
+#ifndef __AUTOBIS_SCORE_H__
+#define __AUTOBIS_SCORE_H__
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DBCEnums.h"
+#include "Define.h"
+#include "ItemTemplate.h"
+
+class AbMetrics;
+
+//
+// The scoring core: from item templates and a weight table to ranked slots and the items a player should get. Nothing
+//  in here touches the core's singletons (sObjectMgr, the DBC stores, SpellMgr, the databases); what scoring needs
+//  from them comes through AbScoreData. That way the server and the programs in tools/ run the exact same code.
+//
+
+// A ScoreWeightMap compiled for scoring: a flat array indexed by ITEM_MOD id, plus fixed slots for the
+//  pseudo-stats (-1 = melee DPS, -2 = armor, -3 = ranged DPS). Every weight is already divided by the total weight.
+struct alignas(64) AbWeightProfile {
+    static constexpr uint32 MAX_STATS = 64; // power of two > MAX_ITEM_MOD; the last entry is always 0
+    double stats[MAX_STATS] = { };
+    double melee_dps = 0.0;
+    double armor = 0.0;
+    double ranged_dps = 0.0;
+    uint32 id = 0;
+    char const* name = "";
+
+    // Out-of-range (including negative) stat ids land on the last entry, which is always 0:
+    double Stat(int32 statId) const { return stats[std::min<uint32>(uint32(statId), MAX_STATS - 1)]; }
+};
+static_assert(MAX_ITEM_MOD < AbWeightProfile::MAX_STATS, "AbWeightProfile::stats is too small");
+
+using AbItemList = std::vector<ItemTemplate const*>;
+// Stat weights by ITEM_MOD id, plus -1 = melee DPS, -2 = armor, -3 = ranged DPS:
+using AbScoreWeightMap = std::map<int32, double>;
+
+AbWeightProfile AbCompileWeightProfile(AbScoreWeightMap const& score_weights, uint32 id, char const* name);
+
+// The best N items fed to it, best first, kept inline so that filling one doesn't allocate:
+template <uint32 N>
+struct AbTopItems {
+    std::pair<ItemTemplate const*, double> items[N] = { };
+    uint32 size = 0;
+
+    void Push(ItemTemplate const* item, double score)
+    {
+        uint32 pos = size;
+        while (pos > 0 && items[pos - 1].second < score)
+            --pos;
+        if (pos >= N)
+            return;
+        for (uint32 idx = std::min(size, N - 1); idx > pos; --idx)
+            items[idx] = items[idx - 1];
+        items[pos] = { item, score };
+        if (size < N)
+            ++size;
+    }
+};
+
+// Selection only ever compares against the best two owned items of a slot:
+using AbHaveSlots = std::array<AbTopItems<2>, MAX_INVTYPE>;
+
+// What selection needs to know about a player (see AbPlayerSnapshot, which takes it from a live one):
+struct AbSelectionInput {
+    uint8 level = 0;
+    uint8 min_level = 0;                        // RequiredLevel range of candidate_rows (see AbLevelRange)
+    uint8 max_level = 0;
+    bool oh_dual = false;
+    bool titans_grip = false;
+    AbWeightProfile const* profile = nullptr;
+    // Best usable items in the player's inventory, bags and bank, by adjusted InventoryType:
+    AbHaveSlots have_items;
+    std::vector<uint32> owned_rows;             // item catalog rows of all of those, sorted
+    std::vector<uint32> candidate_rows;         // usable item catalog rows in [min_level, max_level], sorted
+};
+
+// Every candidate in a level range, ranked per slot for one weight profile. Scores only depend on (profile, level), so
+//  a ranking can be shared by any number of players; each player then only filters it by what they can use and
+//  what they already own.
+struct AbRankedSlots {
+    struct Entry {
+        ItemTemplate const* item;
+        double score;
+        int32 ench_id;      // best random enchant, 0 if none
+        uint32 row;         // in the item catalog
+    };
+    uint32 profile_id = 0;
+    uint8 min_level = 0;
+    uint8 level = 0;    // the highest RequiredLevel in the ranking
+    // Indexed by the statically adjusted InventoryType ("Main Hand" items are kept apart), best first:
+    std::array<std::vector<Entry>, MAX_INVTYPE> slots;
+    // Set for slots that only hold the top K of their bucket(s) (see AbBisTable):
+    std::array<bool, MAX_INVTYPE> truncated{};
+};
+
+// An item Process() decided to hand out:
+struct AbGrant {
+    uint32 item_id = 0;
+    int32 ench_id = 0;
+};
+
+// Everything scoring needs besides the item templates. The server implements it on top of SpellMgr, the DBC stores
+//  and item_enchantment_template (see AbServerScoreData); tools/ on top of an export of the same data.
+class AbScoreData {
+    public:
+        struct Stat {
+            int32 stat_id;  // ITEM_MOD id
+            int32 value;    // for random suffixes, AllocationPct (scaled by the item's suffix factor)
+        };
+        // Up to 3 enchantments with 3 effects each:
+        static constexpr uint32 MAX_RANDOM_ENCHANT_STATS = 9;
+        struct RandomEnchant {
+            uint32 count = 0;
+            Stat stats[MAX_RANDOM_ENCHANT_STATS];
+        };
+
+        virtual ~AbScoreData() { }
+        // "Equip: Increase X by Y" stats of one on-equip spell, each stat at most once. Sets [first, last), which is
+        //  empty for spells we don't weigh anything of:
+        virtual void GetEquipSpellStats(uint32 spellId, Stat const*& first, Stat const*& last) const = 0;
+        // What item_enchantment_template's pool "ench_idx" can roll; nullptr if there's no such pool:
+        virtual std::vector<uint32> const* GetEnchantPool(uint32 ench_idx) const = 0;
+        // The stat effects of ItemRandomProperties (or, rand_suffix, ItemRandomSuffix) entry "ench".
+        // return: false if there's no such entry:
+        virtual bool GetRandomEnchant(uint32 ench, bool rand_suffix, RandomEnchant &enchant) const = 0;
+        // see GenerateEnchSuffixFactor():
+        virtual uint32 GetSuffixFactor(ItemTemplate const* itemTemplate) const = 0;
+};
+
+// The part of AutoBis::AdjustInvType() that doesn't depend on the player. "Main Hand" items are left alone, since
+//  whether they compete with "One Handed" items depends on whether the player can dual wield.
+void AbAdjustStaticInvType(uint32 &inv_type);
+// dmg_min1/dmg_max1 are already loaded into ItemTemplate::Damage[0], so there's no need to query for them:
+double AbWeaponDps(ItemTemplate const* itemTemplate);
+// Everything but random enchants:
+double AbBaseScore(AbScoreData const& data, AbWeightProfile const& profile, ItemTemplate const* itemTemplate);
+// Scores every enchant of the pool; returns -1000.0 if the pool has no usable enchant:
+double AbFindBestEnchant(AbScoreData const& data, AbWeightProfile const& profile, uint32 ench_idx, bool rand_suffix,
+                         uint32 scalefact, int32& enchId);
+// The skill a weapon subclass needs (0 if none); copy from function Item::GetSkill():
+uint32 AbWeaponSkill(uint32 subclass);
+// The shield, armor type and relic rules, which only depend on the class (and level):
+bool AbClassCanUseArmor(uint8 classId, uint8 level, ItemTemplate const* itemTemplate);
+// What a class could use at a level, with no player to ask: the armor rules, AllowableClass and the weapon skills
+//  the class can train:
+bool AbClassCanUseItem(uint8 classId, uint8 level, ItemTemplate const* itemTemplate);
+
+//
+// Every item Process() could ever hand out, built once at startup from the item templates.
+//
+// This used to be a "SELECT entry FROM item_template WHERE ..." on every invocation (blocking the world thread),
+//  followed by a GetItemTemplate() for every row. IsCandidate() applies the exact same filters as that query did.
+struct AbItemCatalog {
+    // [first, last) into _items:
+    struct Range {
+        uint32 first = 0;
+        uint32 last = 0;
+        uint32 size() const { return last - first; }
+    };
+    using SlotRanges = std::array<Range, MAX_INVTYPE>;
+    // "templates" is every item template there is; only candidates are kept:
+    void Load(AbItemList const& templates);
+    static bool IsCandidate(ItemTemplate const* itemTemplate);
+    // Ranges are indexed by the AbAdjustStaticInvType()'d InventoryType:
+    SlotRanges const& GetLevel(uint8 level) const { return _ranges[level]; }
+    static constexpr uint32 NO_ROW = ~0u;
+    uint32 RowOf(uint32 itemId) const
+    {
+        auto fiter = _rows.find(itemId);
+        return fiter != _rows.end() ? fiter->second : NO_ROW;
+    }
+    // Sorted by (RequiredLevel, adjusted InventoryType, entry), so each bucket is contiguous and in query order:
+    AbItemList _items;
+    std::unordered_map<uint32, uint32> _rows; // entry -> index into _items
+    std::array<SlotRanges, DEFAULT_MAX_LEVEL + 1> _ranges;
+    bool _loaded = false;
+};
+
+//
+// Struct-of-arrays copy of everything AbBaseScore() looks at, one row per catalog item in the same order as
+//  AbItemCatalog::_items. Equip-spell stats, block value, armor and DPS are folded in at load, so scoring a whole
+//  bucket against a profile is a single streaming pass over a few float columns.
+//
+// Columns are identified the same way ScoreWeightMap keys are: an ITEM_MOD id, or -1/-2/-3 for the pseudo-stats.
+struct AbItemFeatures {
+    void Load(AbScoreData const& data, AbItemList const& items);
+    // Writes the score of rows [first, last) into out[0 .. last - first):
+    void Score(AbWeightProfile const& profile, uint32 first, uint32 last, double* out) const;
+    static double ColumnWeight(AbWeightProfile const& profile, int32 column);
+
+    std::vector<int32> _columnIds;
+    std::vector<float> _values;     // column c, row r is at _values[c * _stride + r]
+    std::vector<uint8> _hasRandomEnchant;
+    uint32 _rows = 0;
+    uint32 _stride = 0;
+};
+
+//
+// The best enchant of every (weight profile, RandomProperty/RandomSuffix pool, suffix factor) combination used by a
+//  catalog item, which turns AbBestRandomEnchant() into a lookup for every item autobis can hand out. Immutable once
+//  built, so any number of callers can read it without locking.
+struct AbBestEnchants {
+    struct BestEnchant {
+        int32 ench_id;
+        double score;
+    };
+    // Adds whatever isn't there yet:
+    void Precompute(AbScoreData const& data, AbItemList const& items, AbWeightProfile const* profiles,
+                    uint32 profileCount);
+    BestEnchant const* Get(uint32 profileId, uint32 ench_idx, bool rand_suffix, uint32 scalefact) const;
+    // Pools and factors that don't fit the key are simply never precomputed (AbFindBestEnchant() handles them):
+    static bool FitsKey(uint32 profileId, uint32 ench_idx, uint32 scalefact)
+    {
+        return profileId < (1u << 16) && ench_idx < (1u << 23) && scalefact < (1u << 24);
+    }
+    static uint64 Key(uint32 profileId, uint32 ench_idx, bool rand_suffix, uint32 scalefact)
+    {
+        return (uint64(profileId) << 48) | (uint64(rand_suffix) << 47) | (uint64(ench_idx) << 24) | scalefact;
+    }
+
+    std::unordered_map<uint64, BestEnchant> _best;
+};
+
+// Everything a ranking is computed from:
+struct AbScoringContext {
+    AbScoreData const* data = nullptr;
+    AbItemCatalog const* catalog = nullptr;
+    AbItemFeatures const* features = nullptr;
+    AbBestEnchants const* enchants = nullptr;   // may be null, in which case every enchant is computed
+    AbMetrics* metrics = nullptr;               // may be null
+};
+
+// return: score of the best enchant; also populates "enchId" (set to 0 if the item has none, or none of its enchants
+//  is worth anything):
+double AbBestRandomEnchant(AbScoringContext const& context, AbWeightProfile const& profile,
+                           ItemTemplate const* itemProto, int32& enchId);
+// How deep a ranking made for a request goes (see AbRankSlot()). Selection needs the two best items of a slot that
+//  the player can use and doesn't own; the few that run out before that fall back to a complete ranking:
+static constexpr uint32 AB_RANK_DEPTH = 32;
+
+// One slot of AbRankCandidates(); keeps the best "depth" (0: all) of them. return: true if that left any out:
+bool AbRankSlot(AbScoringContext const& context, AbWeightProfile const& profile, uint8 minLevel, uint8 maxLevel,
+                uint32 slot, std::vector<AbRankedSlots::Entry> &entries, uint32 depth = 0);
+// Ranks every candidate with a RequiredLevel in [minLevel, maxLevel], down to "depth" (0: all) per slot; slots that
+//  had more than that are marked truncated:
+void AbRankCandidates(AbScoringContext const& context, AbWeightProfile const& profile, uint8 minLevel,
+                      uint8 maxLevel, AbRankedSlots &ranked, uint32 depth = 0);
+// The upgrades "input" should get out of "ranked". return: false if a truncated slot ran out before we could be sure:
+bool AbSelectFromRanked(AbRankedSlots const& ranked, AbSelectionInput const& input, std::vector<AbGrant> &grants);
+
+//
+// The best item per (class, weight table, level, slot), for tuning the weight tables; see ".autobis analyze" and
+//  tools/autobis_analyze. "roles" are the weight tables to use, indexed by AbProfileId. Levels are ranked in parallel,
+//  on "threads" threads, and written one line per slot in a fixed order, so two reports can be diffed as they are.
+//
+// Nobody is logged in as these characters, so usability only applies the class rules (see AbClassCanUseItem()).
+//  Nothing is owned, and nobody dual wields or has Titan's Grip.
+void AbAnalyze(AbScoringContext const& context, AbWeightProfile const* const* roles, uint32 threads,
+               std::vector<std::string> &lines);
+// The lines of "lines" whose item changed against "baseline" (scores may move without the item changing), as
+//  "- old" and "+ new" lines. return: the number of slots that changed:
+uint32 AbDiffAnalysis(std::vector<std::string> const& lines, std::vector<std::string> const& baseline,
+                      std::vector<std::string> &diff);
+// Reports and baselines, one line each (without the line ends). return: false if the file can't be read/written:
+bool AbReadLines(std::string const& path, std::vector<std::string> &lines);
+bool AbWriteLines(std::string const& path, std::vector<std::string> const& lines);
+
+#endif
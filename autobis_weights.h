@@ -0,0 +1,411 @@
+// Generated by tools/autobis_genweights.py from tools/Wowhead.lua; don't edit, rerun the script instead.
+#ifndef __AUTOBIS_WEIGHTS_H__
+#define __AUTOBIS_WEIGHTS_H__
+
+#include <initializer_list>
+
+#include "autobis_score.h"
+
+// The built-in weight tables, in the same order as abWeightProfiles:
+enum AbProfileId : uint32 {
+    AB_PROFILE_RET_PALADIN,
+    AB_PROFILE_PROT_PALADIN,
+    AB_PROFILE_FURY_WARRIOR,
+    AB_PROFILE_COMBAT_ROGUE,
+    AB_PROFILE_FROST_MAGE,
+    AB_PROFILE_BM_HUNTER,
+    AB_PROFILE_BOOMKIN,
+    AB_PROFILE_CAT_DRUID,
+    AB_PROFILE_ENH_SHAMAN,
+    AB_PROFILE_SHADOW_PRIEST,
+    AB_PROFILE_AFFLICTION_WARLOCK,
+    AB_PROFILE_DESTRO_WARLOCK,
+    AB_PROFILE_FROST_DK,
+    AB_PROFILE_UNHOLY_DK,
+    AB_PROFILE_BLOOD_DK,
+    AB_PROFILE_PROT_WARRIOR,
+    AB_PROFILE_BEAR_DRUID,
+    AB_PROFILE_HOLY_PALADIN,
+    AB_PROFILE_DISC_PRIEST,
+    AB_PROFILE_HOLY_PRIEST,
+    AB_PROFILE_ELE_SHAMAN,
+    AB_PROFILE_RESTO_SHAMAN,
+    AB_PROFILE_RESTO_DRUID,
+    MAX_AB_PROFILES
+};
+
+struct AbGeneratedWeight {
+    int32 stat;     // ScoreWeightMap key
+    double weight;  // already divided by the total weight
+};
+
+constexpr AbWeightProfile AbGeneratedProfile(uint32 id, char const* name,
+                                             std::initializer_list<AbGeneratedWeight> weights)
+{
+    AbWeightProfile profile;
+    profile.id = id;
+    profile.name = name;
+    for (AbGeneratedWeight const& entry : weights) {
+        if (entry.stat == -1)
+            profile.melee_dps = entry.weight;
+        else if (entry.stat == -2)
+            profile.armor = entry.weight;
+        else if (entry.stat == -3)
+            profile.ranged_dps = entry.weight;
+        else
+            profile.stats[entry.stat] = entry.weight;
+    }
+    return profile;
+}
+
+static constexpr AbWeightProfile abWeightProfiles[MAX_AB_PROFILES] = {
+    // PaladinRetribution:
+    AbGeneratedProfile(AB_PROFILE_RET_PALADIN, "ret_paladin", {
+        { -3, 1.1721816445497481e-07 },  // ranged_DPS
+        { -2, 1.172181644549748e-05 },  // armor
+        { -1, 0.5509253729383816 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.037509812625591936 },
+        { ITEM_MOD_STRENGTH, 0.09377453156397984 },
+        { ITEM_MOD_STAMINA, 0.00011721816445497481 },
+        { ITEM_MOD_HIT_RATING, 0.08205271511848236 },
+        { ITEM_MOD_CRIT_RATING, 0.04688726578198992 },
+        { ITEM_MOD_HASTE_RATING, 0.03516544933649244 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.07736398854028337 },
+        { ITEM_MOD_ATTACK_POWER, 0.03985417591469143 },
+        { ITEM_MOD_ARMOR_PENETRATION_RATING, 0.025787996180094457 },
+        { ITEM_MOD_SPELL_POWER, 0.010549634800947732 },
+    }),
+    // PaladinProtection:
+    AbGeneratedProfile(AB_PROFILE_PROT_PALADIN, "prot_paladin", {
+        { -2, 0.020725388064109118 },  // armor
+        { -1, 2.59067350801364e-08 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.1554404104808184 },
+        { ITEM_MOD_STRENGTH, 0.041450776128218236 },
+        { ITEM_MOD_STAMINA, 0.259067350801364 },
+        { ITEM_MOD_DEFENSE_SKILL_RATING, 0.1165803078606138 },
+        { ITEM_MOD_DODGE_RATING, 0.14248704294075018 },
+        { ITEM_MOD_PARRY_RATING, 0.0777202052404092 },
+        { ITEM_MOD_BLOCK_RATING, 0.01813471455609548 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.15284973697280474 },
+        { ITEM_MOD_BLOCK_VALUE, 0.015544041048081839 },
+    }),
+    // WarriorFury:
+    AbGeneratedProfile(AB_PROFILE_FURY_WARRIOR, "fury_warrior", {
+        { -3, 2.11367290615863e-07 },  // ranged_DPS
+        { -2, 0.01056836453079315 },  // armor
+        { -1, 2.1136729061586298e-05 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.11202466402640739 },
+        { ITEM_MOD_STRENGTH, 0.17332117830500765 },
+        { ITEM_MOD_STAMINA, 0.000211367290615863 },
+        { ITEM_MOD_HIT_RATING, 0.10145629949561423 },
+        { ITEM_MOD_CRIT_RATING, 0.13950241180646958 },
+        { ITEM_MOD_HASTE_RATING, 0.07609222462171068 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.21136729061586298 },
+        { ITEM_MOD_ATTACK_POWER, 0.06552386009091753 },
+        { ITEM_MOD_ARMOR_PENETRATION_RATING, 0.10991099112024875 },
+    }),
+    // RogueCombat:
+    AbGeneratedProfile(AB_PROFILE_COMBAT_ROGUE, "combat_rogue", {
+        { -3, 1.1974468995166028e-07 },  // ranged_DPS
+        { -2, 1.1974468995166028e-05 },  // armor
+        { -1, 0.2634383178936526 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.11974468995166027 },
+        { ITEM_MOD_STRENGTH, 0.06585957947341314 },
+        { ITEM_MOD_STAMINA, 0.00011974468995166027 },
+        { ITEM_MOD_HIT_RATING, 0.09579575196132821 },
+        { ITEM_MOD_CRIT_RATING, 0.0898085174637452 },
+        { ITEM_MOD_HASTE_RATING, 0.08741362366471199 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.09819064576036142 },
+        { ITEM_MOD_ATTACK_POWER, 0.05987234497583013 },
+        { ITEM_MOD_ARMOR_PENETRATION_RATING, 0.11974468995166027 },
+    }),
+    // MageFrost:
+    AbGeneratedProfile(AB_PROFILE_FROST_MAGE, "frost_mage", {
+        { -3, 5.373446469457599e-07 },  // ranged_DPS
+        { -2, 5.373446469457599e-07 },  // armor
+        { -1, 5.373446469457599e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.03224067881674559 },
+        { ITEM_MOD_STAMINA, 0.0005373446469457599 },
+        { ITEM_MOD_HIT_RATING, 0.4298757175566079 },
+        { ITEM_MOD_CRIT_RATING, 0.10209548291969438 },
+        { ITEM_MOD_HASTE_RATING, 0.22568475171721916 },
+        { ITEM_MOD_SPELL_POWER, 0.20956441230884634 },
+    }),
+    // HunterBeastMastery:
+    AbGeneratedProfile(AB_PROFILE_BM_HUNTER, "bm_hunter", {
+        { -3, 0.42003533029566936 },  // ranged_DPS
+        { -2, 1.971996855848213e-07 },  // armor
+        { -1, 1.971996855848213e-07 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.11437581763919635 },
+        { ITEM_MOD_INTELLECT, 0.07296388366638387 },
+        { ITEM_MOD_STAMINA, 0.00019719968558482132 },
+        { ITEM_MOD_HIT_RATING, 0.15775974846785704 },
+        { ITEM_MOD_CRIT_RATING, 0.07887987423392852 },
+        { ITEM_MOD_HASTE_RATING, 0.041411933972812474 },
+        { ITEM_MOD_ATTACK_POWER, 0.059159905675446385 },
+        { ITEM_MOD_ARMOR_PENETRATION_RATING, 0.05521591196374996 },
+    }),
+    // DruidBalance:
+    AbGeneratedProfile(AB_PROFILE_BOOMKIN, "boomkin", {
+        { -3, 3.483103291776428e-07 },  // ranged_DPS
+        { -2, 3.483103291776428e-07 },  // armor
+        { -1, 3.483103291776428e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.07662827241908142 },
+        { ITEM_MOD_SPIRIT, 0.07662827241908142 },
+        { ITEM_MOD_STAMINA, 0.00034831032917764283 },
+        { ITEM_MOD_HIT_RATING, 0.27864826334211423 },
+        { ITEM_MOD_CRIT_RATING, 0.1497734415463864 },
+        { ITEM_MOD_HASTE_RATING, 0.1880875777559271 },
+        { ITEM_MOD_SPELL_POWER, 0.22988481725724424 },
+    }),
+    // DruidFeralDps:
+    AbGeneratedProfile(AB_PROFILE_CAT_DRUID, "cat_druid", {
+        { -3, 1.9995592971309126e-07 },  // ranged_DPS
+        { -2, 1.9995592971309126e-07 },  // armor
+        { -1, 1.9995592971309127e-05 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.19995592971309126 },
+        { ITEM_MOD_STRENGTH, 0.159964743770473 },
+        { ITEM_MOD_STAMINA, 0.00019995592971309127 },
+        { ITEM_MOD_HIT_RATING, 0.09997796485654563 },
+        { ITEM_MOD_CRIT_RATING, 0.10997576134220019 },
+        { ITEM_MOD_HASTE_RATING, 0.06998457539958194 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.09997796485654563 },
+        { ITEM_MOD_ATTACK_POWER, 0.0799823718852365 },
+        { ITEM_MOD_ARMOR_PENETRATION_RATING, 0.17996033674178213 },
+    }),
+    // ShamanEnhancement:
+    AbGeneratedProfile(AB_PROFILE_ENH_SHAMAN, "enh_shaman", {
+        { -3, 1.617834751446385e-07 },  // ranged_DPS
+        { -2, 1.6178347514463847e-05 },  // armor
+        { -1, 0.21840769144526195 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.08898091132955116 },
+        { ITEM_MOD_STRENGTH, 0.05662421630062347 },
+        { ITEM_MOD_INTELLECT, 0.08898091132955116 },
+        { ITEM_MOD_STAMINA, 0.00016178347514463848 },
+        { ITEM_MOD_HIT_RATING, 0.11324843260124694 },
+        { ITEM_MOD_CRIT_RATING, 0.08898091132955116 },
+        { ITEM_MOD_HASTE_RATING, 0.06794905956074816 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.13589811912149632 },
+        { ITEM_MOD_ATTACK_POWER, 0.05177071204628431 },
+        { ITEM_MOD_ARMOR_PENETRATION_RATING, 0.042063703537606 },
+        { ITEM_MOD_SPELL_POWER, 0.04691720779194516 },
+    }),
+    // PriestShadow:
+    AbGeneratedProfile(AB_PROFILE_SHADOW_PRIEST, "shadow_priest", {
+        { -3, 3.423481591768307e-07 },  // ranged_DPS
+        { -2, 3.423481591768307e-07 },  // armor
+        { -1, 3.423481591768307e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.05477570546829291 },
+        { ITEM_MOD_SPIRIT, 0.05477570546829291 },
+        { ITEM_MOD_STAMINA, 0.0003423481591768307 },
+        { ITEM_MOD_HIT_RATING, 0.27387852734146456 },
+        { ITEM_MOD_CRIT_RATING, 0.18486800595548858 },
+        { ITEM_MOD_HASTE_RATING, 0.17117407958841535 },
+        { ITEM_MOD_SPELL_POWER, 0.26018460097439133 },
+    }),
+    // WarlockAffliction:
+    AbGeneratedProfile(AB_PROFILE_AFFLICTION_WARLOCK, "affliction_warlock", {
+        { -3, 3.3433600701838144e-07 },  // ranged_DPS
+        { -2, 3.3433600701838144e-07 },  // armor
+        { -1, 3.3433600701838144e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.05015040105275722 },
+        { ITEM_MOD_SPIRIT, 0.1136742423862497 },
+        { ITEM_MOD_STAMINA, 0.00033433600701838145 },
+        { ITEM_MOD_HIT_RATING, 0.26746880561470515 },
+        { ITEM_MOD_CRIT_RATING, 0.12704768266698496 },
+        { ITEM_MOD_HASTE_RATING, 0.20060160421102888 },
+        { ITEM_MOD_SPELL_POWER, 0.24072192505323464 },
+    }),
+    // WarlockDestruction:
+    AbGeneratedProfile(AB_PROFILE_DESTRO_WARLOCK, "destro_warlock", {
+        { -3, 3.400200543828075e-07 },  // ranged_DPS
+        { -2, 3.400200543828075e-07 },  // armor
+        { -1, 3.400200543828075e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.04760280761359305 },
+        { ITEM_MOD_SPIRIT, 0.08840521413952995 },
+        { ITEM_MOD_STAMINA, 0.0003400200543828075 },
+        { ITEM_MOD_HIT_RATING, 0.272016043506246 },
+        { ITEM_MOD_CRIT_RATING, 0.1632096261037476 },
+        { ITEM_MOD_HASTE_RATING, 0.1904112304543722 },
+        { ITEM_MOD_SPELL_POWER, 0.23801403806796526 },
+    }),
+    // DeathKnightFrostDps:
+    AbGeneratedProfile(AB_PROFILE_FROST_DK, "frost_dk", {
+        { -3, 1.319069617988205e-07 },  // ranged_DPS
+        { -2, 1.319069617988205e-05 },  // armor
+        { -1, 0.3957208853964615 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.0263813923597641 },
+        { ITEM_MOD_STRENGTH, 0.1319069617988205 },
+        { ITEM_MOD_STAMINA, 0.0001319069617988205 },
+        { ITEM_MOD_HIT_RATING, 0.09893022134911537 },
+        { ITEM_MOD_CRIT_RATING, 0.05935813280946922 },
+        { ITEM_MOD_HASTE_RATING, 0.06595348089941025 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.09233487325917435 },
+        { ITEM_MOD_ATTACK_POWER, 0.05012464548355179 },
+        { ITEM_MOD_ARMOR_PENETRATION_RATING, 0.07914417707929229 },
+    }),
+    // DeathKnightUnholyDps:
+    AbGeneratedProfile(AB_PROFILE_UNHOLY_DK, "unholy_dk", {
+        { -3, 1.6635887502139792e-07 },  // ranged_DPS
+        { -2, 1.6635887502139792e-05 },  // armor
+        { -1, 0.34769004879472165 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.026617420003423667 },
+        { ITEM_MOD_STRENGTH, 0.1663588750213979 },
+        { ITEM_MOD_STAMINA, 0.00016635887502139792 },
+        { ITEM_MOD_HIT_RATING, 0.10979685751412262 },
+        { ITEM_MOD_CRIT_RATING, 0.07486149375962906 },
+        { ITEM_MOD_HASTE_RATING, 0.079852260010271 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.08484302626091293 },
+        { ITEM_MOD_ATTACK_POWER, 0.05656201750727529 },
+        { ITEM_MOD_ARMOR_PENETRATION_RATING, 0.053234840006847334 },
+    }),
+    // DeathKnightBloodTank:
+    AbGeneratedProfile(AB_PROFILE_BLOOD_DK, "blood_dk", {
+        { -3, 1.8382349562068098e-07 },  // ranged_DPS
+        { -2, 0.011029409737240857 },  // armor
+        { -1, 0.09191174781034048 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.07352939824827238 },
+        { ITEM_MOD_STRENGTH, 0.06985292833585877 },
+        { ITEM_MOD_STAMINA, 0.18382349562068095 },
+        { ITEM_MOD_DEFENSE_SKILL_RATING, 0.1562499712775788 },
+        { ITEM_MOD_DODGE_RATING, 0.12867644693447666 },
+        { ITEM_MOD_PARRY_RATING, 0.11948527215344262 },
+        { ITEM_MOD_HIT_RATING, 0.055147048686204285 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.11029409737240857 },
+    }),
+    // WarriorProtection:
+    AbGeneratedProfile(AB_PROFILE_PROT_WARRIOR, "prot_warrior", {
+        { -3, 1.689188903853226e-07 },  // ranged_DPS
+        { -2, 0.011824322326972581 },  // armor
+        { -1, 0.033783778077064515 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.06756755615412903 },
+        { ITEM_MOD_STRENGTH, 0.0591216116348629 },
+        { ITEM_MOD_STAMINA, 0.16891889038532257 },
+        { ITEM_MOD_DEFENSE_SKILL_RATING, 0.1435810568275242 },
+        { ITEM_MOD_DODGE_RATING, 0.1182432232697258 },
+        { ITEM_MOD_PARRY_RATING, 0.10979727875045968 },
+        { ITEM_MOD_BLOCK_RATING, 0.07601350067339516 },
+        { ITEM_MOD_HIT_RATING, 0.050675667115596776 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.09290538971192741 },
+        { ITEM_MOD_BLOCK_VALUE, 0.06756755615412903 },
+    }),
+    // DruidFeralTank:
+    AbGeneratedProfile(AB_PROFILE_BEAR_DRUID, "bear_druid", {
+        { -3, 2.2572848790580625e-07 },  // ranged_DPS
+        { -2, 0.04063112782304512 },  // armor
+        { -1, 2.2572848790580624e-05 },  // melee_DPS
+        { ITEM_MOD_AGILITY, 0.18058279032464497 },
+        { ITEM_MOD_STRENGTH, 0.06771854637174186 },
+        { ITEM_MOD_STAMINA, 0.22572848790580624 },
+        { ITEM_MOD_DEFENSE_SKILL_RATING, 0.12415066834819342 },
+        { ITEM_MOD_DODGE_RATING, 0.14672351713877405 },
+        { ITEM_MOD_HIT_RATING, 0.06771854637174186 },
+        { ITEM_MOD_EXPERTISE_RATING, 0.1015778195576128 },
+        { ITEM_MOD_ATTACK_POWER, 0.04514569758116124 },
+    }),
+    // PaladinHoly:
+    AbGeneratedProfile(AB_PROFILE_HOLY_PALADIN, "holy_paladin", {
+        { -3, 3.057166257566869e-07 },  // ranged_DPS
+        { -2, 3.057166257566869e-07 },  // armor
+        { -1, 3.057166257566869e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.30571662575668684 },
+        { ITEM_MOD_STAMINA, 0.0003057166257566869 },
+        { ITEM_MOD_CRIT_RATING, 0.14062964784807597 },
+        { ITEM_MOD_HASTE_RATING, 0.1070008190148404 },
+        { ITEM_MOD_MANA_REGENERATION, 0.26903063066588445 },
+        { ITEM_MOD_SPELL_POWER, 0.1773156429388784 },
+    }),
+    // PriestDiscipline:
+    AbGeneratedProfile(AB_PROFILE_DISC_PRIEST, "disc_priest", {
+        { -3, 2.769313678221813e-07 },  // ranged_DPS
+        { -2, 2.769313678221813e-07 },  // armor
+        { -1, 2.769313678221813e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.18000538908441782 },
+        { ITEM_MOD_SPIRIT, 0.060924900920879876 },
+        { ITEM_MOD_STAMINA, 0.00027693136782218125 },
+        { ITEM_MOD_CRIT_RATING, 0.132927056554647 },
+        { ITEM_MOD_HASTE_RATING, 0.16338950701508695 },
+        { ITEM_MOD_MANA_REGENERATION, 0.18554401644086144 },
+        { ITEM_MOD_SPELL_POWER, 0.27693136782218125 },
+    }),
+    // PriestHoly:
+    AbGeneratedProfile(AB_PROFILE_HOLY_PRIEST, "holy_priest", {
+        { -3, 2.486941690916421e-07 },  // ranged_DPS
+        { -2, 2.486941690916421e-07 },  // armor
+        { -1, 2.486941690916421e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.16165120990956736 },
+        { ITEM_MOD_SPIRIT, 0.18154674343689872 },
+        { ITEM_MOD_STAMINA, 0.0002486941690916421 },
+        { ITEM_MOD_CRIT_RATING, 0.09450378425482399 },
+        { ITEM_MOD_HASTE_RATING, 0.14672955976406885 },
+        { ITEM_MOD_MANA_REGENERATION, 0.1666250932914002 },
+        { ITEM_MOD_SPELL_POWER, 0.2486941690916421 },
+    }),
+    // ShamanElemental:
+    AbGeneratedProfile(AB_PROFILE_ELE_SHAMAN, "ele_shaman", {
+        { -3, 3.920026750262544e-07 },  // ranged_DPS
+        { -2, 3.920026750262544e-07 },  // armor
+        { -1, 3.920026750262544e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.04312029425288798 },
+        { ITEM_MOD_STAMINA, 0.00039200267502625437 },
+        { ITEM_MOD_HIT_RATING, 0.3136021400210035 },
+        { ITEM_MOD_CRIT_RATING, 0.15680107001050175 },
+        { ITEM_MOD_HASTE_RATING, 0.21952149801470244 },
+        { ITEM_MOD_MANA_REGENERATION, 0.03136021400210035 },
+        { ITEM_MOD_SPELL_POWER, 0.23520160501575263 },
+    }),
+    // ShamanRestoration:
+    AbGeneratedProfile(AB_PROFILE_RESTO_SHAMAN, "resto_shaman", {
+        { -3, 2.7847373004143967e-07 },  // ranged_DPS
+        { -2, 2.7847373004143967e-07 },  // armor
+        { -1, 2.7847373004143967e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.23670267053522373 },
+        { ITEM_MOD_STAMINA, 0.0002784737300414397 },
+        { ITEM_MOD_CRIT_RATING, 0.1726537126256926 },
+        { ITEM_MOD_HASTE_RATING, 0.09746580551450389 },
+        { ITEM_MOD_MANA_REGENERATION, 0.27847373004143966 },
+        { ITEM_MOD_SPELL_POWER, 0.21442477213190855 },
+    }),
+    // DruidRestoration:
+    AbGeneratedProfile(AB_PROFILE_RESTO_DRUID, "resto_druid", {
+        { -3, 3.0854645922882517e-07 },  // ranged_DPS
+        { -2, 3.0854645922882517e-07 },  // armor
+        { -1, 3.0854645922882517e-07 },  // melee_DPS
+        { ITEM_MOD_INTELLECT, 0.15735869420670082 },
+        { ITEM_MOD_SPIRIT, 0.09873486695322405 },
+        { ITEM_MOD_STAMINA, 0.00030854645922882514 },
+        { ITEM_MOD_CRIT_RATING, 0.03394011051517076 },
+        { ITEM_MOD_HASTE_RATING, 0.17587148176043033 },
+        { ITEM_MOD_MANA_REGENERATION, 0.22523891523704237 },
+        { ITEM_MOD_SPELL_POWER, 0.3085464592288251 },
+    }),
+};
+
+// Pawn scale name of each table (what replaces it when AutoBis.Profiles.Path is set):
+static constexpr char const* abRoleScaleNames[MAX_AB_PROFILES] = {
+    "PaladinRetribution",
+    "PaladinProtection",
+    "WarriorFury",
+    "RogueCombat",
+    "MageFrost",
+    "HunterBeastMastery",
+    "DruidBalance",
+    "DruidFeralDps",
+    "ShamanEnhancement",
+    "PriestShadow",
+    "WarlockAffliction",
+    "WarlockDestruction",
+    "DeathKnightFrostDps",
+    "DeathKnightUnholyDps",
+    "DeathKnightBloodTank",
+    "WarriorProtection",
+    "DruidFeralTank",
+    "PaladinHoly",
+    "PriestDiscipline",
+    "PriestHoly",
+    "ShamanElemental",
+    "ShamanRestoration",
+    "DruidRestoration",
+};
+
+#endif
@@ -1,5 +1,11 @@
 USE world;
-INSERT INTO command (name, help) VALUES ("autobis", "Syntax: .autobis\nGive yourself the best possible gear at your current level.");
+INSERT INTO command (name, help) VALUES ("autobis", "Syntax: .autobis [upto|<min>-<max>|queue|stats|bench|analyze|export|reload|weights|loadtest|group|online]\nGive yourself the best possible gear at your current level.\n.autobis upto also looks at items from lower levels; .autobis <min>-<max> at items requiring a level in that range (up to yours).\n.autobis group/online does the same for your whole group, or for every online character.\n.autobis queue shows the request queue statistics.\n.autobis stats [reset] shows (or clears) how long each phase of a request takes.\n.autobis bench [iterations] [update] times the scoring engine and checks its results against a golden file (update rewrites it).\n.autobis analyze [file] [baseline] writes the best items per class, weight table, level and slot (and what changed since baseline), under AutoBis.Analyze.OutputDir.\n.autobis export [dir] writes what tools/autobis_analyze needs to run the same analysis without a server.\n.autobis reload [path] loads the weight tables from a Pawn Wowhead.lua without a restart.\n.autobis weights [show|set <Stat=value ...>|reset] shows, sets or clears your own weight table (Pawn stat names).\n.autobis loadtest [requests] [per_second] [min-max] fires requests cloned from online players and reports world tick durations; loadtest status/stop.");
 USE auth;
 INSERT INTO rbac_permissions (id, name) VALUES (1222, "Command: autobis");
 INSERT INTO rbac_linked_permissions (id, linkedId) VALUES (196, 1222);
+USE characters;
+CREATE TABLE IF NOT EXISTS autobis_weights (
+    guid INT UNSIGNED NOT NULL,
+    weights VARCHAR(1024) NOT NULL,
+    PRIMARY KEY (guid)
+);
@@ -0,0 +1,168 @@
+-- AutoBis' weight tables, in the format of Pawn's Wowhead.lua:
+--  https://github.com/Road-block/Pawn/blob/master/Wowhead.lua
+--
+-- tools/autobis_genweights.py turns this file into autobis_weights.h; rerun it after any change. The same file can
+--  also be loaded at runtime instead (AutoBis.Profiles.Path, ".autobis reload").
+--
+-- The first ten scales are AutoBis' original hand-written tables, which were taken from Wowhead.lua and then tuned;
+--  e.g. HitRating is 20 lower than Wowhead's, because we tend to get flooded with hit rating, overcapping the 8%
+--  limit. The rest fill in the classes and specs that had no table of their own. Stamina, and the weapon DPS and
+--  armor a spec doesn't care about, get a tiny weight so that they still break ties.
+
+local ScaleProviderName = "Wowhead"
+
+function PawnWowheadScaleProvider_AddScales()
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "PaladinRetribution", nil, { 0.96, 0.55, 0.73 },
+	{
+		["MeleeDps"] = 470, ["HitRating"] = 70, ["Strength"] = 80, ["ExpertiseRating"] = 66, ["CritRating"] = 40,
+		["Ap"] = 34, ["Agility"] = 32, ["HasteRating"] = 30, ["ArmorPenetration"] = 22, ["SpellPower"] = 9,
+		["Stamina"] = 0.1, ["Armor"] = 0.01, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "PaladinProtection", nil, { 0.96, 0.55, 0.73 },
+	{
+		["Stamina"] = 100, ["Agility"] = 60, ["ExpertiseRating"] = 59, ["DodgeRating"] = 55, ["DefenseRating"] = 45,
+		["ParryRating"] = 30, ["Strength"] = 16, ["Armor"] = 8, ["BlockRating"] = 7, ["BlockValue"] = 6,
+		["MeleeDps"] = 0.00001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "WarriorFury", nil, { 0.78, 0.61, 0.43 },
+	{
+		["ExpertiseRating"] = 100, ["Strength"] = 82, ["CritRating"] = 66, ["Agility"] = 53, ["ArmorPenetration"] = 52,
+		["HitRating"] = 48, ["HasteRating"] = 36, ["Ap"] = 31, ["Armor"] = 5, ["Stamina"] = 0.1, ["MeleeDps"] = 0.01,
+		["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "RogueCombat", nil, { 1.00, 0.96, 0.41 },
+	{
+		["MeleeDps"] = 220, ["ArmorPenetration"] = 100, ["Agility"] = 100, ["ExpertiseRating"] = 82, ["HitRating"] = 80,
+		["CritRating"] = 75, ["HasteRating"] = 73, ["Strength"] = 55, ["Ap"] = 50, ["Stamina"] = 0.1,
+		["Armor"] = 0.01, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "MageFrost", nil, { 0.41, 0.80, 0.94 },
+	{
+		["HitRating"] = 80, ["HasteRating"] = 42, ["SpellPower"] = 39, ["CritRating"] = 19, ["Intellect"] = 6,
+		["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "HunterBeastMastery", nil, { 0.67, 0.83, 0.45 },
+	{
+		["RangedDps"] = 213, ["HitRating"] = 80, ["Agility"] = 58, ["CritRating"] = 40, ["Intellect"] = 37, ["Ap"] = 30,
+		["ArmorPenetration"] = 28, ["HasteRating"] = 21, ["Stamina"] = 0.1, ["MeleeDps"] = 0.0001,
+		["Armor"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "DruidBalance", nil, { 1.00, 0.49, 0.04 },
+	{
+		["HitRating"] = 80, ["SpellPower"] = 66, ["HasteRating"] = 54, ["CritRating"] = 43, ["Spirit"] = 22,
+		["Intellect"] = 22, ["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "DruidFeralDps", nil, { 1.00, 0.49, 0.04 },
+	{
+		["Agility"] = 100, ["ArmorPenetration"] = 90, ["Strength"] = 80, ["CritRating"] = 55, ["ExpertiseRating"] = 50,
+		["HitRating"] = 50, ["Ap"] = 40, ["HasteRating"] = 35, ["Stamina"] = 0.1, ["MeleeDps"] = 0.01,
+		["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "ShamanEnhancement", nil, { 0.00, 0.44, 0.87 },
+	{
+		["MeleeDps"] = 135, ["HitRating"] = 70, ["ExpertiseRating"] = 84, ["Agility"] = 55, ["Intellect"] = 55,
+		["CritRating"] = 55, ["HasteRating"] = 42, ["Strength"] = 35, ["Ap"] = 32, ["SpellPower"] = 29,
+		["ArmorPenetration"] = 26, ["Stamina"] = 0.1, ["Armor"] = 0.01, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "PriestShadow", nil, { 1.00, 1.00, 1.00 },
+	{
+		["HitRating"] = 80, ["SpellPower"] = 76, ["CritRating"] = 54, ["HasteRating"] = 50, ["Spirit"] = 16,
+		["Intellect"] = 16, ["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+-- Classes and specs that used to fall back to another class' table:
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "WarlockAffliction", nil, { 0.58, 0.51, 0.79 },
+	{
+		["HitRating"] = 80, ["SpellPower"] = 72, ["HasteRating"] = 60, ["CritRating"] = 38, ["Spirit"] = 34,
+		["Intellect"] = 15, ["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "WarlockDestruction", nil, { 0.58, 0.51, 0.79 },
+	{
+		["HitRating"] = 80, ["SpellPower"] = 70, ["HasteRating"] = 56, ["CritRating"] = 48, ["Spirit"] = 26,
+		["Intellect"] = 14, ["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "DeathKnightFrostDps", nil, { 0.77, 0.12, 0.23 },
+	{
+		["MeleeDps"] = 300, ["Strength"] = 100, ["HitRating"] = 75, ["ExpertiseRating"] = 70, ["ArmorPenetration"] = 60,
+		["HasteRating"] = 50, ["CritRating"] = 45, ["Ap"] = 38, ["Agility"] = 20, ["Stamina"] = 0.1,
+		["Armor"] = 0.01, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "DeathKnightUnholyDps", nil, { 0.77, 0.12, 0.23 },
+	{
+		["MeleeDps"] = 209, ["Strength"] = 100, ["HitRating"] = 66, ["ExpertiseRating"] = 51, ["HasteRating"] = 48,
+		["CritRating"] = 45, ["Ap"] = 34, ["ArmorPenetration"] = 32, ["Agility"] = 16, ["Stamina"] = 0.1,
+		["Armor"] = 0.01, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "DeathKnightBloodTank", nil, { 0.77, 0.12, 0.23 },
+	{
+		["Stamina"] = 100, ["DefenseRating"] = 85, ["DodgeRating"] = 70, ["ParryRating"] = 65, ["ExpertiseRating"] = 60,
+		["MeleeDps"] = 50, ["Agility"] = 40, ["Strength"] = 38, ["HitRating"] = 30, ["Armor"] = 6,
+		["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "WarriorProtection", nil, { 0.78, 0.61, 0.43 },
+	{
+		["Stamina"] = 100, ["DefenseRating"] = 85, ["DodgeRating"] = 70, ["ParryRating"] = 65, ["ExpertiseRating"] = 55,
+		["BlockRating"] = 45, ["BlockValue"] = 40, ["Agility"] = 40, ["Strength"] = 35, ["HitRating"] = 30,
+		["MeleeDps"] = 20, ["Armor"] = 7, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "DruidFeralTank", nil, { 1.00, 0.49, 0.04 },
+	{
+		["Stamina"] = 100, ["Agility"] = 80, ["DodgeRating"] = 65, ["DefenseRating"] = 55, ["ExpertiseRating"] = 45,
+		["HitRating"] = 30, ["Strength"] = 30, ["Ap"] = 20, ["Armor"] = 18, ["MeleeDps"] = 0.01,
+		["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "PaladinHoly", nil, { 0.96, 0.55, 0.73 },
+	{
+		["Intellect"] = 100, ["Mp5"] = 88, ["SpellPower"] = 58, ["CritRating"] = 46, ["HasteRating"] = 35,
+		["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "PriestDiscipline", nil, { 1.00, 1.00, 1.00 },
+	{
+		["SpellPower"] = 100, ["Mp5"] = 67, ["Intellect"] = 65, ["HasteRating"] = 59, ["CritRating"] = 48,
+		["Spirit"] = 22, ["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "PriestHoly", nil, { 1.00, 1.00, 1.00 },
+	{
+		["SpellPower"] = 100, ["Spirit"] = 73, ["Mp5"] = 67, ["Intellect"] = 65, ["HasteRating"] = 59,
+		["CritRating"] = 38, ["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "ShamanElemental", nil, { 0.00, 0.44, 0.87 },
+	{
+		["HitRating"] = 80, ["SpellPower"] = 60, ["HasteRating"] = 56, ["CritRating"] = 40, ["Intellect"] = 11,
+		["Mp5"] = 8, ["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "ShamanRestoration", nil, { 0.00, 0.44, 0.87 },
+	{
+		["Mp5"] = 100, ["Intellect"] = 85, ["SpellPower"] = 77, ["CritRating"] = 62, ["HasteRating"] = 35,
+		["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+PawnAddPluginScaleFromTemplate(ScaleProviderName, "DruidRestoration", nil, { 1.00, 0.49, 0.04 },
+	{
+		["SpellPower"] = 100, ["Mp5"] = 73, ["HasteRating"] = 57, ["Intellect"] = 51, ["Spirit"] = 32,
+		["CritRating"] = 11, ["Stamina"] = 0.1, ["MeleeDps"] = 0.0001, ["Armor"] = 0.0001, ["RangedDps"] = 0.0001,
+	})
+
+end
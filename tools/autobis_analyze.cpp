@@ -0,0 +1,326 @@
+//
+// ".autobis analyze" without a server: reads what ".autobis export" wrote (or the same tables from "mysql --batch")
+//  and writes the same report, so weight tables can be tuned on any machine with a copy of the data.
+//
+//   autobis_analyze <export dir> <report> [baseline] [--threads N] [--profiles Wowhead.lua]
+//
+// With a baseline report, the slots whose item changed are also written to "<report>.diff". --profiles replaces the
+//  built-in weight tables the way AutoBis.Profiles.Path does (with the default AutoBis.Profiles.Role.* names).
+//
+// Items none of whose random enchants are worth anything show enchant 0 here; the server would roll one instead.
+//
+#include "autobis_pawn.h"
+#include "autobis_score.h"
+#include "autobis_weights.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+// A tab-separated file with a header line; fields are looked up by column name:
+class AbTsvFile {
+    public:
+        bool Open(std::string const& path)
+        {
+            _lines.clear();
+            if (!AbReadLines(path, _lines) || _lines.empty())
+                return false;
+            _columns.clear();
+            std::vector<std::string> header = Split(_lines[0]);
+            for (uint32 idx = 0; idx < header.size(); ++idx)
+                _columns[header[idx]] = idx;
+            _next = 1;
+            return true;
+        }
+        // return: false past the last row:
+        bool Next()
+        {
+            while (_next < _lines.size() && _lines[_next].empty())
+                ++_next;
+            if (_next >= _lines.size())
+                return false;
+            _fields = Split(_lines[_next++]);
+            return true;
+        }
+        std::string const& Get(std::string const& column) const
+        {
+            static const std::string empty;
+            auto fiter = _columns.find(column);
+            return (fiter != _columns.end() && fiter->second < _fields.size()) ? _fields[fiter->second] : empty;
+        }
+        int64 GetInt(std::string const& column) const { return strtoll(Get(column).c_str(), nullptr, 10); }
+        float GetFloat(std::string const& column) const { return strtof(Get(column).c_str(), nullptr); }
+        bool Has(std::string const& column) const { return _columns.count(column) != 0; }
+    private:
+        static std::vector<std::string> Split(std::string const& line)
+        {
+            std::vector<std::string> fields;
+            std::string::size_type start = 0;
+            for (std::string::size_type tab; (tab = line.find('\t', start)) != std::string::npos; start = tab + 1)
+                fields.push_back(line.substr(start, tab - start));
+            fields.push_back(line.substr(start));
+            return fields;
+        }
+
+        std::vector<std::string> _lines;
+        std::map<std::string, uint32> _columns;
+        std::vector<std::string> _fields;
+        uint32 _next = 0;
+};
+
+// "stat:value,stat:value,...":
+static void ParseStats(std::string const& text, std::vector<AbScoreData::Stat> &stats)
+{
+    std::istringstream in(text);
+    std::string pair;
+    while (std::getline(in, pair, ',')) {
+        std::string::size_type colon = pair.find(':');
+        if (colon != std::string::npos)
+            stats.push_back(AbScoreData::Stat{ atoi(pair.c_str()), atoi(pair.c_str() + colon + 1) });
+    }
+}
+
+// AbScoreData on top of an ".autobis export":
+class AbExportScoreData : public AbScoreData {
+    public:
+        // return: false, with "error" set, if a file is missing:
+        bool Load(std::string const& dir, std::string &error);
+
+        void GetEquipSpellStats(uint32 spellId, Stat const*& first, Stat const*& last) const override
+        {
+            first = last = _stats.data();
+            auto fiter = _spells.find(spellId);
+            if (fiter == _spells.end())
+                return;
+            first = _stats.data() + fiter->second.first;
+            last = _stats.data() + fiter->second.second;
+        }
+        std::vector<uint32> const* GetEnchantPool(uint32 ench_idx) const override
+        {
+            auto fiter = _pools.find(ench_idx);
+            return fiter != _pools.end() ? &fiter->second : nullptr;
+        }
+        bool GetRandomEnchant(uint32 ench, bool rand_suffix, RandomEnchant &enchant) const override
+        {
+            auto fiter = _enchants.find((uint64(rand_suffix) << 32) | ench);
+            if (fiter == _enchants.end())
+                return false;
+            enchant = fiter->second;
+            return true;
+        }
+        uint32 GetSuffixFactor(ItemTemplate const* itemTemplate) const override
+        {
+            auto fiter = _factors.find(itemTemplate->ItemId);
+            return fiter != _factors.end() ? fiter->second : 0;
+        }
+
+        std::deque<ItemTemplate> _templates;
+    private:
+        std::vector<Stat> _stats;
+        std::unordered_map<uint32, std::pair<uint32, uint32>> _spells;
+        std::unordered_map<uint32, std::vector<uint32>> _pools;
+        std::unordered_map<uint64, RandomEnchant> _enchants;
+        std::unordered_map<uint32, uint32> _factors;
+};
+
+bool AbExportScoreData::Load(std::string const& dir, std::string &error)
+{
+    AbTsvFile file;
+    std::string path = dir + "/item_template.tsv";
+    if (!file.Open(path)) {
+        error = "can't read " + path;
+        return false;
+    }
+    while (file.Next()) {
+        _templates.emplace_back();
+        ItemTemplate &t = _templates.back();
+        t.ItemId = file.GetInt("entry");
+        t.Name1 = file.Get("name");
+        t.Class = file.GetInt("class");
+        t.SubClass = file.GetInt("subclass");
+        t.Quality = file.GetInt("Quality");
+        t.Flags2 = file.GetInt("FlagsExtra");
+        t.InventoryType = file.GetInt("InventoryType");
+        t.AllowableClass = file.GetInt("AllowableClass");
+        t.ItemLevel = file.GetInt("ItemLevel");
+        t.RequiredLevel = file.GetInt("RequiredLevel");
+        t.RequiredReputationFaction = file.GetInt("RequiredReputationFaction");
+        t.SellPrice = file.GetInt("SellPrice");
+        t.Armor = file.GetInt("armor");
+        t.Block = file.GetInt("block");
+        t.Delay = file.GetInt("delay");
+        t.Damage[0].DamageMin = file.GetFloat("dmg_min1");
+        t.Damage[0].DamageMax = file.GetFloat("dmg_max1");
+        t.StatsCount = file.GetInt("StatsCount");
+        for (uint32 idx = 0; idx < MAX_ITEM_PROTO_STATS; ++idx) {
+            t.ItemStat[idx].ItemStatType = file.GetInt("stat_type" + std::to_string(idx + 1));
+            t.ItemStat[idx].ItemStatValue = file.GetInt("stat_value" + std::to_string(idx + 1));
+        }
+        for (uint32 idx = 0; idx < MAX_ITEM_PROTO_SPELLS; ++idx) {
+            t.Spells[idx].SpellId = file.GetInt("spellid_" + std::to_string(idx + 1));
+            t.Spells[idx].SpellTrigger = file.GetInt("spelltrigger_" + std::to_string(idx + 1));
+        }
+        t.RandomProperty = file.GetInt("RandomProperty");
+        t.RandomSuffix = file.GetInt("RandomSuffix");
+    }
+    path = dir + "/item_enchantment_template.tsv";
+    if (!file.Open(path)) {
+        error = "can't read " + path;
+        return false;
+    }
+    while (file.Next()) {
+        float chance = file.GetFloat("chance");
+        if (chance > 0.000001f && chance <= 100.0f)
+            _pools[file.GetInt("entry")].push_back(file.GetInt("ench"));
+    }
+    path = dir + "/autobis_random_enchants.tsv";
+    if (!file.Open(path)) {
+        error = "can't read " + path;
+        return false;
+    }
+    while (file.Next()) {
+        std::vector<Stat> stats;
+        ParseStats(file.Get("stats"), stats);
+        RandomEnchant &enchant = _enchants[(uint64(file.GetInt("suffix") != 0) << 32) | uint32(file.GetInt("ench"))];
+        for (uint32 idx = 0; idx < stats.size() && idx < MAX_RANDOM_ENCHANT_STATS; ++idx)
+            enchant.stats[enchant.count++] = stats[idx];
+    }
+    path = dir + "/autobis_equip_spells.tsv";
+    if (!file.Open(path)) {
+        error = "can't read " + path;
+        return false;
+    }
+    while (file.Next()) {
+        uint32 first = _stats.size();
+        ParseStats(file.Get("stats"), _stats);
+        _spells[file.GetInt("spell")] = std::make_pair(first, uint32(_stats.size()));
+    }
+    path = dir + "/autobis_suffix_factors.tsv";
+    if (!file.Open(path)) {
+        error = "can't read " + path;
+        return false;
+    }
+    while (file.Next())
+        _factors[file.GetInt("entry")] = file.GetInt("factor");
+    return true;
+}
+
+// The built-in tables, with the ones a Wowhead.lua has a scale for replaced (see BuildProfileSet() in the server):
+static bool LoadRoles(std::string const& path, std::deque<AbWeightProfile> &profiles, std::deque<std::string> &names,
+                      AbWeightProfile const* roles[MAX_AB_PROFILES])
+{
+    for (uint32 role = 0; role < MAX_AB_PROFILES; ++role)
+        roles[role] = &abWeightProfiles[role];
+    if (path.empty())
+        return true;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "autobis_analyze: can't open %s\n", path.c_str());
+        return false;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    std::vector<AbPawnScale> scales;
+    std::vector<std::string> errors, ignored;
+    if (!AbParsePawnScales(text.str(), scales, errors, ignored)) {
+        for (std::string const& error : errors)
+            fprintf(stderr, "autobis_analyze: %s: %s\n", path.c_str(), error.c_str());
+        return false;
+    }
+    uint32 nextId = MAX_AB_PROFILES;
+    for (AbPawnScale const& scale : scales) {
+        names.push_back(scale.name);
+        profiles.push_back(AbCompileWeightProfile(scale.weights, nextId++, names.back().c_str()));
+    }
+    for (uint32 role = 0; role < MAX_AB_PROFILES; ++role) {
+        for (AbWeightProfile const& profile : profiles) {
+            if (abRoleScaleNames[role] == std::string(profile.name)) {
+                roles[role] = &profile;
+                printf("autobis_analyze: %s uses \"%s\".\n", abWeightProfiles[role].name, profile.name);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> positional;
+    uint32 threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::string profilesPath;
+    for (int idx = 1; idx < argc; ++idx) {
+        std::string arg = argv[idx];
+        if (arg == "--threads" && idx + 1 < argc)
+            threads = std::max(atoi(argv[++idx]), 1);
+        else if (arg == "--profiles" && idx + 1 < argc)
+            profilesPath = argv[++idx];
+        else
+            positional.push_back(arg);
+    }
+    if (positional.size() < 2 || positional.size() > 3) {
+        fprintf(stderr, "usage: autobis_analyze <export dir> <report> [baseline] [--threads N] "
+                        "[--profiles Wowhead.lua]\n");
+        return 2;
+    }
+    std::string const& report = positional[1];
+    AbExportScoreData data;
+    std::string error;
+    if (!data.Load(positional[0], error)) {
+        fprintf(stderr, "autobis_analyze: %s\n", error.c_str());
+        return 1;
+    }
+    std::deque<AbWeightProfile> profiles;
+    std::deque<std::string> names;
+    AbWeightProfile const* roles[MAX_AB_PROFILES];
+    if (!LoadRoles(profilesPath, profiles, names, roles))
+        return 1;
+
+    auto started = std::chrono::steady_clock::now();
+    AbItemList templates;
+    for (ItemTemplate const& itemTemplate : data._templates)
+        templates.push_back(&itemTemplate);
+    AbItemCatalog catalog;
+    catalog.Load(templates);
+    AbItemFeatures features;
+    features.Load(data, catalog._items);
+    AbWeightProfile roleProfiles[MAX_AB_PROFILES];
+    for (uint32 role = 0; role < MAX_AB_PROFILES; ++role)
+        roleProfiles[role] = *roles[role];
+    AbBestEnchants enchants;
+    enchants.Precompute(data, catalog._items, roleProfiles, MAX_AB_PROFILES);
+    AbScoringContext context;
+    context.data = &data;
+    context.catalog = &catalog;
+    context.features = &features;
+    context.enchants = &enchants;
+    std::vector<std::string> lines;
+    AbAnalyze(context, roles, threads, lines);
+    if (!AbWriteLines(report, lines)) {
+        fprintf(stderr, "autobis_analyze: couldn't write %s\n", report.c_str());
+        return 1;
+    }
+    uint64 ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started)
+                .count();
+    printf("autobis_analyze: %u candidate items; wrote %u lines to %s in %u ms on %u threads.\n",
+           uint32(catalog._items.size()), uint32(lines.size()), report.c_str(), uint32(ms), threads);
+    if (positional.size() == 3) {
+        std::vector<std::string> before, diff;
+        if (!AbReadLines(positional[2], before)) {
+            fprintf(stderr, "autobis_analyze: can't read %s\n", positional[2].c_str());
+            return 1;
+        }
+        uint32 changed = AbDiffAnalysis(lines, before, diff);
+        if (!AbWriteLines(report + ".diff", diff)) {
+            fprintf(stderr, "autobis_analyze: couldn't write %s.diff\n", report.c_str());
+            return 1;
+        }
+        printf("autobis_analyze: %u slots changed against %s (see %s.diff).\n", changed, positional[2].c_str(),
+               report.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,491 @@
+//
+// ".autobis bench" without a server or a database: times the scoring core against a synthetic, seeded catalog of
+//  about 40k items, and checks its results against tools/autobis_bench.golden so that a speed-up can't silently change
+//  what gets handed out. Each phase also reports how many heap allocations it makes per operation (operator new is
+//  replaced with a counting one below).
+//
+//   autobis_bench [iterations] [--golden FILE] [--update-golden]
+//
+// The catalog (items, equip spells, random enchantment pools and suffix factors) only depends on the seed below, so
+//  every machine gets the same one. A missing or unreadable golden file is an error; after a change that is meant to
+//  change the results, rerun with --update-golden and commit the new file along with it.
+//
+#include "autobis_score.h"
+#include "autobis_weights.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <sstream>
+
+#ifndef AUTOBIS_BENCH_GOLDEN
+#define AUTOBIS_BENCH_GOLDEN "autobis_bench.golden"
+#endif
+
+static const uint64 AB_BENCH_SEED = 0x6175746f626973ULL; // "autobis"
+static const uint32 AB_BENCH_ITEMS = 40000;
+static const uint32 AB_BENCH_EQUIP_SPELLS = 400;
+static const uint32 AB_BENCH_PROPERTY_POOLS = 120;
+static const uint32 AB_BENCH_SUFFIX_POOLS = 60;
+static const uint32 AB_BENCH_PROPERTIES = 1200;
+static const uint32 AB_BENCH_SUFFIXES = 400;
+
+// Every heap allocation the program makes goes through here, so each phase can report how many it made:
+static std::atomic<uint64> abBenchAllocations{0};
+
+void* operator new(std::size_t size)
+{
+    abBenchAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// Allocations since construction:
+struct AbAllocationCount {
+    uint64 start = abBenchAllocations.load(std::memory_order_relaxed);
+    uint64 Allocations() const { return abBenchAllocations.load(std::memory_order_relaxed) - start; }
+};
+
+// splitmix64; unlike the <random> distributions, it gives the same numbers with every standard library:
+struct AbBenchRandom {
+    uint64 state;
+
+    explicit AbBenchRandom(uint64 seed) : state(seed) { }
+    uint64 Next()
+    {
+        uint64 z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    // [min, max]:
+    uint32 Range(uint32 min, uint32 max) { return min + uint32(Next() % (uint64(max) - min + 1)); }
+    bool Chance(uint32 percent) { return Range(1, 100) <= percent; }
+};
+
+// Stats items commonly carry, by how they're usually grouped:
+static const uint32 abBenchStats[] = {
+    ITEM_MOD_AGILITY, ITEM_MOD_STRENGTH, ITEM_MOD_INTELLECT, ITEM_MOD_SPIRIT, ITEM_MOD_STAMINA,
+    ITEM_MOD_DEFENSE_SKILL_RATING, ITEM_MOD_DODGE_RATING, ITEM_MOD_PARRY_RATING, ITEM_MOD_BLOCK_RATING,
+    ITEM_MOD_HIT_RATING, ITEM_MOD_CRIT_RATING, ITEM_MOD_HASTE_RATING, ITEM_MOD_EXPERTISE_RATING,
+    ITEM_MOD_ATTACK_POWER, ITEM_MOD_SPELL_POWER, ITEM_MOD_MANA_REGENERATION, ITEM_MOD_ARMOR_PENETRATION_RATING,
+    ITEM_MOD_RESILIENCE_RATING, ITEM_MOD_SPELL_PENETRATION, ITEM_MOD_BLOCK_VALUE
+};
+static const uint32 AB_BENCH_STAT_TYPES = sizeof(abBenchStats) / sizeof(abBenchStats[0]);
+
+struct AbBenchShape {
+    uint32 inv_type;
+    uint32 subclass;    // ~0u: any of cloth, leather, mail and plate
+};
+
+static const AbBenchShape abBenchArmor[] = {
+    { INVTYPE_HEAD, ~0u }, { INVTYPE_SHOULDERS, ~0u }, { INVTYPE_CHEST, ~0u },
+    { INVTYPE_ROBE, ITEM_SUBCLASS_ARMOR_CLOTH }, { INVTYPE_WAIST, ~0u }, { INVTYPE_LEGS, ~0u }, { INVTYPE_FEET, ~0u },
+    { INVTYPE_WRISTS, ~0u },
+    { INVTYPE_HANDS, ~0u }, { INVTYPE_NECK, ITEM_SUBCLASS_ARMOR_MISC }, { INVTYPE_FINGER, ITEM_SUBCLASS_ARMOR_MISC },
+    { INVTYPE_TRINKET, ITEM_SUBCLASS_ARMOR_MISC }, { INVTYPE_CLOAK, ITEM_SUBCLASS_ARMOR_CLOTH },
+    { INVTYPE_SHIELD, ITEM_SUBCLASS_ARMOR_SHIELD }, { INVTYPE_HOLDABLE, ITEM_SUBCLASS_ARMOR_MISC },
+    { INVTYPE_RELIC, ITEM_SUBCLASS_ARMOR_LIBRAM }, { INVTYPE_RELIC, ITEM_SUBCLASS_ARMOR_IDOL },
+    { INVTYPE_RELIC, ITEM_SUBCLASS_ARMOR_TOTEM }, { INVTYPE_RELIC, ITEM_SUBCLASS_ARMOR_SIGIL }
+};
+
+static const AbBenchShape abBenchWeapons[] = {
+    { INVTYPE_WEAPON, ITEM_SUBCLASS_WEAPON_AXE }, { INVTYPE_WEAPONMAINHAND, ITEM_SUBCLASS_WEAPON_MACE },
+    { INVTYPE_WEAPON, ITEM_SUBCLASS_WEAPON_SWORD }, { INVTYPE_WEAPONOFFHAND, ITEM_SUBCLASS_WEAPON_FIST_WEAPON },
+    { INVTYPE_WEAPON, ITEM_SUBCLASS_WEAPON_DAGGER }, { INVTYPE_WEAPONMAINHAND, ITEM_SUBCLASS_WEAPON_DAGGER },
+    { INVTYPE_2HWEAPON, ITEM_SUBCLASS_WEAPON_AXE2 }, { INVTYPE_2HWEAPON, ITEM_SUBCLASS_WEAPON_MACE2 },
+    { INVTYPE_2HWEAPON, ITEM_SUBCLASS_WEAPON_SWORD2 }, { INVTYPE_2HWEAPON, ITEM_SUBCLASS_WEAPON_POLEARM },
+    { INVTYPE_2HWEAPON, ITEM_SUBCLASS_WEAPON_STAFF }, { INVTYPE_RANGED, ITEM_SUBCLASS_WEAPON_BOW },
+    { INVTYPE_RANGEDRIGHT, ITEM_SUBCLASS_WEAPON_GUN }, { INVTYPE_RANGEDRIGHT, ITEM_SUBCLASS_WEAPON_CROSSBOW },
+    { INVTYPE_RANGEDRIGHT, ITEM_SUBCLASS_WEAPON_WAND }, { INVTYPE_THROWN, ITEM_SUBCLASS_WEAPON_THROWN }
+};
+
+// AbScoreData for the synthetic catalog; everything is generated up front, so lookups cost what they do on a server:
+class AbBenchScoreData : public AbScoreData {
+    public:
+        void Generate(uint64 seed);
+
+        void GetEquipSpellStats(uint32 spellId, Stat const*& first, Stat const*& last) const override
+        {
+            first = last = _stats.data();
+            auto fiter = _spells.find(spellId);
+            if (fiter == _spells.end())
+                return;
+            first = _stats.data() + fiter->second.first;
+            last = _stats.data() + fiter->second.second;
+        }
+        std::vector<uint32> const* GetEnchantPool(uint32 ench_idx) const override
+        {
+            auto fiter = _pools.find(ench_idx);
+            return fiter != _pools.end() ? &fiter->second : nullptr;
+        }
+        bool GetRandomEnchant(uint32 ench, bool rand_suffix, RandomEnchant &enchant) const override
+        {
+            auto fiter = _enchants.find((uint64(rand_suffix) << 32) | ench);
+            if (fiter == _enchants.end())
+                return false;
+            enchant = fiter->second;
+            return true;
+        }
+        // Scales with the item level, the way the core's tables roughly do:
+        uint32 GetSuffixFactor(ItemTemplate const* itemTemplate) const override
+        {
+            return itemTemplate->RandomSuffix ? 4 + itemTemplate->ItemLevel * (itemTemplate->Quality + 1) / 4 : 0;
+        }
+
+        std::deque<ItemTemplate> _templates;
+    private:
+        void GenerateItem(AbBenchRandom &random, uint32 itemId, ItemTemplate &t);
+
+        std::vector<Stat> _stats;
+        std::unordered_map<uint32, std::pair<uint32, uint32>> _spells;
+        std::unordered_map<uint32, std::vector<uint32>> _pools;
+        std::unordered_map<uint64, RandomEnchant> _enchants;
+};
+
+void AbBenchScoreData::Generate(uint64 seed)
+{
+    AbBenchRandom random(seed);
+    // "Equip: Increase X by Y", one or two stats each; spell ids start at 1:
+    for (uint32 spell = 1; spell <= AB_BENCH_EQUIP_SPELLS; ++spell) {
+        uint32 first = _stats.size();
+        uint32 count = random.Range(1, 2);
+        for (uint32 idx = 0; idx < count; ++idx) {
+            int32 statId = abBenchStats[random.Range(0, AB_BENCH_STAT_TYPES - 1)];
+            if (idx && _stats[first].stat_id == statId)
+                continue;
+            _stats.push_back(Stat{ statId, int32(random.Range(5, 120)) });
+        }
+        _spells[spell] = std::make_pair(first, uint32(_stats.size()));
+    }
+    // Random properties give flat stats, random suffixes an AllocationPct scaled by the suffix factor:
+    for (uint32 rand_suffix = 0; rand_suffix < 2; ++rand_suffix) {
+        uint32 enchants = rand_suffix ? AB_BENCH_SUFFIXES : AB_BENCH_PROPERTIES;
+        for (uint32 ench = 1; ench <= enchants; ++ench) {
+            RandomEnchant &enchant = _enchants[(uint64(rand_suffix) << 32) | ench];
+            uint32 count = random.Range(1, 3);
+            for (uint32 idx = 0; idx < count; ++idx) {
+                int32 statId = abBenchStats[random.Range(0, AB_BENCH_STAT_TYPES - 1)];
+                int32 value = rand_suffix ? random.Range(1000, 10000) : random.Range(1, 60);
+                enchant.stats[enchant.count++] = Stat{ statId, value };
+            }
+        }
+    }
+    // item_enchantment_template: RandomProperty pools 1.., RandomSuffix pools 1001..:
+    for (uint32 pool = 1; pool <= AB_BENCH_PROPERTY_POOLS; ++pool) {
+        for (uint32 count = random.Range(4, 30); count; --count)
+            _pools[pool].push_back(random.Range(1, AB_BENCH_PROPERTIES));
+    }
+    for (uint32 pool = 1; pool <= AB_BENCH_SUFFIX_POOLS; ++pool) {
+        for (uint32 count = random.Range(4, 15); count; --count)
+            _pools[1000 + pool].push_back(random.Range(1, AB_BENCH_SUFFIXES));
+    }
+    for (uint32 idx = 0; idx < AB_BENCH_ITEMS; ++idx) {
+        _templates.emplace_back();
+        GenerateItem(random, 100000 + idx, _templates.back());
+    }
+}
+
+void AbBenchScoreData::GenerateItem(AbBenchRandom &random, uint32 itemId, ItemTemplate &t)
+{
+    t.ItemId = itemId;
+    t.Name1 = "Bench Item " + std::to_string(itemId);
+    t.RequiredLevel = random.Range(1, DEFAULT_MAX_LEVEL);
+    t.ItemLevel = t.RequiredLevel + random.Range(0, 10);
+    t.Quality = random.Range(ITEM_QUALITY_POOR, ITEM_QUALITY_EPIC);
+    // Roughly one item in twenty fails IsCandidate() some other way:
+    t.SellPrice = random.Chance(97) ? t.ItemLevel * 25 : 0;
+    t.RequiredReputationFaction = random.Chance(2) ? 1073 : 0;
+    t.AllowableClass = random.Chance(5) ? int32(1u << random.Range(0, MAX_CLASSES - 2)) : -1;
+    uint32 budget = 2 + t.ItemLevel * (t.Quality + 1) / 3;
+    if (random.Chance(30)) {
+        uint32 shapes = sizeof(abBenchWeapons) / sizeof(abBenchWeapons[0]);
+        AbBenchShape const& shape = abBenchWeapons[random.Range(0, shapes - 1)];
+        t.Class = ITEM_CLASS_WEAPON;
+        t.SubClass = shape.subclass;
+        t.InventoryType = shape.inv_type;
+        bool two_handed = (shape.inv_type == INVTYPE_2HWEAPON);
+        t.Delay = two_handed ? random.Range(30, 38) * 100 : random.Range(14, 28) * 100;
+        float dps = (two_handed ? 1.3f : 1.0f) * (2.0f + t.ItemLevel * (0.4f + 0.1f * t.Quality));
+        float average = dps * t.Delay / 1000.0f;
+        t.Damage[0].DamageMin = float(uint32(average * 0.75f));
+        t.Damage[0].DamageMax = float(uint32(average * 1.25f) + 1);
+        if (two_handed)
+            budget = budget * 3 / 2;
+    } else {
+        uint32 shapes = sizeof(abBenchArmor) / sizeof(abBenchArmor[0]);
+        AbBenchShape const& shape = abBenchArmor[random.Range(0, shapes - 1)];
+        t.Class = ITEM_CLASS_ARMOR;
+        t.SubClass = shape.subclass != ~0u ? shape.subclass : random.Range(ITEM_SUBCLASS_ARMOR_CLOTH,
+                                                                           ITEM_SUBCLASS_ARMOR_PLATE);
+        t.InventoryType = shape.inv_type;
+        if (t.SubClass >= ITEM_SUBCLASS_ARMOR_CLOTH && t.SubClass <= ITEM_SUBCLASS_ARMOR_SHIELD
+            && shape.inv_type != INVTYPE_HOLDABLE)
+            t.Armor = t.ItemLevel * (t.SubClass == ITEM_SUBCLASS_ARMOR_SHIELD ? 12 : 2 * t.SubClass);
+        if (t.SubClass == ITEM_SUBCLASS_ARMOR_SHIELD)
+            t.Block = t.ItemLevel / 2;
+    }
+    // Items "of the <suffix>" only have what their random enchant gives them:
+    if (t.Quality >= ITEM_QUALITY_UNCOMMON && random.Chance(25)) {
+        if (random.Chance(60))
+            t.RandomProperty = random.Range(1, AB_BENCH_PROPERTY_POOLS);
+        else
+            t.RandomSuffix = 1000 + random.Range(1, AB_BENCH_SUFFIX_POOLS);
+        budget /= 3;
+    }
+    t.StatsCount = t.Quality ? random.Range(1, 5) : 0;
+    for (uint32 idx = 0; idx < t.StatsCount; ++idx) {
+        t.ItemStat[idx].ItemStatType = abBenchStats[random.Range(0, AB_BENCH_STAT_TYPES - 1)];
+        t.ItemStat[idx].ItemStatValue = random.Range(1, budget / t.StatsCount + 1);
+    }
+    if (t.Quality >= ITEM_QUALITY_UNCOMMON && random.Chance(20)) {
+        t.Spells[0].SpellId = random.Range(1, AB_BENCH_EQUIP_SPELLS);
+        t.Spells[0].SpellTrigger = ITEM_SPELLTRIGGER_ON_EQUIP;
+    }
+}
+
+// FNV-1a, over what the golden file summarizes:
+static void HashBytes(uint64 &hash, char const* data, size_t size)
+{
+    for (size_t idx = 0; idx < size; ++idx) {
+        hash ^= uint8(data[idx]);
+        hash *= 1099511628211ULL;
+    }
+}
+
+static void Report(char const* name, uint64 ops, std::chrono::steady_clock::duration elapsed, uint64 allocations)
+{
+    uint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    printf("autobis_bench: %s: %llu ops, %llu ns/op, %.2f allocations/op\n", name, (unsigned long long)ops,
+           (unsigned long long)(ops ? ns / ops : 0), ops ? double(allocations) / ops : 0.0);
+}
+
+static void Report(char const* name, uint64 ops, std::chrono::steady_clock::time_point started, uint64 allocations)
+{
+    Report(name, ops, std::chrono::steady_clock::now() - started, allocations);
+}
+
+int main(int argc, char** argv)
+{
+    uint32 iterations = 1;
+    std::string goldenPath = AUTOBIS_BENCH_GOLDEN;
+    bool updateGolden = false;
+    for (int idx = 1; idx < argc; ++idx) {
+        std::string arg = argv[idx];
+        if (arg == "--golden" && idx + 1 < argc)
+            goldenPath = argv[++idx];
+        else if (arg == "--update-golden")
+            updateGolden = true;
+        else if (atoi(arg.c_str()) > 0)
+            iterations = std::min(atoi(arg.c_str()), 100);
+        else {
+            fprintf(stderr, "usage: autobis_bench [iterations] [--golden FILE] [--update-golden]\n");
+            return 2;
+        }
+    }
+
+    AbBenchScoreData data;
+    data.Generate(AB_BENCH_SEED);
+    AbItemList templates;
+    for (ItemTemplate const& itemTemplate : data._templates)
+        templates.push_back(&itemTemplate);
+    AbItemCatalog catalog;
+    catalog.Load(templates);
+    AbItemFeatures features;
+    features.Load(data, catalog._items);
+    AbBestEnchants enchants;
+    enchants.Precompute(data, catalog._items, abWeightProfiles, MAX_AB_PROFILES);
+    AbScoringContext context;
+    context.data = &data;
+    context.catalog = &catalog;
+    context.features = &features;
+    context.enchants = &enchants;
+    AbItemList const& items = catalog._items;
+    printf("autobis_bench: %u synthetic items, %u candidates, %u iterations.\n", uint32(templates.size()),
+           uint32(items.size()), iterations);
+
+    std::vector<std::string> golden;
+    char line[64];
+    // AbBaseScore() plus the best random enchant, the way the server's ComputePawnScore() does; the golden file gets
+    //  one hash of every item's score per weight table:
+    auto started = std::chrono::steady_clock::now();
+    AbAllocationCount counted;
+    for (uint32 iteration = 0; iteration < iterations; ++iteration) {
+        for (AbWeightProfile const& profile : abWeightProfiles) {
+            uint64 hash = 14695981039346656037ULL;
+            for (ItemTemplate const* itemTemplate : items) {
+                int32 enchId;
+                double score = AbBaseScore(data, profile, itemTemplate)
+                             + AbBestRandomEnchant(context, profile, itemTemplate, enchId);
+                if (iteration == 0) {
+                    snprintf(line, sizeof(line), "%u %.4f %d", itemTemplate->ItemId, score, enchId);
+                    HashBytes(hash, line, strlen(line));
+                }
+            }
+            if (iteration == 0) {
+                snprintf(line, sizeof(line), "score %s %016llx", profile.name, (unsigned long long)hash);
+                golden.push_back(line);
+            }
+        }
+    }
+    Report("AbBaseScore+AbBestRandomEnchant", uint64(iterations) * MAX_AB_PROFILES * items.size(), started,
+           counted.Allocations());
+    // The batch kernel, over the whole catalog:
+    std::vector<double> scores(items.size());
+    started = std::chrono::steady_clock::now();
+    counted = AbAllocationCount();
+    for (uint32 iteration = 0; iteration < iterations; ++iteration) {
+        for (AbWeightProfile const& profile : abWeightProfiles)
+            features.Score(profile, 0, items.size(), scores.data());
+    }
+    Report("AbItemFeatures::Score", uint64(iterations) * MAX_AB_PROFILES * items.size(), started,
+           counted.Allocations());
+    // AbFindBestEnchant(), i.e. without the precomputed table, for the items that have a random enchant:
+    AbScoringContext uncached = context;
+    uncached.enchants = nullptr;
+    uint64 ops = 0;
+    started = std::chrono::steady_clock::now();
+    counted = AbAllocationCount();
+    for (uint32 iteration = 0; iteration < iterations; ++iteration) {
+        for (AbWeightProfile const& profile : abWeightProfiles) {
+            for (uint32 row = 0; row < items.size(); ++row) {
+                if (!features._hasRandomEnchant[row])
+                    continue;
+                int32 enchId;
+                AbBestRandomEnchant(uncached, profile, items[row], enchId);
+                ++ops;
+            }
+        }
+    }
+    Report("AbFindBestEnchant", ops, started, counted.Allocations());
+    // AbClassCanUseItem(), for every class; the golden file gets how many items each class can use at 80:
+    std::ostringstream usable;
+    usable << "usable";
+    started = std::chrono::steady_clock::now();
+    counted = AbAllocationCount();
+    for (uint32 iteration = 0; iteration < iterations; ++iteration) {
+        for (uint8 classId = CLASS_WARRIOR; classId < MAX_CLASSES; ++classId) {
+            uint32 count = 0;
+            for (ItemTemplate const* itemTemplate : items)
+                count += AbClassCanUseItem(classId, DEFAULT_MAX_LEVEL, itemTemplate);
+            if (iteration == 0)
+                usable << " " << uint32(classId) << ":" << count;
+        }
+    }
+    Report("AbClassCanUseItem", uint64(iterations) * (MAX_CLASSES - 1) * items.size(), started, counted.Allocations());
+    golden.push_back(usable.str());
+    // Full selection, per weight table and level, exactly like the server's bench: synthetic players own a fixed,
+    //  pseudo-random handful of catalog items at their level, and can use every candidate. The golden file gets every
+    //  grant:
+    auto make_snapshot = [&](AbWeightProfile const& profile, uint8 level, AbSelectionInput &snapshot) {
+        snapshot = AbSelectionInput();
+        snapshot.level = level;
+        snapshot.min_level = level;
+        snapshot.max_level = level;
+        snapshot.profile = &profile;
+        for (AbItemCatalog::Range const& range : catalog.GetLevel(level)) {
+            for (uint32 row = range.first; row < range.last; ++row)
+                snapshot.candidate_rows.push_back(row);
+        }
+        std::sort(snapshot.candidate_rows.begin(), snapshot.candidate_rows.end());
+        uint32 seed = profile.id * 7919 + level;
+        for (uint32 idx = 0; idx < 20 && !snapshot.candidate_rows.empty(); ++idx) {
+            seed = seed * 1103515245 + 12345;
+            uint32 row = snapshot.candidate_rows[(seed >> 8) % snapshot.candidate_rows.size()];
+            ItemTemplate const* itemTemplate = items[row];
+            uint32 inv_type = itemTemplate->InventoryType;
+            AbAdjustStaticInvType(inv_type);
+            int32 enchId;
+            double score = AbBaseScore(data, profile, itemTemplate)
+                         + AbBestRandomEnchant(context, profile, itemTemplate, enchId);
+            snapshot.have_items[inv_type].Push(itemTemplate, score);
+            snapshot.owned_rows.push_back(row);
+        }
+        std::sort(snapshot.owned_rows.begin(), snapshot.owned_rows.end());
+    };
+    // Like a request: rank to AB_RANK_DEPTH, select, and rank everything only if that wasn't deep enough. A request's
+    //  ranking goes into buffers a finished one left behind (see AbRankingFlights), so this reuses one too; the
+    //  ranking and the selection are also counted on their own:
+    ops = 0;
+    uint32 fallbacks = 0;
+    std::chrono::steady_clock::duration rankTime{}, selectTime{};
+    uint64 rankAllocations = 0, selectAllocations = 0;
+    AbSelectionInput snapshot;
+    AbRankedSlots ranked;
+    for (AbWeightProfile const& profile : abWeightProfiles) {
+        for (uint8 level = 10; level <= DEFAULT_MAX_LEVEL; level += 10) {
+            make_snapshot(profile, level, snapshot);
+            std::vector<AbGrant> kept;
+            for (uint32 iteration = 0; iteration < iterations; ++iteration) {
+                std::vector<AbGrant> grants;
+                for (uint32 depth : { AB_RANK_DEPTH, 0u }) {
+                    AbAllocationCount ranking;
+                    auto ranking_started = std::chrono::steady_clock::now();
+                    AbRankCandidates(context, profile, snapshot.min_level, snapshot.max_level, ranked, depth);
+                    rankTime += std::chrono::steady_clock::now() - ranking_started;
+                    rankAllocations += ranking.Allocations();
+                    AbAllocationCount selecting;
+                    auto selecting_started = std::chrono::steady_clock::now();
+                    grants.clear();
+                    bool selected = AbSelectFromRanked(ranked, snapshot, grants);
+                    selectTime += std::chrono::steady_clock::now() - selecting_started;
+                    selectAllocations += selecting.Allocations();
+                    if (selected)
+                        break;
+                    ++fallbacks;
+                }
+                if (iteration == 0)
+                    kept.swap(grants);
+                ++ops;
+            }
+            std::ostringstream selected;
+            selected << "select " << profile.name << " " << uint32(level);
+            for (AbGrant const& grant : kept)
+                selected << " " << grant.item_id << ":" << grant.ench_id;
+            golden.push_back(selected.str());
+        }
+    }
+    Report("Select", ops, rankTime + selectTime, rankAllocations + selectAllocations);
+    Report("AbRankCandidates", ops, rankTime, rankAllocations);
+    Report("AbSelectFromRanked", ops, selectTime, selectAllocations);
+    printf("autobis_bench: %u of %llu selections needed a complete ranking (depth %u)\n", fallbacks,
+           (unsigned long long)ops, AB_RANK_DEPTH);
+
+    // Golden results:
+    if (updateGolden) {
+        if (!AbWriteLines(goldenPath, golden)) {
+            fprintf(stderr, "autobis_bench: couldn't write %s\n", goldenPath.c_str());
+            return 1;
+        }
+        printf("autobis_bench: wrote %u golden results to %s.\n", uint32(golden.size()), goldenPath.c_str());
+        return 0;
+    }
+    std::vector<std::string> expected;
+    if (!AbReadLines(goldenPath, expected) || expected.empty()) {
+        fprintf(stderr, "autobis_bench: no golden results in %s (use --update-golden to write them)\n",
+                goldenPath.c_str());
+        return 1;
+    }
+    uint32 mismatches = 0;
+    for (uint32 idx = 0; idx < std::max(golden.size(), expected.size()); ++idx) {
+        std::string const got = idx < golden.size() ? golden[idx] : "(missing)";
+        std::string const want = idx < expected.size() ? expected[idx] : "(missing)";
+        if (got == want)
+            continue;
+        if (++mismatches <= 5)
+            fprintf(stderr, "autobis_bench: golden mismatch: expected \"%s\"; got \"%s\"\n", want.c_str(),
+                    got.c_str());
+    }
+    printf("autobis_bench: %u golden results checked, %u mismatches.\n", uint32(golden.size()), mismatches);
+    return mismatches ? 1 : 0;
+}
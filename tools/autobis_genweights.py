@@ -0,0 +1,317 @@
+#!/usr/bin/env python3
+#
+# Turns a Pawn Wowhead.lua (by default tools/Wowhead.lua) into autobis_weights.h: the built-in weight tables as
+#  constexpr, dense, pre-normalized AbWeightProfiles, so the server has nothing to parse or compile at startup.
+#
+# Usage: tools/autobis_genweights.py [Wowhead.lua] [autobis_weights.h]
+#
+# Only the scales listed in ROLES below become built-in tables; the others are reported and skipped (they can still be
+#  loaded at runtime, see AutoBis.Profiles.Path). Appending to ROLES is fine; reordering it changes profile ids.
+
+import os
+import re
+import sys
+
+# Pawn scale name, AbProfileId suffix, AutoBis name:
+ROLES = [
+    ("PaladinRetribution",      "RET_PALADIN",          "ret_paladin"),
+    ("PaladinProtection",       "PROT_PALADIN",         "prot_paladin"),
+    ("WarriorFury",             "FURY_WARRIOR",         "fury_warrior"),
+    ("RogueCombat",             "COMBAT_ROGUE",         "combat_rogue"),
+    ("MageFrost",               "FROST_MAGE",           "frost_mage"),
+    ("HunterBeastMastery",      "BM_HUNTER",            "bm_hunter"),
+    ("DruidBalance",            "BOOMKIN",              "boomkin"),
+    ("DruidFeralDps",           "CAT_DRUID",            "cat_druid"),
+    ("ShamanEnhancement",       "ENH_SHAMAN",           "enh_shaman"),
+    ("PriestShadow",            "SHADOW_PRIEST",        "shadow_priest"),
+    ("WarlockAffliction",       "AFFLICTION_WARLOCK",   "affliction_warlock"),
+    ("WarlockDestruction",      "DESTRO_WARLOCK",       "destro_warlock"),
+    ("DeathKnightFrostDps",     "FROST_DK",             "frost_dk"),
+    ("DeathKnightUnholyDps",    "UNHOLY_DK",            "unholy_dk"),
+    ("DeathKnightBloodTank",    "BLOOD_DK",             "blood_dk"),
+    ("WarriorProtection",       "PROT_WARRIOR",         "prot_warrior"),
+    ("DruidFeralTank",          "BEAR_DRUID",           "bear_druid"),
+    ("PaladinHoly",             "HOLY_PALADIN",         "holy_paladin"),
+    ("PriestDiscipline",        "DISC_PRIEST",          "disc_priest"),
+    ("PriestHoly",              "HOLY_PRIEST",          "holy_priest"),
+    ("ShamanElemental",         "ELE_SHAMAN",           "ele_shaman"),
+    ("ShamanRestoration",       "RESTO_SHAMAN",         "resto_shaman"),
+    ("DruidRestoration",        "RESTO_DRUID",          "resto_druid"),
+]
+
+# Pawn stat name -> (ScoreWeightMap key, its name in C++). Keep in sync with abPawnStats (autobis_pawn.cpp):
+STATS = {
+    "Strength":         (4,  "ITEM_MOD_STRENGTH"),
+    "Agility":          (3,  "ITEM_MOD_AGILITY"),
+    "Stamina":          (7,  "ITEM_MOD_STAMINA"),
+    "Intellect":        (5,  "ITEM_MOD_INTELLECT"),
+    "Spirit":           (6,  "ITEM_MOD_SPIRIT"),
+    "HitRating":        (31, "ITEM_MOD_HIT_RATING"),
+    "CritRating":       (32, "ITEM_MOD_CRIT_RATING"),
+    "HasteRating":      (36, "ITEM_MOD_HASTE_RATING"),
+    "ExpertiseRating":  (37, "ITEM_MOD_EXPERTISE_RATING"),
+    "ArmorPenetration": (44, "ITEM_MOD_ARMOR_PENETRATION_RATING"),
+    "Ap":               (38, "ITEM_MOD_ATTACK_POWER"),
+    "Rap":              (39, "ITEM_MOD_RANGED_ATTACK_POWER"),
+    "FeralAp":          (40, "ITEM_MOD_FERAL_ATTACK_POWER"),
+    "SpellPower":       (45, "ITEM_MOD_SPELL_POWER"),
+    "SpellPenetration": (47, "ITEM_MOD_SPELL_PENETRATION"),
+    "Mp5":              (43, "ITEM_MOD_MANA_REGENERATION"),
+    "Hp5":              (46, "ITEM_MOD_HEALTH_REGEN"),
+    "DefenseRating":    (12, "ITEM_MOD_DEFENSE_SKILL_RATING"),
+    "DodgeRating":      (13, "ITEM_MOD_DODGE_RATING"),
+    "ParryRating":      (14, "ITEM_MOD_PARRY_RATING"),
+    "BlockRating":      (15, "ITEM_MOD_BLOCK_RATING"),
+    "BlockValue":       (48, "ITEM_MOD_BLOCK_VALUE"),
+    "ResilienceRating": (35, "ITEM_MOD_RESILIENCE_RATING"),
+    "Dps":              (-1, "-1"),
+    "MeleeDps":         (-1, "-1"),
+    "Armor":            (-2, "-2"),
+    "RangedDps":        (-3, "-3"),
+}
+PSEUDO_STATS = {-1: "melee_DPS", -2: "armor", -3: "ranged_DPS"}
+
+TOKEN = re.compile(r"""
+    (?P<space>\s+)
+  | (?P<comment>--\[(?P<ceq>=*)\[.*?\](?P=ceq)\]|--[^\n]*)
+  | (?P<longstr>\[(?P<seq>=*)\[(?P<lbody>.*?)\](?P=seq)\])
+  | (?P<string>"(?:[^"\\\n]|\\.)*"|'(?:[^'\\\n]|\\.)*')
+  | (?P<number>(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?)
+  | (?P<name>[A-Za-z_][A-Za-z0-9_.:]*)
+  | (?P<symbol>.)
+""", re.VERBOSE | re.DOTALL)
+
+
+class ParseError(Exception):
+    pass
+
+
+def tokenize(text):
+    tokens = []
+    line = 1
+    pos = 0
+    while pos < len(text):
+        match = TOKEN.match(text, pos)
+        kind = match.lastgroup
+        value = match.group(0)
+        if kind == "string":
+            tokens.append(("string", value[1:-1], line))
+        elif kind == "longstr":
+            tokens.append(("string", match.group("lbody"), line))
+        elif kind == "number":
+            tokens.append(("number", float(value), line))
+        elif kind in ("name", "symbol"):
+            tokens.append((kind, value, line))
+        line += value.count("\n")
+        pos = match.end()
+    tokens.append(("end", None, line))
+    return tokens
+
+
+class Parser:
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+
+    def peek(self):
+        return self.tokens[self.pos]
+
+    def is_symbol(self, symbol):
+        kind, value, _ = self.peek()
+        return kind == "symbol" and value == symbol
+
+    def fail(self, message):
+        raise ParseError("line %d: %s" % (self.peek()[2], message))
+
+    def expect(self, symbol):
+        if not self.is_symbol(symbol):
+            self.fail("expected '%s'" % symbol)
+        self.pos += 1
+
+    # Returns ("table", {name: number}) or (kind, value):
+    def value(self):
+        if self.is_symbol("{"):
+            return self.table()
+        negative = self.is_symbol("-")
+        if negative:
+            self.pos += 1
+        kind, value, _ = self.peek()
+        if kind == "number":
+            self.pos += 1
+            return ("number", -value if negative else value)
+        if negative or kind not in ("string", "name"):
+            self.fail("unexpected %s" % (value if value is not None else "end of file"))
+        self.pos += 1
+        if kind == "name" and self.is_symbol("("):
+            self.arguments()
+        return (kind, value)
+
+    def table(self):
+        fields = {}
+        self.expect("{")
+        while not self.is_symbol("}"):
+            key = None
+            if self.is_symbol("["):
+                self.pos += 1
+                key = self.value()[1]
+                self.expect("]")
+                self.expect("=")
+            elif self.peek()[0] == "name" and self.tokens[self.pos + 1][:2] == ("symbol", "="):
+                key = self.peek()[1]
+                self.pos += 2
+            kind, value = self.value()
+            if key is not None and kind == "number":
+                fields[key] = value
+            if self.is_symbol(",") or self.is_symbol(";"):
+                self.pos += 1
+            elif not self.is_symbol("}"):
+                self.fail("expected ',' or '}' in table")
+        self.pos += 1
+        return ("table", fields)
+
+    def arguments(self):
+        args = []
+        self.expect("(")
+        while not self.is_symbol(")"):
+            args.append(self.value())
+            if self.is_symbol(","):
+                self.pos += 1
+            elif not self.is_symbol(")"):
+                self.fail("expected ',' or ')' in argument list")
+        self.pos += 1
+        return args
+
+    # [(line, name, {pawn stat: weight})] for every PawnAddPluginScale*() call:
+    def scales(self):
+        found = []
+        while self.peek()[0] != "end":
+            kind, value, line = self.peek()
+            self.pos += 1
+            if kind != "name" or not value.startswith("PawnAddPluginScale") or not self.is_symbol("("):
+                continue
+            args = self.arguments()
+            name = next((arg[1] for arg in args if arg[0] == "string"), None)
+            weights = next((arg[1] for arg in args if arg[0] == "table" and arg[1]), None)
+            if name is None or weights is None:
+                raise ParseError("line %d: scale without a name or without weights" % line)
+            found.append((line, name, weights))
+        return found
+
+
+# Same as AbCompileWeightProfile(): the total is summed in ScoreWeightMap (i.e. key) order, so the results are
+#  bit for bit the ones the hand-written tables compiled to:
+def normalize(weights):
+    by_key = {}
+    for stat, weight in weights.items():
+        if stat not in STATS:
+            continue
+        if weight <= 0:
+            continue
+        key = STATS[stat][0]
+        by_key[key] = max(by_key.get(key, 0.0), weight)
+    total = 0.0
+    for key in sorted(by_key):
+        total += by_key[key]
+    return [(key, by_key[key] / total) for key in sorted(by_key)]
+
+
+def key_name(key):
+    for _, (stat_key, name) in STATS.items():
+        if stat_key == key:
+            return name
+    raise KeyError(key)
+
+
+def generate(scales, source):
+    out = []
+    out.append("// Generated by tools/autobis_genweights.py from %s; don't edit, rerun the script instead." % source)
+    out.append("#ifndef __AUTOBIS_WEIGHTS_H__")
+    out.append("#define __AUTOBIS_WEIGHTS_H__")
+    out.append("")
+    out.append("#include <initializer_list>")
+    out.append("")
+    out.append("#include \"autobis_score.h\"")
+    out.append("")
+    out.append("// The built-in weight tables, in the same order as abWeightProfiles:")
+    out.append("enum AbProfileId : uint32 {")
+    for _, role, _ in ROLES:
+        out.append("    AB_PROFILE_%s," % role)
+    out.append("    MAX_AB_PROFILES")
+    out.append("};")
+    out.append("")
+    out.append("struct AbGeneratedWeight {")
+    out.append("    int32 stat;     // ScoreWeightMap key")
+    out.append("    double weight;  // already divided by the total weight")
+    out.append("};")
+    out.append("")
+    out.append("constexpr AbWeightProfile AbGeneratedProfile(uint32 id, char const* name,")
+    out.append("                                             std::initializer_list<AbGeneratedWeight> weights)")
+    out.append("{")
+    out.append("    AbWeightProfile profile;")
+    out.append("    profile.id = id;")
+    out.append("    profile.name = name;")
+    out.append("    for (AbGeneratedWeight const& entry : weights) {")
+    out.append("        if (entry.stat == -1)")
+    out.append("            profile.melee_dps = entry.weight;")
+    out.append("        else if (entry.stat == -2)")
+    out.append("            profile.armor = entry.weight;")
+    out.append("        else if (entry.stat == -3)")
+    out.append("            profile.ranged_dps = entry.weight;")
+    out.append("        else")
+    out.append("            profile.stats[entry.stat] = entry.weight;")
+    out.append("    }")
+    out.append("    return profile;")
+    out.append("}")
+    out.append("")
+    out.append("static constexpr AbWeightProfile abWeightProfiles[MAX_AB_PROFILES] = {")
+    for pawn_name, role, name in ROLES:
+        out.append("    // %s:" % pawn_name)
+        out.append("    AbGeneratedProfile(AB_PROFILE_%s, \"%s\", {" % (role, name))
+        for key, weight in normalize(scales[pawn_name]):
+            comment = ("  // " + PSEUDO_STATS[key]) if key in PSEUDO_STATS else ""
+            out.append("        { %s, %r },%s" % (key_name(key), weight, comment))
+        out.append("    }),")
+    out.append("};")
+    out.append("")
+    out.append("// Pawn scale name of each table (what replaces it when AutoBis.Profiles.Path is set):")
+    out.append("static constexpr char const* abRoleScaleNames[MAX_AB_PROFILES] = {")
+    for pawn_name, _, _ in ROLES:
+        out.append("    \"%s\"," % pawn_name)
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    source = sys.argv[1] if len(sys.argv) > 1 else os.path.join(root, "tools", "Wowhead.lua")
+    target = sys.argv[2] if len(sys.argv) > 2 else os.path.join(root, "autobis_weights.h")
+    with open(source) as file:
+        text = file.read()
+    try:
+        found = Parser(tokenize(text)).scales()
+    except ParseError as error:
+        sys.exit("%s: %s" % (source, error))
+    scales = {}
+    for line, name, weights in found:
+        if name in scales:
+            sys.exit("%s: line %d: scale \"%s\" is defined twice" % (source, line, name))
+        scales[name] = weights
+    missing = [pawn_name for pawn_name, _, _ in ROLES if pawn_name not in scales]
+    if missing:
+        sys.exit("%s: missing scales: %s" % (source, ", ".join(missing)))
+    for pawn_name, weights in scales.items():
+        if not normalize(weights):
+            sys.exit("%s: scale \"%s\" has no usable weights" % (source, pawn_name))
+    skipped = sorted(set(scales) - set(pawn_name for pawn_name, _, _ in ROLES))
+    if skipped:
+        print("skipped scales without a built-in table: %s" % ", ".join(skipped))
+    relative = os.path.relpath(source, root).replace(os.sep, "/")
+    with open(target, "w") as file:
+        file.write(generate(scales, relative))
+    print("wrote %d weight tables to %s" % (len(ROLES), target))
+
+
+if __name__ == "__main__":
+    main()
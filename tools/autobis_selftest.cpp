@@ -0,0 +1,329 @@
+//
+// Checks of the scoring core that need neither a server nor a database; run by ctest:
+//
+//   autobis_selftest
+//
+// Prints every mismatch, and exits 1 if there was any.
+//
+#include "autobis_score.h"
+#include "autobis_weights.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+// No equip spells and no random enchants: the checks below are about what the item template itself is worth.
+class AbSelfTestScoreData : public AbScoreData {
+    public:
+        void GetEquipSpellStats(uint32, Stat const*& first, Stat const*& last) const override
+        {
+            first = last = nullptr;
+        }
+        std::vector<uint32> const* GetEnchantPool(uint32) const override { return nullptr; }
+        bool GetRandomEnchant(uint32, bool, RandomEnchant &) const override { return false; }
+        uint32 GetSuffixFactor(ItemTemplate const*) const override { return 0; }
+};
+
+static bool SameScore(double expected, double got)
+{
+    return std::fabs(expected - got) <= 1e-9 * std::max(1.0, std::fabs(expected));
+}
+
+//
+// Weapon scores. ComputePawnScore() used to query "SELECT dmg_min1, dmg_max1 FROM item_template" for every item it
+//  scored; the DPS now comes from ItemTemplate::Damage[0]. The rows below are weapons as item_template stores them,
+//  and OldScore() is the base score the way the query-based ComputePawnScore() worked it out from them.
+struct AbWeaponRow {
+    uint32 subclass;
+    uint32 inventory_type;
+    float dmg_min1;
+    float dmg_max1;
+    uint32 delay;
+    uint32 armor;
+    uint32 stat;
+    int32 stat_value;
+};
+
+static const AbWeaponRow abWeaponRows[] = {
+    { ITEM_SUBCLASS_WEAPON_SWORD,       INVTYPE_WEAPON,         2.0f,    5.0f,    2000, 0,   ITEM_MOD_STAMINA,     1 },
+    { ITEM_SUBCLASS_WEAPON_DAGGER,      INVTYPE_WEAPON,         37.3f,   70.1f,   1800, 0,   ITEM_MOD_AGILITY,     12 },
+    { ITEM_SUBCLASS_WEAPON_STAFF,       INVTYPE_2HWEAPON,       300.0f,  450.0f,  3000, 0,   ITEM_MOD_INTELLECT,   40 },
+    { ITEM_SUBCLASS_WEAPON_MACE2,       INVTYPE_2HWEAPON,       1121.7f, 1683.3f, 3600, 0,   ITEM_MOD_STRENGTH,    96 },
+    { ITEM_SUBCLASS_WEAPON_AXE,         INVTYPE_WEAPONMAINHAND, 483.0f,  898.0f,  2600, 0,   ITEM_MOD_HIT_RATING,  31 },
+    { ITEM_SUBCLASS_WEAPON_FIST_WEAPON, INVTYPE_WEAPONOFFHAND,  151.5f,  282.5f,  1500, 0,   ITEM_MOD_CRIT_RATING, 20 },
+    { ITEM_SUBCLASS_WEAPON_BOW,         INVTYPE_RANGED,         100.0f,  200.0f,  3000, 0,   ITEM_MOD_AGILITY,     25 },
+    { ITEM_SUBCLASS_WEAPON_THROWN,      INVTYPE_THROWN,         61.0f,   92.0f,   1900, 0,   ITEM_MOD_STAMINA,     7 },
+    { ITEM_SUBCLASS_WEAPON_WAND,        INVTYPE_RANGEDRIGHT,    211.6f,  393.4f,  1700, 0,   ITEM_MOD_SPELL_POWER, 22 },
+    { ITEM_SUBCLASS_WEAPON_POLEARM,     INVTYPE_2HWEAPON,       0.0f,    0.0f,    3500, 120, ITEM_MOD_STAMINA,     -5 },
+};
+
+static double OldScore(AbScoreWeightMap const& score_weights, AbWeaponRow const& row)
+{
+    double dmg_min1 = row.dmg_min1;
+    double dmg_max1 = row.dmg_max1;
+    double totalScore = 0.0, totalWeight = 0.0;
+    for (auto entry : score_weights)
+        totalWeight += entry.second;
+    double dps = 1000 * (dmg_min1 + dmg_max1) / 2 / row.delay;
+    uint32 invtype = row.inventory_type;
+    if (invtype == INVTYPE_RANGED || invtype == INVTYPE_THROWN || invtype == INVTYPE_RANGEDRIGHT) {
+        if (dps > 0 && score_weights.find(-3) != score_weights.end())
+            totalScore += dps * score_weights.at(-3) / totalWeight;
+    } else {
+        if (dps > 0 && score_weights.find(-1) != score_weights.end())
+            totalScore += dps * score_weights.at(-1) / totalWeight;
+    }
+    if (row.armor > 0 && score_weights.find(-2) != score_weights.end())
+        totalScore += row.armor * score_weights.at(-2) / totalWeight;
+    auto fiter = score_weights.find(row.stat);
+    if (row.stat_value > 0 && fiter != score_weights.end())
+        totalScore += row.stat_value * fiter->second / totalWeight;
+    return totalScore;
+}
+
+// The built-in tables as a ScoreWeightMap, the way the old code held them:
+static AbScoreWeightMap WeightsOf(AbWeightProfile const& profile)
+{
+    AbScoreWeightMap weights;
+    if (profile.melee_dps)
+        weights[-1] = profile.melee_dps;
+    if (profile.armor)
+        weights[-2] = profile.armor;
+    if (profile.ranged_dps)
+        weights[-3] = profile.ranged_dps;
+    for (uint32 stat = 0; stat < AbWeightProfile::MAX_STATS; ++stat) {
+        if (profile.stats[stat])
+            weights[stat] = profile.stats[stat];
+    }
+    return weights;
+}
+
+static uint32 CheckWeaponScores()
+{
+    std::vector<AbScoreWeightMap> tables;
+    for (AbWeightProfile const& profile : abWeightProfiles)
+        tables.push_back(WeightsOf(profile));
+    // Pawn's FeralAp: no item carries it, so it must not change what a weapon is worth:
+    tables.push_back(AbScoreWeightMap{ { -1, 3.0 }, { ITEM_MOD_AGILITY, 1.0 }, { ITEM_MOD_FERAL_ATTACK_POWER, 0.4 } });
+    AbSelfTestScoreData data;
+    uint32 checked = 0, mismatches = 0;
+    for (uint32 table = 0; table < tables.size(); ++table) {
+        AbWeightProfile profile = AbCompileWeightProfile(tables[table], table, "selftest");
+        for (AbWeaponRow const& row : abWeaponRows) {
+            ItemTemplate itemTemplate;
+            itemTemplate.Class = ITEM_CLASS_WEAPON;
+            itemTemplate.SubClass = row.subclass;
+            itemTemplate.InventoryType = row.inventory_type;
+            itemTemplate.Damage[0].DamageMin = row.dmg_min1;
+            itemTemplate.Damage[0].DamageMax = row.dmg_max1;
+            itemTemplate.Delay = row.delay;
+            itemTemplate.Armor = row.armor;
+            itemTemplate.StatsCount = 1;
+            itemTemplate.ItemStat[0].ItemStatType = row.stat;
+            itemTemplate.ItemStat[0].ItemStatValue = row.stat_value;
+            double expected = OldScore(tables[table], row);
+            double got = AbBaseScore(data, profile, &itemTemplate);
+            if (!SameScore(expected, got)) {
+                printf("autobis_selftest: weight table %u, weapon %.1f-%.1f (delay %u): expected score == %.12g; "
+                       "got: %.12g\n", table, row.dmg_min1, row.dmg_max1, row.delay, expected, got);
+                ++mismatches;
+            }
+            ++checked;
+        }
+    }
+    printf("autobis_selftest: weapon scores: %u checked, %u mismatches.\n", checked, mismatches);
+    return mismatches;
+}
+
+//
+// Generated weight tables. The built-in ones are generated from tools/Wowhead.lua (see autobis_weights.h); these are
+//  the original hand-written ones, kept to check that the generated tables still match them.
+//
+// https://github.com/Road-block/Pawn/blob/master/Wowhead.lua
+//  I subtract 20 from HIT_RATING because we tend to get flooded with hit rating, overcapping the 8% limit...
+static const AbScoreWeightMap ret_paladin_map = {
+    {-1, 470}, // melee_DPS
+    {ITEM_MOD_HIT_RATING, 70},
+    {ITEM_MOD_STRENGTH, 80},
+    {ITEM_MOD_EXPERTISE_RATING, 66},
+    {ITEM_MOD_CRIT_RATING, 40},
+    {ITEM_MOD_ATTACK_POWER, 34},
+    {ITEM_MOD_AGILITY, 32},
+    {ITEM_MOD_HASTE_RATING, 30},
+    {ITEM_MOD_ARMOR_PENETRATION_RATING, 22},
+    {ITEM_MOD_SPELL_POWER, 9},
+    {ITEM_MOD_STAMINA, 0.1},
+    {-2, 0.01}, // armor
+    {-3, 0.0001}, // ranged_DPS
+};
+
+static const AbScoreWeightMap prot_paladin_map = {
+    {ITEM_MOD_STAMINA, 100},
+    {ITEM_MOD_AGILITY, 60},
+    {ITEM_MOD_EXPERTISE_RATING, 59},
+    {ITEM_MOD_DODGE_RATING, 55},
+    {ITEM_MOD_DEFENSE_SKILL_RATING, 45},
+    {ITEM_MOD_PARRY_RATING, 30},
+    {ITEM_MOD_STRENGTH, 16},
+    {-2, 8}, // armor
+    {ITEM_MOD_BLOCK_RATING, 7},
+    {ITEM_MOD_BLOCK_VALUE, 6},
+    {-1, 0.00001}, // melee_DPS
+};
+
+static const AbScoreWeightMap fury_warrior_map = {
+    {ITEM_MOD_EXPERTISE_RATING, 100},
+    {ITEM_MOD_STRENGTH, 82},
+    {ITEM_MOD_CRIT_RATING, 66},
+    {ITEM_MOD_AGILITY, 53},
+    {ITEM_MOD_ARMOR_PENETRATION_RATING, 52},
+    {ITEM_MOD_HIT_RATING, 48},
+    {ITEM_MOD_HASTE_RATING, 36},
+    {ITEM_MOD_ATTACK_POWER, 31},
+    {-2, 5}, // armor
+    {ITEM_MOD_STAMINA, 0.1},
+    {-1, 0.01}, // melee_DPS
+    {-3, 0.0001}, // ranged_DPS
+};
+
+static const AbScoreWeightMap combat_rogue_map = {
+    {-1, 220}, // melee_DPS
+    {ITEM_MOD_ARMOR_PENETRATION_RATING, 100},
+    {ITEM_MOD_AGILITY, 100},
+    {ITEM_MOD_EXPERTISE_RATING, 82},
+    {ITEM_MOD_HIT_RATING, 80},
+    {ITEM_MOD_CRIT_RATING, 75},
+    {ITEM_MOD_HASTE_RATING, 73},
+    {ITEM_MOD_STRENGTH, 55},
+    {ITEM_MOD_ATTACK_POWER, 50},
+    {ITEM_MOD_STAMINA, 0.1},
+    {-2, 0.01}, // armor
+    {-3, 0.0001}, // ranged_DPS
+};
+
+static const AbScoreWeightMap frost_mage_map = {
+    {ITEM_MOD_HIT_RATING, 80},
+    {ITEM_MOD_HASTE_RATING, 42},
+    {ITEM_MOD_SPELL_POWER, 39},
+    {ITEM_MOD_CRIT_RATING, 19},
+    {ITEM_MOD_INTELLECT, 6},
+    {ITEM_MOD_STAMINA, 0.1},
+    {-1, 0.0001}, // melee_DPS
+    {-2, 0.0001}, // armor
+    {-3, 0.0001}, // ranged_DPS
+};
+
+static const AbScoreWeightMap bm_hunter_map = {
+    {-3, 213}, // ranged_DPS
+    {ITEM_MOD_HIT_RATING, 80},
+    {ITEM_MOD_AGILITY, 58},
+    {ITEM_MOD_CRIT_RATING, 40},
+    {ITEM_MOD_INTELLECT, 37},
+    {ITEM_MOD_ATTACK_POWER, 30},
+    {ITEM_MOD_ARMOR_PENETRATION_RATING, 28},
+    {ITEM_MOD_HASTE_RATING, 21},
+    {ITEM_MOD_STAMINA, 0.1},
+    {-1, 0.0001}, // melee_DPS
+    {-2, 0.0001}, // armor
+};
+
+static const AbScoreWeightMap boomkin_map = {
+    {ITEM_MOD_HIT_RATING, 80},
+    {ITEM_MOD_SPELL_POWER, 66},
+    {ITEM_MOD_HASTE_RATING, 54},
+    {ITEM_MOD_CRIT_RATING, 43},
+    {ITEM_MOD_SPIRIT, 22},
+    {ITEM_MOD_INTELLECT, 22},
+    {ITEM_MOD_STAMINA, 0.1},
+    {-1, 0.0001}, // melee_DPS
+    {-2, 0.0001}, // armor
+    {-3, 0.0001}, // ranged_DPS
+};
+
+static const AbScoreWeightMap cat_druid_map = {
+    {ITEM_MOD_AGILITY, 100},
+    {ITEM_MOD_ARMOR_PENETRATION_RATING, 90},
+    {ITEM_MOD_STRENGTH, 80},
+    {ITEM_MOD_CRIT_RATING, 55},
+    {ITEM_MOD_EXPERTISE_RATING, 50},
+    {ITEM_MOD_HIT_RATING, 50},
+    {ITEM_MOD_ATTACK_POWER, 40},
+    {ITEM_MOD_HASTE_RATING, 35},
+    {ITEM_MOD_STAMINA, 0.1},
+    {-1, 0.01}, // melee_DPS
+    {-2, 0.0001}, // armor
+    {-3, 0.0001}, // ranged_DPS
+};
+
+static const AbScoreWeightMap enh_shaman_map = {
+    {-1, 135}, // melee_DPS
+    {ITEM_MOD_HIT_RATING, 70},
+    {ITEM_MOD_EXPERTISE_RATING, 84},
+    {ITEM_MOD_AGILITY, 55},
+    {ITEM_MOD_INTELLECT, 55},
+    {ITEM_MOD_CRIT_RATING, 55},
+    {ITEM_MOD_HASTE_RATING, 42},
+    {ITEM_MOD_STRENGTH, 35},
+    {ITEM_MOD_ATTACK_POWER, 32},
+    {ITEM_MOD_SPELL_POWER, 29},
+    {ITEM_MOD_ARMOR_PENETRATION_RATING, 26},
+    {ITEM_MOD_STAMINA, 0.1},
+    {-2, 0.01}, // armor
+    {-3, 0.0001}, // ranged_DPS
+};
+
+static const AbScoreWeightMap shadow_priest_map = {
+    {ITEM_MOD_HIT_RATING, 80},
+    {ITEM_MOD_SPELL_POWER, 76},
+    {ITEM_MOD_CRIT_RATING, 54},
+    {ITEM_MOD_HASTE_RATING, 50},
+    {ITEM_MOD_SPIRIT, 16},
+    {ITEM_MOD_INTELLECT, 16},
+    {ITEM_MOD_STAMINA, 0.1},
+    {-1, 0.0001}, // melee_DPS
+    {-2, 0.0001}, // armor
+    {-3, 0.0001}, // ranged_DPS
+};
+
+static uint32 CheckGeneratedWeights()
+{
+    static const std::pair<AbScoreWeightMap const*, AbProfileId> handWritten[] = {
+        { &ret_paladin_map,     AB_PROFILE_RET_PALADIN },
+        { &prot_paladin_map,    AB_PROFILE_PROT_PALADIN },
+        { &fury_warrior_map,    AB_PROFILE_FURY_WARRIOR },
+        { &combat_rogue_map,    AB_PROFILE_COMBAT_ROGUE },
+        { &frost_mage_map,      AB_PROFILE_FROST_MAGE },
+        { &bm_hunter_map,       AB_PROFILE_BM_HUNTER },
+        { &boomkin_map,         AB_PROFILE_BOOMKIN },
+        { &cat_druid_map,       AB_PROFILE_CAT_DRUID },
+        { &enh_shaman_map,      AB_PROFILE_ENH_SHAMAN },
+        { &shadow_priest_map,   AB_PROFILE_SHADOW_PRIEST },
+    };
+    uint32 mismatches = 0;
+    for (auto const& itr : handWritten) {
+        AbWeightProfile const& generated = abWeightProfiles[itr.second];
+        AbWeightProfile expected = AbCompileWeightProfile(*itr.first, itr.second, generated.name);
+        bool same = expected.melee_dps == generated.melee_dps && expected.armor == generated.armor
+                    && expected.ranged_dps == generated.ranged_dps;
+        for (uint32 stat = 0; stat < AbWeightProfile::MAX_STATS; ++stat)
+            same = same && expected.stats[stat] == generated.stats[stat];
+        if (!same) {
+            printf("autobis_selftest: %s: the generated weight table doesn't match the hand-written one.\n",
+                   generated.name);
+            ++mismatches;
+        }
+    }
+    printf("autobis_selftest: generated weight tables: %u checked, %u mismatches.\n",
+           uint32(sizeof(handWritten) / sizeof(handWritten[0])), mismatches);
+    return mismatches;
+}
+
+int main()
+{
+    uint32 mismatches = 0;
+    mismatches += CheckWeaponScores();
+    mismatches += CheckGeneratedWeights();
+    return mismatches ? 1 : 0;
+}
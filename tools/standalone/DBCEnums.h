@@ -0,0 +1,11 @@
+// Stand-in for TrinityCore's DBCEnums.h: the part the scoring core uses, with the same values.
+#ifndef __AUTOBIS_STANDALONE_DBCENUMS_H__
+#define __AUTOBIS_STANDALONE_DBCENUMS_H__
+
+enum LevelLimit {
+    DEFAULT_MAX_LEVEL = 80,
+    MAX_LEVEL = 100,
+    STRONG_MAX_LEVEL = 255,
+};
+
+#endif
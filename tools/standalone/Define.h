@@ -0,0 +1,16 @@
+// Stand-in for TrinityCore's Define.h, for building the scoring core without a server (see tools/CMakeLists.txt).
+#ifndef __AUTOBIS_STANDALONE_DEFINE_H__
+#define __AUTOBIS_STANDALONE_DEFINE_H__
+
+#include <cstdint>
+
+typedef std::int64_t int64;
+typedef std::int32_t int32;
+typedef std::int16_t int16;
+typedef std::int8_t int8;
+typedef std::uint64_t uint64;
+typedef std::uint32_t uint32;
+typedef std::uint16_t uint16;
+typedef std::uint8_t uint8;
+
+#endif
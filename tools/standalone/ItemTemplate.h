@@ -0,0 +1,192 @@
+// Stand-in for TrinityCore's ItemTemplate.h: the enums the scoring core uses, with the same values, and the fields of
+//  ItemTemplate it reads, with the same names and types.
+#ifndef __AUTOBIS_STANDALONE_ITEMTEMPLATE_H__
+#define __AUTOBIS_STANDALONE_ITEMTEMPLATE_H__
+
+#include <string>
+
+#include "Define.h"
+#include "SharedDefines.h"
+
+enum ItemModType {
+    ITEM_MOD_MANA = 0,
+    ITEM_MOD_HEALTH = 1,
+    ITEM_MOD_AGILITY = 3,
+    ITEM_MOD_STRENGTH = 4,
+    ITEM_MOD_INTELLECT = 5,
+    ITEM_MOD_SPIRIT = 6,
+    ITEM_MOD_STAMINA = 7,
+    ITEM_MOD_DEFENSE_SKILL_RATING = 12,
+    ITEM_MOD_DODGE_RATING = 13,
+    ITEM_MOD_PARRY_RATING = 14,
+    ITEM_MOD_BLOCK_RATING = 15,
+    ITEM_MOD_HIT_MELEE_RATING = 16,
+    ITEM_MOD_HIT_RANGED_RATING = 17,
+    ITEM_MOD_HIT_SPELL_RATING = 18,
+    ITEM_MOD_CRIT_MELEE_RATING = 19,
+    ITEM_MOD_CRIT_RANGED_RATING = 20,
+    ITEM_MOD_CRIT_SPELL_RATING = 21,
+    ITEM_MOD_HIT_TAKEN_MELEE_RATING = 22,
+    ITEM_MOD_HIT_TAKEN_RANGED_RATING = 23,
+    ITEM_MOD_HIT_TAKEN_SPELL_RATING = 24,
+    ITEM_MOD_CRIT_TAKEN_MELEE_RATING = 25,
+    ITEM_MOD_CRIT_TAKEN_RANGED_RATING = 26,
+    ITEM_MOD_CRIT_TAKEN_SPELL_RATING = 27,
+    ITEM_MOD_HASTE_MELEE_RATING = 28,
+    ITEM_MOD_HASTE_RANGED_RATING = 29,
+    ITEM_MOD_HASTE_SPELL_RATING = 30,
+    ITEM_MOD_HIT_RATING = 31,
+    ITEM_MOD_CRIT_RATING = 32,
+    ITEM_MOD_HIT_TAKEN_RATING = 33,
+    ITEM_MOD_CRIT_TAKEN_RATING = 34,
+    ITEM_MOD_RESILIENCE_RATING = 35,
+    ITEM_MOD_HASTE_RATING = 36,
+    ITEM_MOD_EXPERTISE_RATING = 37,
+    ITEM_MOD_ATTACK_POWER = 38,
+    ITEM_MOD_RANGED_ATTACK_POWER = 39,
+    ITEM_MOD_FERAL_ATTACK_POWER = 40,
+    ITEM_MOD_SPELL_HEALING_DONE = 41,
+    ITEM_MOD_SPELL_DAMAGE_DONE = 42,
+    ITEM_MOD_MANA_REGENERATION = 43,
+    ITEM_MOD_ARMOR_PENETRATION_RATING = 44,
+    ITEM_MOD_SPELL_POWER = 45,
+    ITEM_MOD_HEALTH_REGEN = 46,
+    ITEM_MOD_SPELL_PENETRATION = 47,
+    ITEM_MOD_BLOCK_VALUE = 48,
+};
+
+#define MAX_ITEM_MOD 49
+
+enum ItemSpelltriggerType {
+    ITEM_SPELLTRIGGER_ON_USE = 0,
+    ITEM_SPELLTRIGGER_ON_EQUIP = 1,
+    ITEM_SPELLTRIGGER_CHANCE_ON_HIT = 2,
+};
+
+enum InventoryType {
+    INVTYPE_NON_EQUIP = 0,
+    INVTYPE_HEAD = 1,
+    INVTYPE_NECK = 2,
+    INVTYPE_SHOULDERS = 3,
+    INVTYPE_BODY = 4,
+    INVTYPE_CHEST = 5,
+    INVTYPE_WAIST = 6,
+    INVTYPE_LEGS = 7,
+    INVTYPE_FEET = 8,
+    INVTYPE_WRISTS = 9,
+    INVTYPE_HANDS = 10,
+    INVTYPE_FINGER = 11,
+    INVTYPE_TRINKET = 12,
+    INVTYPE_WEAPON = 13,
+    INVTYPE_SHIELD = 14,
+    INVTYPE_RANGED = 15,
+    INVTYPE_CLOAK = 16,
+    INVTYPE_2HWEAPON = 17,
+    INVTYPE_BAG = 18,
+    INVTYPE_TABARD = 19,
+    INVTYPE_ROBE = 20,
+    INVTYPE_WEAPONMAINHAND = 21,
+    INVTYPE_WEAPONOFFHAND = 22,
+    INVTYPE_HOLDABLE = 23,
+    INVTYPE_AMMO = 24,
+    INVTYPE_THROWN = 25,
+    INVTYPE_RANGEDRIGHT = 26,
+    INVTYPE_QUIVER = 27,
+    INVTYPE_RELIC = 28,
+};
+
+#define MAX_INVTYPE 29
+
+enum ItemClass {
+    ITEM_CLASS_CONSUMABLE = 0,
+    ITEM_CLASS_CONTAINER = 1,
+    ITEM_CLASS_WEAPON = 2,
+    ITEM_CLASS_GEM = 3,
+    ITEM_CLASS_ARMOR = 4,
+};
+
+enum ItemSubclassWeapon {
+    ITEM_SUBCLASS_WEAPON_AXE = 0,
+    ITEM_SUBCLASS_WEAPON_AXE2 = 1,
+    ITEM_SUBCLASS_WEAPON_BOW = 2,
+    ITEM_SUBCLASS_WEAPON_GUN = 3,
+    ITEM_SUBCLASS_WEAPON_MACE = 4,
+    ITEM_SUBCLASS_WEAPON_MACE2 = 5,
+    ITEM_SUBCLASS_WEAPON_POLEARM = 6,
+    ITEM_SUBCLASS_WEAPON_SWORD = 7,
+    ITEM_SUBCLASS_WEAPON_SWORD2 = 8,
+    ITEM_SUBCLASS_WEAPON_obsolete = 9,
+    ITEM_SUBCLASS_WEAPON_STAFF = 10,
+    ITEM_SUBCLASS_WEAPON_EXOTIC = 11,
+    ITEM_SUBCLASS_WEAPON_EXOTIC2 = 12,
+    ITEM_SUBCLASS_WEAPON_FIST_WEAPON = 13,
+    ITEM_SUBCLASS_WEAPON_MISC = 14,
+    ITEM_SUBCLASS_WEAPON_DAGGER = 15,
+    ITEM_SUBCLASS_WEAPON_THROWN = 16,
+    ITEM_SUBCLASS_WEAPON_SPEAR = 17,
+    ITEM_SUBCLASS_WEAPON_CROSSBOW = 18,
+    ITEM_SUBCLASS_WEAPON_WAND = 19,
+    ITEM_SUBCLASS_WEAPON_FISHING_POLE = 20,
+};
+
+#define MAX_ITEM_SUBCLASS_WEAPON 21
+
+enum ItemSubclassArmor {
+    ITEM_SUBCLASS_ARMOR_MISC = 0,
+    ITEM_SUBCLASS_ARMOR_CLOTH = 1,
+    ITEM_SUBCLASS_ARMOR_LEATHER = 2,
+    ITEM_SUBCLASS_ARMOR_MAIL = 3,
+    ITEM_SUBCLASS_ARMOR_PLATE = 4,
+    ITEM_SUBCLASS_ARMOR_BUCKLER = 5,
+    ITEM_SUBCLASS_ARMOR_SHIELD = 6,
+    ITEM_SUBCLASS_ARMOR_LIBRAM = 7,
+    ITEM_SUBCLASS_ARMOR_IDOL = 8,
+    ITEM_SUBCLASS_ARMOR_TOTEM = 9,
+    ITEM_SUBCLASS_ARMOR_SIGIL = 10,
+};
+
+#define MAX_ITEM_PROTO_DAMAGES 2
+#define MAX_ITEM_PROTO_SPELLS  5
+#define MAX_ITEM_PROTO_STATS  10
+
+struct _Damage {
+    float DamageMin = 0.0f;
+    float DamageMax = 0.0f;
+    uint32 DamageType = 0;
+};
+
+struct _ItemStat {
+    uint32 ItemStatType = 0;
+    int32 ItemStatValue = 0;
+};
+
+struct _Spell {
+    int32 SpellId = 0;
+    uint32 SpellTrigger = 0;
+};
+
+struct ItemTemplate {
+    uint32 ItemId = 0;
+    uint32 Class = 0;
+    uint32 SubClass = 0;
+    std::string Name1;
+    uint32 Quality = 0;
+    uint32 Flags2 = 0;                  // FlagsExtra
+    uint32 SellPrice = 0;
+    uint32 InventoryType = 0;
+    int32 AllowableClass = -1;
+    uint32 ItemLevel = 0;
+    uint32 RequiredLevel = 0;
+    uint32 RequiredReputationFaction = 0;
+    uint32 StatsCount = 0;
+    _ItemStat ItemStat[MAX_ITEM_PROTO_STATS];
+    _Damage Damage[MAX_ITEM_PROTO_DAMAGES];
+    uint32 Armor = 0;
+    uint32 Block = 0;
+    uint32 Delay = 0;
+    _Spell Spells[MAX_ITEM_PROTO_SPELLS];
+    uint32 RandomProperty = 0;
+    uint32 RandomSuffix = 0;
+};
+
+#endif
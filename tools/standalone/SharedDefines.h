@@ -0,0 +1,56 @@
+// Stand-in for TrinityCore's SharedDefines.h: the part the scoring core uses, with the same values.
+#ifndef __AUTOBIS_STANDALONE_SHAREDDEFINES_H__
+#define __AUTOBIS_STANDALONE_SHAREDDEFINES_H__
+
+#include "Define.h"
+
+enum ItemQualities {
+    ITEM_QUALITY_POOR = 0,
+    ITEM_QUALITY_NORMAL = 1,
+    ITEM_QUALITY_UNCOMMON = 2,
+    ITEM_QUALITY_RARE = 3,
+    ITEM_QUALITY_EPIC = 4,
+    ITEM_QUALITY_LEGENDARY = 5,
+    ITEM_QUALITY_ARTIFACT = 6,
+    ITEM_QUALITY_HEIRLOOM = 7,
+};
+
+enum Classes {
+    CLASS_NONE = 0,
+    CLASS_WARRIOR = 1,
+    CLASS_PALADIN = 2,
+    CLASS_HUNTER = 3,
+    CLASS_ROGUE = 4,
+    CLASS_PRIEST = 5,
+    CLASS_DEATH_KNIGHT = 6,
+    CLASS_SHAMAN = 7,
+    CLASS_MAGE = 8,
+    CLASS_WARLOCK = 9,
+    CLASS_DRUID = 11,
+};
+
+#define MAX_CLASSES 12
+
+// Weapon skills only:
+enum SkillType {
+    SKILL_NONE = 0,
+    SKILL_SWORDS = 43,
+    SKILL_AXES = 44,
+    SKILL_BOWS = 45,
+    SKILL_GUNS = 46,
+    SKILL_MACES = 54,
+    SKILL_2H_SWORDS = 55,
+    SKILL_STAVES = 136,
+    SKILL_2H_MACES = 160,
+    SKILL_2H_AXES = 172,
+    SKILL_DAGGERS = 173,
+    SKILL_THROWN = 176,
+    SKILL_CROSSBOWS = 226,
+    SKILL_WANDS = 228,
+    SKILL_POLEARMS = 229,
+    SKILL_ASSASSINATION = 253,
+    SKILL_FISHING = 356,
+    SKILL_FIST_WEAPONS = 473,
+};
+
+#endif